@@ -0,0 +1,179 @@
+#include "addressmap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+MemoryCategory AddressColumn::dominant() const
+{
+    const auto largest = std::max_element(categoryBytes.begin(), categoryBytes.end());
+    return MemoryCategory(largest - categoryBytes.begin());
+}
+
+void AddressMap::build(pid_t pid, const std::vector<Vma>& vmas)
+{
+    m_pid = pid;
+    m_regions.clear();
+    m_regions.reserve(vmas.size());
+    m_paths.assign(1, std::string());
+
+    // Paths repeat across the mappings of one file, keyed by the caller's
+    // views which outlive this call
+    std::unordered_map<std::string_view, uint32_t> pathIndex;
+    for (const Vma& vma : vmas) {
+        if (vma.end <= vma.start) continue;
+
+        AddressRegion region;
+        region.start = vma.start;
+        region.end = vma.end;
+        region.residentBytes = vma.rssKB * 1024;
+        region.swapBytes = vma.swapKB * 1024;
+        region.category = MemoryAnalyzer::categorize(vma.path);
+        memcpy(region.perms, vma.perms, sizeof(region.perms));
+        if (!vma.path.empty()) {
+            auto it = pathIndex.find(vma.path);
+            if (it == pathIndex.end()) {
+                m_paths.emplace_back(vma.path);
+                it = pathIndex.emplace(vma.path, uint32_t(m_paths.size() - 1)).first;
+            }
+            region.path = it->second;
+        }
+        m_regions.push_back(region);
+    }
+    std::sort(m_regions.begin(), m_regions.end(),
+              [](const AddressRegion& a, const AddressRegion& b) { return a.start < b.start; });
+
+    m_prefixBytes.assign(m_regions.size() + 1, {});
+    m_prefixResident.assign(m_regions.size() + 1, 0);
+    for (size_t i = 0; i < m_regions.size(); ++i) {
+        m_prefixBytes[i + 1] = m_prefixBytes[i];
+        m_prefixBytes[i + 1][size_t(m_regions[i].category)] += m_regions[i].size();
+        m_prefixResident[i + 1] = m_prefixResident[i] + m_regions[i].residentBytes;
+    }
+
+    layout();
+}
+
+void AddressMap::setCompactGaps(bool compact)
+{
+    if (compact == m_compactGaps) return;
+    m_compactGaps = compact;
+    layout();
+}
+
+uint64_t AddressMap::mappedBytes() const
+{
+    if (m_prefixBytes.empty()) return 0;
+    uint64_t total = 0;
+    for (uint64_t bytes : m_prefixBytes.back()) total += bytes;
+    return total;
+}
+
+void AddressMap::layout()
+{
+    m_axisStart.resize(m_regions.size());
+    const double maxGap = m_regions.empty() ? 0 : std::max(4096.0, double(mappedBytes()) / double(m_regions.size()));
+
+    double axis = 0;
+    for (size_t i = 0; i < m_regions.size(); ++i) {
+        if (i > 0) {
+            const double gap = double(m_regions[i].start - m_regions[i - 1].end);
+            axis += m_compactGaps ? std::min(gap, maxGap) : gap;
+        }
+        m_axisStart[i] = axis;
+        axis += double(m_regions[i].size());
+    }
+    m_axisLength = axis;
+}
+
+double AddressMap::axisOf(uint64_t address) const
+{
+    auto it = std::upper_bound(m_regions.begin(), m_regions.end(), address,
+                               [](uint64_t a, const AddressRegion& r) { return a < r.start; });
+    if (it == m_regions.begin()) return 0;
+
+    const size_t i = size_t(it - m_regions.begin()) - 1;
+    const AddressRegion& r = m_regions[i];
+    if (address < r.end) return m_axisStart[i] + double(address - r.start);
+
+    const double end = m_axisStart[i] + double(r.size());
+    if (i + 1 == m_regions.size()) return end;
+
+    // Inside a gap, possibly drawn narrower than it is
+    const double fraction = double(address - r.end) / double(m_regions[i + 1].start - r.end);
+    return end + fraction * (m_axisStart[i + 1] - end);
+}
+
+uint64_t AddressMap::addressAt(double axis) const
+{
+    if (m_regions.empty()) return 0;
+
+    auto it = std::upper_bound(m_axisStart.begin(), m_axisStart.end(), axis);
+    if (it == m_axisStart.begin()) return m_regions.front().start;
+
+    const size_t i = size_t(it - m_axisStart.begin()) - 1;
+    const AddressRegion& r = m_regions[i];
+    const double end = m_axisStart[i] + double(r.size());
+    if (axis < end) return r.start + uint64_t(axis - m_axisStart[i]);
+    if (i + 1 == m_regions.size()) return r.end;
+
+    const double fraction = (axis - end) / (m_axisStart[i + 1] - end);
+    return r.end + uint64_t(fraction * double(m_regions[i + 1].start - r.end));
+}
+
+// First region whose axis span ends after the position
+size_t AddressMap::firstEndingAfter(double axis) const
+{
+    size_t k = size_t(std::upper_bound(m_axisStart.begin(), m_axisStart.end(), axis) - m_axisStart.begin());
+    if (k > 0 && m_axisStart[k - 1] + double(m_regions[k - 1].size()) > axis) --k;
+    return k;
+}
+
+const AddressRegion* AddressMap::regionAt(double axis) const
+{
+    const size_t k = firstEndingAfter(axis);
+    if (k < m_regions.size() && m_axisStart[k] <= axis) return &m_regions[k];
+    return nullptr;
+}
+
+void AddressMap::addClipped(size_t i, double from, double to, AddressColumn& column) const
+{
+    const AddressRegion& r = m_regions[i];
+    const double start = m_axisStart[i];
+    const double overlap = std::min(start + double(r.size()), to) - std::max(start, from);
+    if (overlap <= 0) return;
+
+    const uint64_t bytes = uint64_t(overlap);
+    column.categoryBytes[size_t(r.category)] += bytes;
+    column.mappedBytes += bytes;
+    column.residentBytes += uint64_t(double(r.residentBytes) * overlap / double(r.size()));
+}
+
+void AddressMap::columns(double from, double to, int count, std::vector<AddressColumn>& out) const
+{
+    out.assign(size_t(std::max(0, count)), AddressColumn());
+    if (count <= 0 || m_regions.empty()) return;
+
+    const double width = (to - from) / count;
+    for (int c = 0; c < count; ++c) {
+        const double columnFrom = from + c * width;
+        const double columnTo = columnFrom + width;
+        const size_t first = firstEndingAfter(columnFrom);
+        const size_t last = size_t(std::lower_bound(m_axisStart.begin(), m_axisStart.end(), columnTo) - m_axisStart.begin());
+        if (first >= last) continue;
+
+        AddressColumn& column = out[size_t(c)];
+        column.regions = uint32_t(last - first);
+        addClipped(first, columnFrom, columnTo, column);
+        if (last - first == 1) continue;
+        addClipped(last - 1, columnFrom, columnTo, column);
+
+        // Regions strictly inside the column come from the prefix sums
+        for (size_t k = 0; k < 4; ++k) {
+            const uint64_t bytes = m_prefixBytes[last - 1][k] - m_prefixBytes[first + 1][k];
+            column.categoryBytes[k] += bytes;
+            column.mappedBytes += bytes;
+        }
+        column.residentBytes += m_prefixResident[last - 1] - m_prefixResident[first + 1];
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef ADDRESSMAP_H
+#define ADDRESSMAP_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "memoryanalyzer.h"
+#include "smaps.h"
+
+// One mapping as drawn, sizes in bytes
+struct AddressRegion {
+    uint64_t start = 0;
+    uint64_t end = 0;
+    uint64_t residentBytes = 0;
+    uint64_t swapBytes = 0;
+    MemoryCategory category = MemoryCategory::Private;
+    char perms[5] = {0};
+    uint32_t path = 0;          // Index into the map's paths, 0 is anonymous
+
+    uint64_t size() const { return end - start; }
+};
+
+// What falls into one pixel column of the map
+struct AddressColumn {
+    uint64_t mappedBytes = 0;
+    std::array<uint64_t, 4> categoryBytes = {};   // Indexed by MemoryCategory
+    uint64_t residentBytes = 0;
+    uint32_t regions = 0;       // Regions touching the column
+
+    MemoryCategory dominant() const;
+};
+
+// Virtual address space layout of one process
+// Mappings of a process never overlap, so the interval tree degenerates into
+// the address sorted region array: a lookup is one binary search. Every region
+// also gets a position along the drawn axis (its address, or with compacted
+// gaps its address minus the unmapped space before it), and prefix sums of
+// the bytes per category and resident bytes over the array are the level of
+// detail aggregates: a column covering any number of regions costs two binary
+// searches plus the clipped regions at both ends, whatever the zoom.
+class AddressMap
+{
+public:
+    void build(pid_t pid, const std::vector<Vma>& vmas);
+
+    // Unmapped gaps wider than the map's average region are drawn that wide
+    void setCompactGaps(bool compact);
+    bool compactGaps() const { return m_compactGaps; }
+
+    pid_t pid() const { return m_pid; }
+    size_t size() const { return m_regions.size(); }
+    bool isEmpty() const { return m_regions.empty(); }
+    const AddressRegion& region(size_t i) const { return m_regions[i]; }
+    std::string_view pathOf(const AddressRegion& region) const { return m_paths[region.path]; }
+
+    uint64_t mappedBytes() const;
+    uint64_t residentBytes() const { return m_prefixResident.empty() ? 0 : m_prefixResident.back(); }
+
+    // Drawn axis, 0 is the lowest mapping
+    double axisLength() const { return m_axisLength; }
+    double axisOf(uint64_t address) const;
+    uint64_t addressAt(double axis) const;
+
+    // Region under an axis position, nullptr in a gap
+    const AddressRegion* regionAt(double axis) const;
+
+    // count columns of equal width covering [from, to) of the axis
+    void columns(double from, double to, int count, std::vector<AddressColumn>& out) const;
+
+private:
+    pid_t m_pid = 0;
+    bool m_compactGaps = true;
+    std::vector<AddressRegion> m_regions;    // Address sorted
+    std::vector<double> m_axisStart;         // Axis position of every region start
+    double m_axisLength = 0;
+    std::vector<std::string> m_paths;
+
+    // Element i sums regions [0, i)
+    std::vector<std::array<uint64_t, 4>> m_prefixBytes;
+    std::vector<uint64_t> m_prefixResident;
+
+    void layout();
+    size_t firstEndingAfter(double axis) const;
+    void addClipped(size_t i, double from, double to, AddressColumn& column) const;
+};
+
+#endif // ADDRESSMAP_H
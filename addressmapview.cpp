@@ -0,0 +1,267 @@
+#include "addressmapview.h"
+#include "memoryanalyzer.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QResizeEvent>
+#include <QToolTip>
+#include <cmath>
+
+namespace {
+// Same palette as MemoryBar, indexed by MemoryCategory (Private, Stack, Image, Mapped)
+const QRgb categoryColors[] = { 0x42A5F5, 0xFFCA28, 0x66BB6A, 0xAB47BC };
+const char* const categoryNames[] = { "Private", "Stack", "Image", "Mapped" };
+const QRgb background = 0x2D2D2D;
+
+const int margin = 10;
+const int headerHeight = 40;    // Legend and summary
+const int axisWidth = 130;      // Row start addresses
+const int rowHeight = 16;
+const double minBytesPerColumn = 16;
+
+QString hexAddress(quint64 address)
+{
+    return "0x" + QString::number(address, 16);
+}
+}
+
+AddressMapView::AddressMapView(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(260);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMouseTracking(true);
+}
+
+void AddressMapView::setMap(const AddressMap& map)
+{
+    m_map = map;
+    setView(0, m_map.axisLength());
+}
+
+void AddressMapView::clear()
+{
+    setMap(AddressMap());
+}
+
+// Keeps the addresses in view when the axis is laid out again
+void AddressMapView::setCompactGaps(bool compact)
+{
+    const bool full = m_viewFrom <= 0 && m_viewTo >= m_map.axisLength();
+    const quint64 from = m_map.addressAt(m_viewFrom);
+    const quint64 to = m_map.addressAt(m_viewTo);
+
+    m_map.setCompactGaps(compact);
+    if (full) {
+        setView(0, m_map.axisLength());
+    } else {
+        setView(m_map.axisOf(from), m_map.axisOf(to));
+    }
+}
+
+QRect AddressMapView::plotRect() const
+{
+    return QRect(margin + axisWidth, margin + headerHeight,
+                 qMax(1, width() - axisWidth - margin * 2), qMax(rowHeight, height() - headerHeight - margin * 2));
+}
+
+int AddressMapView::rowCount() const
+{
+    return qMax(1, plotRect().height() / rowHeight);
+}
+
+int AddressMapView::columnCount() const
+{
+    return plotRect().width();
+}
+
+double AddressMapView::perColumn() const
+{
+    return (m_viewTo - m_viewFrom) / (double(rowCount()) * columnCount());
+}
+
+// Zoom is limited to a few bytes per column, panning to the mapped range
+void AddressMapView::setView(double from, double to)
+{
+    const double length = m_map.axisLength();
+    const double minSpan = minBytesPerColumn * rowCount() * columnCount();
+    const double span = qBound(minSpan, to - from, qMax(length, minSpan));
+
+    m_viewFrom = span >= length ? 0 : qBound(0.0, from, length - span);
+    m_viewTo = m_viewFrom + span;
+    m_dirty = true;
+    update();
+}
+
+bool AddressMapView::axisAt(const QPoint& pos, double& axis) const
+{
+    const QRect plot = plotRect();
+    const int row = (pos.y() - plot.top()) / rowHeight;
+    if (!plot.contains(pos) || row >= rowCount()) return false;
+
+    const double column = double(row) * columnCount() + (pos.x() - plot.left()) + 0.5;
+    axis = m_viewFrom + column * perColumn();
+    return true;
+}
+
+// One aggregate per pixel column, all rows in a single pass over the map
+void AddressMapView::renderImage()
+{
+    const QRect plot = plotRect();
+    const int rows = rowCount();
+    const int columns = columnCount();
+    if (m_image.size() != plot.size()) m_image = QImage(plot.size(), QImage::Format_RGB32);
+    m_image.fill(background);
+    m_dirty = false;
+    if (m_map.isEmpty()) return;
+
+    m_map.columns(m_viewFrom, m_viewTo, rows * columns, m_columns);
+
+    const double bytesPerColumn = perColumn();
+    const int bgR = qRed(background);
+    const int bgG = qGreen(background);
+    const int bgB = qBlue(background);
+    for (int row = 0; row < rows; ++row) {
+        const int top = row * rowHeight;
+        const int bottom = qMin(top + rowHeight - 1, m_image.height()); // One line between rows
+
+        for (int x = 0; x < columns; ++x) {
+            const AddressColumn& column = m_columns[size_t(row) * columns + x];
+            if (column.mappedBytes == 0) continue;
+
+            // Darker when not resident, fainter when the slice is mostly unmapped
+            const QRgb base = categoryColors[int(column.dominant())];
+            const double resident = qMin(1.0, double(column.residentBytes) / double(column.mappedBytes));
+            const double coverage = qMin(1.0, double(column.mappedBytes) / bytesPerColumn);
+            const double shade = 0.3 + 0.7 * resident;
+            const double alpha = 0.35 + 0.65 * coverage;
+            const QRgb color = qRgb(int(bgR + (qRed(base) * shade - bgR) * alpha),
+                                    int(bgG + (qGreen(base) * shade - bgG) * alpha),
+                                    int(bgB + (qBlue(base) * shade - bgB) * alpha));
+
+            for (int y = top; y < bottom; ++y) {
+                reinterpret_cast<QRgb*>(m_image.scanLine(y))[x] = color;
+            }
+        }
+    }
+}
+
+void AddressMapView::paintEvent(QPaintEvent *)
+{
+    if (m_dirty) renderImage();
+
+    QPainter p(this);
+    const QRect plot = plotRect();
+    p.drawImage(plot.topLeft(), m_image);
+
+    QFont smallFont = font();
+    smallFont.setPointSizeF(9);
+    p.setFont(smallFont);
+
+    // Legend
+    int x = plot.left();
+    for (int c = 0; c < 4; ++c) {
+        p.setPen(Qt::NoPen);
+        p.setBrush(QColor(categoryColors[c]));
+        p.drawRoundedRect(x, margin + 3, 10, 10, 2, 2);
+        p.setPen(QColor(200, 200, 200));
+        p.drawText(x + 14, margin + 12, categoryNames[c]);
+        x += 14 + p.fontMetrics().horizontalAdvance(categoryNames[c]) + 16;
+    }
+    p.drawText(x, margin + 12, "darker: not resident, fainter: sparsely mapped");
+
+    if (m_map.isEmpty()) {
+        p.drawText(plot, Qt::AlignCenter, "Scan a process to map its address space");
+        return;
+    }
+
+    p.drawText(plot.left(), margin + 30,
+               QString("PID %1: %2 mappings, %3 mapped, %4 resident, showing %5 - %6")
+                   .arg(m_map.pid())
+                   .arg(m_map.size())
+                   .arg(MemoryAnalyzer::formatMemory(qint64(m_map.mappedBytes() / 1024)))
+                   .arg(MemoryAnalyzer::formatMemory(qint64(m_map.residentBytes() / 1024)))
+                   .arg(hexAddress(m_map.addressAt(m_viewFrom)), hexAddress(m_map.addressAt(m_viewTo))));
+
+    // Start address of every row, thinned out when rows are dense
+    const int rows = rowCount();
+    const double rowSpan = perColumn() * columnCount();
+    const int step = qMax(1, 18 / rowHeight);
+    for (int row = 0; row < rows; row += step) {
+        const QRect label(margin, plot.top() + row * rowHeight, axisWidth - 6, rowHeight);
+        p.drawText(label, Qt::AlignRight | Qt::AlignVCenter, hexAddress(m_map.addressAt(m_viewFrom + row * rowSpan)));
+    }
+}
+
+void AddressMapView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    setView(m_viewFrom, m_viewTo);
+}
+
+void AddressMapView::wheelEvent(QWheelEvent *event)
+{
+    double anchor;
+    if (!axisAt(event->position().toPoint(), anchor)) anchor = (m_viewFrom + m_viewTo) / 2;
+
+    // The position under the cursor stays put
+    const double factor = std::pow(0.8, event->angleDelta().y() / 120.0);
+    const double span = m_viewTo - m_viewFrom;
+    const double fraction = (anchor - m_viewFrom) / span;
+    const double newSpan = span * factor;
+    setView(anchor - fraction * newSpan, anchor - fraction * newSpan + newSpan);
+    event->accept();
+}
+
+void AddressMapView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = true;
+        m_lastDragPos = event->position().toPoint();
+        setCursor(Qt::ClosedHandCursor);
+    }
+}
+
+void AddressMapView::mouseMoveEvent(QMouseEvent *event)
+{
+    const QPoint pos = event->position().toPoint();
+
+    // Rows continue each other, a vertical drag moves whole rows
+    if (m_dragging) {
+        const QPoint delta = pos - m_lastDragPos;
+        m_lastDragPos = pos;
+        const double shift = -(delta.x() + double(delta.y()) / rowHeight * columnCount()) * perColumn();
+        setView(m_viewFrom + shift, m_viewTo + shift);
+        return;
+    }
+
+    double axis;
+    const AddressRegion* region = axisAt(pos, axis) ? m_map.regionAt(axis) : nullptr;
+    if (!region) {
+        QToolTip::hideText();
+        return;
+    }
+
+    const std::string_view path = m_map.pathOf(*region);
+    QToolTip::showText(event->globalPosition().toPoint(),
+                       QString("%1\n%2 - %3 %4\nSize %5, resident %6, swapped %7")
+                           .arg(path.empty() ? QString("[anonymous]") : QString::fromUtf8(path.data(), qsizetype(path.size())))
+                           .arg(hexAddress(region->start), hexAddress(region->end), QString::fromLatin1(region->perms))
+                           .arg(MemoryAnalyzer::formatMemory(qint64(region->size() / 1024)))
+                           .arg(MemoryAnalyzer::formatMemory(qint64(region->residentBytes / 1024)))
+                           .arg(MemoryAnalyzer::formatMemory(qint64(region->swapBytes / 1024))),
+                       this);
+}
+
+void AddressMapView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+        unsetCursor();
+    }
+}
+
+void AddressMapView::mouseDoubleClickEvent(QMouseEvent *)
+{
+    setView(0, m_map.axisLength());
+}
@@ -0,0 +1,59 @@
+#ifndef ADDRESSMAPVIEW_H
+#define ADDRESSMAPVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPoint>
+#include <vector>
+#include "addressmap.h"
+
+// Zoomable map of a process's virtual address space
+// The visible part of the axis wraps over rows like a hex dump, every pixel
+// column showing what AddressMap aggregates for its slice: colored by the
+// dominant category, darker the less of it is resident, fainter the less of
+// the slice is mapped. The columns are only recomputed when the view moves
+// and are rendered into an image that repaints blit.
+// Wheel zooms around the cursor, dragging pans, a double click resets.
+class AddressMapView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit AddressMapView(QWidget *parent = nullptr);
+
+    void setMap(const AddressMap& map);
+    void clear();
+    void setCompactGaps(bool compact);
+    const AddressMap& map() const { return m_map; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    AddressMap m_map;
+    double m_viewFrom = 0;      // Axis range shown over every row
+    double m_viewTo = 0;
+
+    std::vector<AddressColumn> m_columns;
+    QImage m_image;             // Plot area, rebuilt when dirty
+    bool m_dirty = true;
+
+    bool m_dragging = false;
+    QPoint m_lastDragPos;
+
+    QRect plotRect() const;
+    int rowCount() const;
+    int columnCount() const;
+    double perColumn() const;
+    bool axisAt(const QPoint& pos, double& axis) const;
+    void setView(double from, double to);
+    void renderImage();
+};
+
+#endif // ADDRESSMAPVIEW_H
@@ -0,0 +1,400 @@
+#include "alertengine.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const char* const kindNames[] = { "process", "group", "port" };
+const char* const metricNames[] = { "total", "private", "stack", "image", "mapped", "recvq", "sendq", "conns" };
+
+bool isMemory(AlertMetric metric)
+{
+    return metric < AlertMetric::RecvQueue;
+}
+
+// Whitespace separated, double quotes group (and are dropped)
+QStringList tokenize(const QString& line)
+{
+    QStringList tokens;
+    QString current;
+    bool quoted = false;
+    bool inToken = false;
+    for (QChar c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            inToken = true;
+        } else if (c.isSpace() && !quoted) {
+            if (inToken) tokens.append(current);
+            current.clear();
+            inToken = false;
+        } else {
+            current += c;
+            inToken = true;
+        }
+    }
+    if (inToken) tokens.append(current);
+    return tokens;
+}
+
+// "2GB", "512M", "100" (KB for memory), counts have no suffix
+bool parseAmount(QString text, bool memory, double& out)
+{
+    double scale = 1;
+    if (memory) {
+        text = text.toUpper();
+        if (text.endsWith('B')) text.chop(1);
+        if (text.endsWith('K')) { text.chop(1); }
+        else if (text.endsWith('M')) { text.chop(1); scale = 1024; }
+        else if (text.endsWith('G')) { text.chop(1); scale = 1024 * 1024; }
+        else if (text.endsWith('T')) { text.chop(1); scale = 1024.0 * 1024 * 1024; }
+    }
+    bool ok = false;
+    out = text.toDouble(&ok) * scale;
+    return ok && out >= 0;
+}
+
+// "500ms", "30s", "10m", "1h", "2d"
+bool parseDuration(const QString& text, qint64& out)
+{
+    static const QList<QPair<QString, qint64>> units = {
+        { "ms", 1 }, { "s", 1000 }, { "m", 60 * 1000 }, { "h", 60 * 60 * 1000 }, { "d", 24 * 60 * 60 * 1000 }
+    };
+    for (const auto& unit : units) {
+        if (text.endsWith(unit.first)) {
+            bool ok = false;
+            double value = text.chopped(unit.first.size()).toDouble(&ok);
+            out = qint64(value * unit.second);
+            return ok && out > 0;
+        }
+    }
+    return false;
+}
+
+QString formatValue(AlertMetric metric, double value)
+{
+    if (!isMemory(metric)) return QString::number(value, 'f', 0);
+    if (std::fabs(value) >= 1024 * 1024) return QString::number(value / 1024 / 1024, 'f', 2) + " GB";
+    if (std::fabs(value) >= 1024) return QString::number(value / 1024, 'f', 1) + " MB";
+    return QString::number(value, 'f', 0) + " KB";
+}
+}
+
+void AlertSample::set(AlertMetric metric, double value)
+{
+    values[int(metric)] = value;
+    present |= 1u << int(metric);
+}
+
+AlertSample AlertSample::fromSummary(const ProcessMemorySummary& s, qint64 timestampMs, AlertTargetKind kind)
+{
+    AlertSample sample;
+    sample.kind = kind;
+    sample.name = s.processName;
+    sample.id = kind == AlertTargetKind::Process ? s.pid : 0;
+    sample.timestampMs = timestampMs;
+    sample.set(AlertMetric::Total, s.total);
+    sample.set(AlertMetric::Private, s.pvt);
+    sample.set(AlertMetric::Stack, s.stk);
+    sample.set(AlertMetric::Image, s.img);
+    sample.set(AlertMetric::Mapped, s.map);
+    return sample;
+}
+
+QList<AlertSample> AlertSample::fromPorts(const QList<PortInfo>& ports, qint64 timestampMs)
+{
+    QMap<int, AlertSample> byPort;
+    for (const PortInfo& p : ports) {
+        if (!p.host.isEmpty()) continue;
+
+        auto it = byPort.find(p.port);
+        if (it == byPort.end()) {
+            it = byPort.insert(p.port, AlertSample());
+            it->kind = AlertTargetKind::Port;
+            it->name = QString::number(p.port);
+            it->timestampMs = timestampMs;
+            it->set(AlertMetric::RecvQueue, 0);
+            it->set(AlertMetric::SendQueue, 0);
+            it->set(AlertMetric::Connections, 0);
+        }
+        it->values[int(AlertMetric::RecvQueue)] += p.rxQueue;
+        it->values[int(AlertMetric::SendQueue)] += p.txQueue;
+        it->values[int(AlertMetric::Connections)] += p.connections;
+    }
+    return byPort.values();
+}
+
+AlertRule AlertRule::parse(const QString& line, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return AlertRule();
+    };
+
+    const QStringList tokens = tokenize(line);
+    if (tokens.size() < 4) return fail("Expected <kind>:<target> <metric> > <value>");
+
+    AlertRule rule;
+
+    const int colon = tokens[0].indexOf(':');
+    const QString kind = tokens[0].left(colon).toLower();
+    rule.target = tokens[0].mid(colon + 1);
+    int kindIndex = -1;
+    for (int k = 0; k < 3; ++k) {
+        if (kind == kindNames[k]) kindIndex = k;
+    }
+    if (colon < 0 || kindIndex < 0) return fail(QString("Unknown target \"%1\"").arg(tokens[0]));
+    if (rule.target.isEmpty()) return fail("Missing target name");
+    rule.kind = AlertTargetKind(kindIndex);
+
+    int metricIndex = -1;
+    for (int m = 0; m < int(AlertMetric::Count); ++m) {
+        if (tokens[1].toLower() == metricNames[m]) metricIndex = m;
+    }
+    if (metricIndex < 0) return fail(QString("Unknown metric \"%1\"").arg(tokens[1]));
+    rule.metric = AlertMetric(metricIndex);
+    if (isMemory(rule.metric) == (rule.kind == AlertTargetKind::Port)) {
+        return fail(QString("\"%1\" does not apply to %2 targets").arg(tokens[1], kind));
+    }
+
+    int i = 2;
+    if (tokens[i].toLower() == "growth") {
+        rule.condition = GrowthAbove;
+        ++i;
+    }
+    if (i + 1 >= tokens.size() || tokens[i] != ">") return fail("Expected > and a value");
+
+    const bool memory = isMemory(rule.metric);
+    auto amount = [&](QString text, double& out) {
+        // Growth rates are kept per minute
+        double perMinute = 1;
+        if (rule.condition == GrowthAbove) {
+            if (text.endsWith("/s")) { text.chop(2); perMinute = 60; }
+            else if (text.endsWith("/min")) { text.chop(4); }
+            else if (text.endsWith("/h")) { text.chop(2); perMinute = 1.0 / 60; }
+        }
+        if (!parseAmount(text, memory, out)) return false;
+        out *= perMinute;
+        return true;
+    };
+
+    if (!amount(tokens[i + 1], rule.threshold)) return fail(QString("Invalid value \"%1\"").arg(tokens[i + 1]));
+    rule.clearLevel = rule.condition == GrowthAbove ? rule.threshold / 2 : rule.threshold * 0.9;
+
+    for (i += 2; i < tokens.size(); i += 2) {
+        const QString option = tokens[i].toLower();
+        if (i + 1 >= tokens.size()) return fail(QString("Missing value for \"%1\"").arg(option));
+        const QString& value = tokens[i + 1];
+
+        if (option == "clear") {
+            if (!amount(value, rule.clearLevel) || rule.clearLevel > rule.threshold) {
+                return fail(QString("Invalid clear level \"%1\"").arg(value));
+            }
+        } else if (option == "over") {
+            if (!parseDuration(value, rule.windowMs)) return fail(QString("Invalid duration \"%1\"").arg(value));
+        } else if (option == "cooldown") {
+            if (!parseDuration(value, rule.cooldownMs)) return fail(QString("Invalid duration \"%1\"").arg(value));
+        } else {
+            return fail(QString("Unknown option \"%1\"").arg(option));
+        }
+    }
+
+    rule.text = line.trimmed();
+    if (error) error->clear();
+    return rule;
+}
+
+QString AlertEvent::title() const
+{
+    QString name = id > 0 ? QString("%1 [%2]").arg(target).arg(id) : target;
+    if (kind == AlertTargetKind::Port) name = "Port " + name;
+    return type == Fired ? QString("Memyze: %1").arg(name) : QString("Memyze: %1 recovered").arg(name);
+}
+
+QString AlertEvent::message() const
+{
+    const QString metricName = metricNames[int(metric)];
+    if (growth) {
+        return QString("%1 growing %2/min (limit %3/min)")
+            .arg(metricName, formatValue(metric, value), formatValue(metric, threshold));
+    }
+    return QString("%1 at %2 (limit %3)").arg(metricName, formatValue(metric, value), formatValue(metric, threshold));
+}
+
+QByteArray AlertEvent::toJson() const
+{
+    QJsonObject o;
+    o["event"] = type == Fired ? "fired" : "resolved";
+    o["timestamp_ms"] = timestampMs;
+    o["rule"] = rule;
+    o["kind"] = kindNames[int(kind)];
+    o["target"] = target;
+    if (id > 0) o["pid"] = id;
+    o["metric"] = metricNames[int(metric)];
+    o["growth"] = growth; // Value and threshold are per minute
+    o["value"] = value;
+    o["threshold"] = threshold;
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
+
+bool AlertEngine::addRule(const QString& line, QString* error)
+{
+    AlertRule rule = AlertRule::parse(line, error);
+    if (!rule.isValid()) return false;
+
+    const int index = m_rules.size();
+    m_rules.append(rule);
+    if (rule.target == "*") {
+        m_wildcard[int(rule.kind)].append(index);
+    } else {
+        m_byTarget[int(rule.kind)][rule.target].append(index);
+    }
+    return true;
+}
+
+int AlertEngine::loadRules(const QString& path, QStringList* errors)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errors) errors->append(QString("%1: %2").arg(path, file.errorString()));
+        return 0;
+    }
+
+    int added = 0;
+    int lineNumber = 0;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QString error;
+        if (addRule(line, &error)) {
+            ++added;
+        } else if (errors) {
+            errors->append(QString("%1:%2: %3").arg(path).arg(lineNumber).arg(error));
+        }
+    }
+    return added;
+}
+
+// Rules are only appended, so a target binds the ones added since it last bound
+void AlertEngine::bind(const TargetKey& key, Target& target)
+{
+    const int from = qMax(target.generation, 0);
+    auto add = [&](const QList<int>& indexes) {
+        for (int index : indexes) {
+            if (index < from) continue;
+            RuleState state;
+            state.rule = index;
+            target.rules.append(state);
+        }
+    };
+    add(m_byTarget[int(key.kind)].value(key.name));
+    add(m_wildcard[int(key.kind)]);
+    target.generation = m_rules.size();
+    target.quiet = false;
+}
+
+AlertEvent AlertEngine::event(AlertEvent::Type type, const RuleState& state, const TargetKey& key,
+                              double value, qint64 timestampMs) const
+{
+    const AlertRule& rule = m_rules[state.rule];
+
+    AlertEvent e;
+    e.type = type;
+    e.rule = rule.text;
+    e.kind = key.kind;
+    e.target = key.name;
+    e.id = key.id;
+    e.metric = rule.metric;
+    e.growth = rule.condition == AlertRule::GrowthAbove;
+    e.value = value;
+    e.threshold = rule.threshold;
+    e.timestampMs = timestampMs;
+    return e;
+}
+
+QList<AlertEvent> AlertEngine::addSample(const AlertSample& sample)
+{
+    QList<AlertEvent> events;
+    if (m_rules.isEmpty()) return events;
+
+    const TargetKey key{ sample.kind, sample.name, sample.id };
+    Target& target = m_targets[key];
+    if (target.generation != m_rules.size()) bind(key, target);
+    target.lastSeenMs = sample.timestampMs;
+
+    // Same values as last time can't change a threshold rule's state
+    const bool unchanged = target.lastPresent == sample.present &&
+                           std::equal(std::begin(sample.values), std::end(sample.values), std::begin(target.last));
+    if (unchanged && target.quiet) return events;
+
+    std::copy(std::begin(sample.values), std::end(sample.values), std::begin(target.last));
+    target.lastPresent = sample.present;
+
+    bool quiet = true;
+    for (RuleState& state : target.rules) {
+        const AlertRule& rule = m_rules[state.rule];
+        if (!(sample.present & (1u << int(rule.metric)))) continue;
+
+        double value = sample.values[int(rule.metric)];
+        if (rule.condition == AlertRule::GrowthAbove) {
+            quiet = false;
+            state.window.emplace_back(sample.timestampMs, value);
+            while (state.window.size() > 2 && state.window[1].first <= sample.timestampMs - rule.windowMs) {
+                state.window.pop_front();
+            }
+
+            // Needs history over most of the window before it can judge
+            const qint64 span = state.window.back().first - state.window.front().first;
+            if (span < rule.windowMs / 2) continue;
+            value = (state.window.back().second - state.window.front().second) * 60000.0 / span;
+        }
+
+        if (state.firing) {
+            if (value < rule.clearLevel) {
+                state.firing = false;
+                events.append(event(AlertEvent::Resolved, state, key, value, sample.timestampMs));
+            }
+            continue;
+        }
+
+        state.heldBack = false;
+        if (value > rule.threshold) {
+            if (state.everFired && sample.timestampMs - state.lastFiredMs < rule.cooldownMs) {
+                state.heldBack = true;
+                quiet = false;
+                continue;
+            }
+            state.firing = true;
+            state.everFired = true;
+            state.lastFiredMs = sample.timestampMs;
+            events.append(event(AlertEvent::Fired, state, key, value, sample.timestampMs));
+        }
+    }
+    target.quiet = quiet;
+    return events;
+}
+
+QList<AlertEvent> AlertEngine::prune(qint64 olderThanMs)
+{
+    QList<AlertEvent> events;
+    for (auto it = m_targets.begin(); it != m_targets.end();) {
+        if (it->lastSeenMs >= olderThanMs) {
+            ++it;
+            continue;
+        }
+        for (const RuleState& state : std::as_const(it->rules)) {
+            if (state.firing) {
+                events.append(event(AlertEvent::Resolved, state, it.key(), 0, olderThanMs));
+            }
+        }
+        it = m_targets.erase(it);
+    }
+    return events;
+}
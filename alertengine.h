@@ -0,0 +1,155 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <deque>
+#include "memoryanalyzer.h"
+#include "portmanager.h"
+
+// What a sample belongs to
+enum class AlertTargetKind { Process, Group, Port };
+
+// Values a rule can watch, memory in KB
+enum class AlertMetric { Total, Private, Stack, Image, Mapped, RecvQueue, SendQueue, Connections, Count };
+
+// One sample of a target
+struct AlertSample {
+    AlertTargetKind kind = AlertTargetKind::Process;
+    QString name;           // Process name, group name or port number, what rules match on
+    qint64 id = 0;          // PID of a process, 0 otherwise
+    qint64 timestampMs = 0;
+    double values[int(AlertMetric::Count)] = {};
+    quint32 present = 0;    // Bit per metric carried by the sample
+
+    void set(AlertMetric metric, double value);
+
+    static AlertSample fromSummary(const ProcessMemorySummary& s, qint64 timestampMs,
+                                   AlertTargetKind kind = AlertTargetKind::Process);
+    // One sample per local port, rows of the same port are summed
+    static QList<AlertSample> fromPorts(const QList<PortInfo>& ports, qint64 timestampMs);
+};
+
+// One line of a rules file
+//
+//   <kind>:<target> <metric> [growth] > <value> [clear <value>] [over <duration>] [cooldown <duration>]
+//
+//   process:postgres total > 2GB clear 1.8GB cooldown 30m
+//   process:* private growth > 50MB/min over 10m
+//   group:"comm=python* uid=1001" total > 8GB
+//   port:5432 recvq > 100
+//
+// Kinds are process, group and port, "*" matches every target of the kind.
+// Metrics are total, private, stack, image, mapped (KB, with K/M/G suffixes)
+// and recvq, sendq, conns for ports. Growth is per minute unless /s or /h is
+// given and is measured over the "over" window (5 minutes by default).
+// An alert fires above the value and resolves below the clear level (90% of
+// the value, half of it for growth), and fires again at most once per
+// cooldown (10 minutes by default).
+struct AlertRule {
+    enum Condition { Above, GrowthAbove };
+
+    QString text;
+    AlertTargetKind kind = AlertTargetKind::Process;
+    QString target;
+    AlertMetric metric = AlertMetric::Total;
+    Condition condition = Above;
+    double threshold = 0;
+    double clearLevel = 0;
+    qint64 windowMs = 5 * 60 * 1000;
+    qint64 cooldownMs = 10 * 60 * 1000;
+
+    bool isValid() const { return !text.isEmpty(); }
+
+    static AlertRule parse(const QString& line, QString* error = nullptr);
+};
+
+struct AlertEvent {
+    enum Type { Fired, Resolved };
+
+    Type type = Fired;
+    QString rule;           // Rule text
+    AlertTargetKind kind = AlertTargetKind::Process;
+    QString target;
+    qint64 id = 0;
+    AlertMetric metric = AlertMetric::Total;
+    bool growth = false;
+    double value = 0;       // Value, or growth per minute
+    double threshold = 0;
+    qint64 timestampMs = 0;
+
+    QString title() const;
+    QString message() const;
+    QByteArray toJson() const; // One line, for headless use
+};
+
+// Threshold and growth rate alerting
+// Rules are indexed by kind and target name, and every target binds the rules
+// matching it the first time it is seen. A sample then only evaluates the
+// rules of its own target, and a target whose values did not change and has no
+// growth rule or alert held back by a cooldown is not evaluated at all. The
+// cost of a sample does not depend on how many rules watch other targets.
+class AlertEngine
+{
+public:
+    bool addRule(const QString& line, QString* error = nullptr);
+    // Blank lines and lines starting with # are skipped, returns the rules added
+    int loadRules(const QString& path, QStringList* errors = nullptr);
+    int ruleCount() const { return m_rules.size(); }
+    bool hasRules(AlertTargetKind kind) const {
+        return !m_byTarget[int(kind)].isEmpty() || !m_wildcard[int(kind)].isEmpty();
+    }
+    // Targets named by the rules of one kind, wildcards left out
+    QStringList targets(AlertTargetKind kind) const { return m_byTarget[int(kind)].keys(); }
+
+    QList<AlertEvent> addSample(const AlertSample& sample);
+
+    // Forget targets without a sample since olderThanMs, their firing alerts resolve
+    QList<AlertEvent> prune(qint64 olderThanMs);
+
+private:
+    struct RuleState {
+        int rule = 0;
+        bool firing = false;
+        bool heldBack = false;           // Breached during the cooldown
+        qint64 lastFiredMs = 0;
+        bool everFired = false;
+        std::deque<QPair<qint64, double>> window; // Growth rules only
+    };
+
+    struct TargetKey {
+        AlertTargetKind kind;
+        QString name;
+        qint64 id;
+
+        bool operator==(const TargetKey& other) const {
+            return kind == other.kind && id == other.id && name == other.name;
+        }
+    };
+    friend size_t qHash(const TargetKey& key, size_t seed) {
+        return qHashMulti(seed, int(key.kind), key.name, key.id);
+    }
+
+    struct Target {
+        int generation = -1;             // Rule count when the rules were bound
+        qint64 lastSeenMs = 0;
+        bool quiet = false;              // Unchanged values can't change any state
+        double last[int(AlertMetric::Count)] = {};
+        quint32 lastPresent = 0;
+        QVector<RuleState> rules;
+    };
+
+    QList<AlertRule> m_rules;
+    QHash<QString, QList<int>> m_byTarget[3]; // Per kind
+    QList<int> m_wildcard[3];
+    QHash<TargetKey, Target> m_targets;
+
+    void bind(const TargetKey& key, Target& target);
+    AlertEvent event(AlertEvent::Type type, const RuleState& state, const TargetKey& key,
+                     double value, qint64 timestampMs) const;
+};
+
+#endif // ALERTENGINE_H
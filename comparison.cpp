@@ -0,0 +1,266 @@
+#include "comparison.h"
+#include "procfsreader.h"
+#include "scanarena.h"
+#include "scanexecutor.h"
+#include "smaps.h"
+#include "stringpool.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <algorithm>
+
+namespace {
+const char* const categoryKeys[] = {"private", "stack", "image", "mapped"};
+
+MemoryCategory categoryFromKey(const QString& key)
+{
+    for (int c = 0; c < 4; ++c) {
+        if (key == categoryKeys[c]) return MemoryCategory(c);
+    }
+    return MemoryCategory::Private;
+}
+
+void addToSummary(ProcessMemorySummary& s, MemoryCategory category, qint64 kb)
+{
+    switch (category) {
+    case MemoryCategory::Private: s.pvt += kb; break;
+    case MemoryCategory::Stack:   s.stk += kb; break;
+    case MemoryCategory::Image:   s.img += kb; break;
+    case MemoryCategory::Mapped:  s.map += kb; break;
+    }
+    s.total += kb;
+}
+}
+
+CompareTarget CompareTarget::parse(const QString& text, QString* error)
+{
+    CompareTarget target;
+    target.text = text.trimmed();
+    if (error) error->clear();
+
+    bool isNumber = false;
+    const int pid = target.text.toInt(&isNumber);
+    if (isNumber && pid > 0) {
+        target.kind = Process;
+        target.pid = pid;
+    } else if (target.text.startsWith("app:")) {
+        target.kind = Application;
+        target.pid = target.text.mid(4).trimmed().toInt();
+        if (target.pid <= 0 && error) *error = QString("No PID after app: in \"%1\"").arg(target.text);
+    } else if (target.text.startsWith("rule:")) {
+        target.kind = Rule;
+        target.rule = ProcessGroupRule::compile(target.text.mid(5).trimmed(), error);
+    } else if (QFileInfo(target.text).isFile()) {
+        target.kind = Capture;
+        target.file = target.text;
+    } else if (error) {
+        *error = target.text.isEmpty() ? QString("Nothing to compare")
+                                       : QString("\"%1\" is neither a PID, app:<pid>, rule:<rule> nor a capture file").arg(target.text);
+    }
+    return target;
+}
+
+// Libraries by file name without the version after ".so" ("libssl.so.3" and
+// "/opt/new/lib/libssl.so.3.1" are both "libssl.so")
+QString Comparison::alignedPath(std::string_view path, MemoryCategory category)
+{
+    static constexpr std::string_view deleted = " (deleted)";
+    if (path.size() > deleted.size() && path.substr(path.size() - deleted.size()) == deleted) {
+        path.remove_suffix(deleted.size());
+    }
+    if (path.empty()) return "[anon]";
+
+    if (category == MemoryCategory::Image) {
+        const size_t slash = path.rfind('/');
+        if (slash != std::string_view::npos) path.remove_prefix(slash + 1);
+        const size_t so = path.find(".so.");
+        if (so != std::string_view::npos) path = path.substr(0, so + 3);
+    }
+    return StringPool::internUtf8(path);
+}
+
+// Same batching as the regular group scan, the smaps of a whole batch in one go
+void Comparison::addProcesses(const QList<ProcessID>& pids, TargetProfile& profile)
+{
+    for (int start = 0; start < pids.size(); start += ProcfsReader::BatchSize) {
+        ScanExecutor::checkpoint();
+
+        const QList<ProcessID> batch = pids.mid(start, ProcfsReader::BatchSize);
+        std::vector<std::string> files;
+        files.reserve(size_t(batch.size()));
+        for (ProcessID pid : batch) files.push_back("/proc/" + std::to_string(pid) + "/smaps");
+
+        std::vector<std::string> contents;
+        ProcfsReader::forCurrentThread().readFiles(files, contents);
+
+        ScanArena::Scope scope;
+        std::vector<Vma> vmas;
+        for (const std::string& content : contents) {
+            if (content.empty()) continue;
+            ++profile.processes;
+
+            vmas.clear();
+            Smaps::parse(content, vmas, ScanArena::forCurrentThread());
+            for (const Vma& vma : vmas) {
+                const qint64 kb = qint64(profile.pss ? vma.pssKB : vma.rssKB);
+                const MemoryCategory category = MemoryAnalyzer::categorize(vma.path);
+                PathUsage& usage = profile.paths[alignedPath(vma.path, category)];
+                if (usage.mappings++ == 0) {
+                    usage.category = category;
+                    usage.path = QString::fromUtf8(vma.path.data(), qsizetype(vma.path.size()));
+                }
+                usage.kb += kb;
+                addToSummary(profile.summary, category, kb);
+            }
+        }
+    }
+}
+
+TargetProfile Comparison::profile(const CompareTarget& target)
+{
+    if (target.kind == CompareTarget::Capture) return load(target.file);
+
+    TargetProfile profile;
+    profile.host = QSysInfo::machineHostName();
+    profile.timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+    // Pss for groups so memory shared within the group is counted once, like the group scans
+    QList<ProcessID> pids;
+    switch (target.kind) {
+    case CompareTarget::Process:
+        pids = {target.pid};
+        profile.name = QString("%1 (PID %2)").arg(MemoryAnalyzer::getProcessName(target.pid)).arg(target.pid);
+        break;
+    case CompareTarget::Application:
+        pids = MemoryAnalyzer::findRelatedPids(target.pid);
+        profile.name = QString("%1 (Group of PID %2)").arg(MemoryAnalyzer::getProcessName(target.pid)).arg(target.pid);
+        profile.pss = true;
+        break;
+    case CompareTarget::Rule:
+        pids = target.rule.match(MemoryAnalyzer::listPids()).pids;
+        profile.name = QString("Group: %1").arg(target.rule.text());
+        profile.pss = true;
+        break;
+    case CompareTarget::Capture:
+        break;
+    }
+
+    addProcesses(pids, profile);
+    profile.summary.processName = profile.name;
+    if (profile.processes == 0) {
+        profile.error = QString("Cannot read smaps of %1 (process gone or no permission)").arg(target.text);
+    }
+    return profile;
+}
+
+// Sorted by the size of the change, paths only on one side included
+QList<ComparisonRow> Comparison::compare(const TargetProfile& left, const TargetProfile& right)
+{
+    QList<ComparisonRow> rows;
+    QHash<QString, qsizetype> rowOf;
+    rows.reserve(left.paths.size());
+
+    for (auto it = left.paths.cbegin(); it != left.paths.cend(); ++it) {
+        ComparisonRow row;
+        row.key = it.key();
+        row.category = it->category;
+        row.leftKB = it->kb;
+        row.inLeft = true;
+        rowOf.insert(it.key(), rows.size());
+        rows.append(row);
+    }
+    for (auto it = right.paths.cbegin(); it != right.paths.cend(); ++it) {
+        auto found = rowOf.constFind(it.key());
+        if (found == rowOf.cend()) {
+            ComparisonRow row;
+            row.key = it.key();
+            row.category = it->category;
+            rows.append(row);
+            found = rowOf.insert(it.key(), rows.size() - 1);
+        }
+        ComparisonRow& row = rows[*found];
+        row.rightKB = it->kb;
+        row.inRight = true;
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const ComparisonRow& a, const ComparisonRow& b) {
+        const qint64 da = qAbs(a.deltaKB());
+        const qint64 db = qAbs(b.deltaKB());
+        return da != db ? da > db : a.key < b.key;
+    });
+    return rows;
+}
+
+bool Comparison::save(const TargetProfile& profile, const QString& file, QString* error)
+{
+    QJsonArray paths;
+    for (auto it = profile.paths.cbegin(); it != profile.paths.cend(); ++it) {
+        QJsonObject p;
+        p["key"] = it.key();
+        p["path"] = it->path;
+        p["category"] = categoryKeys[int(it->category)];
+        p["kb"] = it->kb;
+        p["mappings"] = it->mappings;
+        paths.append(p);
+    }
+
+    QJsonObject o;
+    o["version"] = 1;
+    o["name"] = profile.name;
+    o["host"] = profile.host;
+    o["timestamp"] = profile.timestampMs;
+    o["pss"] = profile.pss;
+    o["processes"] = profile.processes;
+    o["paths"] = paths;
+
+    QFile out(file);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = QString("%1: %2").arg(file, out.errorString());
+        return false;
+    }
+    out.write(QJsonDocument(o).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+// Category totals are summed again from the paths
+TargetProfile Comparison::load(const QString& file)
+{
+    TargetProfile profile;
+    QFile in(file);
+    if (!in.open(QIODevice::ReadOnly)) {
+        profile.error = QString("%1: %2").arg(file, in.errorString());
+        return profile;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(in.readAll(), &parseError);
+    const QJsonObject o = document.object();
+    if (document.isNull() || o.value("version").toInt() != 1) {
+        profile.error = QString("%1: not a capture (%2)").arg(file, parseError.errorString());
+        return profile;
+    }
+
+    profile.name = QString("%1 (capture)").arg(o.value("name").toString());
+    profile.host = o.value("host").toString();
+    profile.timestampMs = qint64(o.value("timestamp").toDouble());
+    profile.pss = o.value("pss").toBool();
+    profile.processes = o.value("processes").toInt();
+
+    for (const QJsonValue& value : o.value("paths").toArray()) {
+        const QJsonObject p = value.toObject();
+        PathUsage usage;
+        usage.category = categoryFromKey(p.value("category").toString());
+        usage.path = p.value("path").toString();
+        usage.kb = qint64(p.value("kb").toDouble());
+        usage.mappings = p.value("mappings").toInt();
+        profile.paths.insert(p.value("key").toString(), usage);
+        addToSummary(profile.summary, usage.category, usage.kb);
+    }
+    profile.summary.processName = profile.name;
+    return profile;
+}
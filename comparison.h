@@ -0,0 +1,86 @@
+#ifndef COMPARISON_H
+#define COMPARISON_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMetaType>
+#include <string_view>
+#include "memoryanalyzer.h"
+#include "processgroup.h"
+
+// One side of a comparison as entered:
+// "1234" a process, "app:1234" it and its related processes,
+// "rule:<rule>" a process group rule, anything else a saved capture file
+struct CompareTarget {
+    enum Kind { Process, Application, Rule, Capture };
+
+    Kind kind = Process;
+    QString text;
+    ProcessID pid = 0;
+    ProcessGroupRule rule;
+    QString file;
+
+    static CompareTarget parse(const QString& text, QString* error = nullptr);
+};
+
+// Memory of everything mapped from one aligned path (in KB)
+struct PathUsage {
+    MemoryCategory category = MemoryCategory::Private;
+    QString path;               // First full path seen
+    qint64 kb = 0;
+    int mappings = 0;
+};
+
+// Memory of one target by category and by path
+struct TargetProfile {
+    QString name;
+    QString host;
+    qint64 timestampMs = 0;
+    bool pss = false;           // Pss for groups, Rss for a single process
+    int processes = 0;
+    ProcessMemorySummary summary;
+    QHash<QString, PathUsage> paths;    // By aligned path
+    QString error;
+
+    bool ok() const { return error.isEmpty(); }
+};
+
+struct ComparisonRow {
+    QString key;
+    MemoryCategory category = MemoryCategory::Private;
+    qint64 leftKB = 0;
+    qint64 rightKB = 0;
+    bool inLeft = false;
+    bool inRight = false;
+
+    qint64 deltaKB() const { return rightKB - leftKB; }
+};
+
+// Side-by-side comparison of two targets
+// Both sides are profiled at the same time on the scan pool. Mappings are
+// aligned by path: libraries by file name without the version after ".so",
+// so the old and the new build of a library line up even when installed
+// under different prefixes; other files by full path, anonymous memory by
+// its smaps name. Profiles can be saved as captures and compared later or
+// on another host.
+class Comparison
+{
+public:
+    static TargetProfile profile(const CompareTarget& target);
+    static QList<ComparisonRow> compare(const TargetProfile& left, const TargetProfile& right);
+
+    static QString alignedPath(std::string_view path, MemoryCategory category);
+
+    static bool save(const TargetProfile& profile, const QString& file, QString* error = nullptr);
+    static TargetProfile load(const QString& file);
+
+private:
+    Comparison() = delete;
+
+    static void addProcesses(const QList<ProcessID>& pids, TargetProfile& profile);
+};
+
+Q_DECLARE_METATYPE(TargetProfile)
+
+#endif // COMPARISON_H
@@ -0,0 +1,344 @@
+#include "deltaprotocol.h"
+
+#include <QSet>
+
+using namespace DeltaProtocol;
+
+namespace {
+
+void writeString(QByteArray& out, const QString& s)
+{
+    QByteArray utf8 = s.toUtf8();
+    writeVarint(out, quint64(utf8.size()));
+    out.append(utf8);
+}
+
+bool readString(const char*& p, const char* end, QString& s)
+{
+    quint64 len;
+    if (!readVarint(p, end, len) || len > quint64(end - p)) return false;
+    s = QString::fromUtf8(p, qsizetype(len));
+    p += len;
+    return true;
+}
+
+// Zigzag varint delta of a memory value against the last sent one
+void writeDelta(QByteArray& out, long current, long previous)
+{
+    writeVarint(out, zigzag(qint64(current) - qint64(previous)));
+}
+
+bool readDelta(const char*& p, const char* end, long& value)
+{
+    quint64 raw;
+    if (!readVarint(p, end, raw)) return false;
+    value += long(unzigzag(raw));
+    return true;
+}
+
+void writePortKey(QByteArray& out, const PortKey& key)
+{
+    writeVarint(out, key.first);
+    writeVarint(out, key.second);
+}
+
+bool readPortKey(const char*& p, const char* end, PortKey& key)
+{
+    return readVarint(p, end, key.first) && readVarint(p, end, key.second);
+}
+
+void writeAddress(QByteArray& out, const PortInfo& info)
+{
+    out.append(char(info.protocol == "UDP" ? 1 : 0));
+    writeString(out, info.localAddress);
+    writeString(out, info.remoteAddress);
+}
+
+bool readAddress(const char*& p, const char* end, PortInfo& info)
+{
+    if (p >= end) return false;
+    info.protocol = (*p++ == 1) ? "UDP" : "TCP";
+    return readString(p, end, info.localAddress) && readString(p, end, info.remoteAddress);
+}
+
+// Prefix the payload with its length
+QByteArray frame(const QByteArray& payload)
+{
+    QByteArray out;
+    out.reserve(payload.size() + 5);
+    writeVarint(out, quint64(payload.size()));
+    out.append(payload);
+    return out;
+}
+
+} // namespace
+
+void DeltaProtocol::writeVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+bool DeltaProtocol::readVarint(const char*& p, const char* end, quint64& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        quint8 byte = quint8(*p++);
+        value |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// ### ENCODER ###
+QByteArray DeltaEncoder::hello(const QString& host) const
+{
+    QByteArray payload;
+    payload.append(char(Hello));
+    writeString(payload, host);
+    return frame(payload);
+}
+
+void DeltaEncoder::reset()
+{
+    m_processes.clear();
+    m_ports.clear();
+}
+
+QByteArray DeltaEncoder::encodeProcesses(const QList<ProcessMemorySummary>& current)
+{
+    QByteArray records;
+    quint64 changed = 0;
+    QSet<ProcessID> seen;
+    seen.reserve(current.size());
+
+    for (const ProcessMemorySummary& s : current) {
+        seen.insert(s.pid);
+        auto it = m_processes.find(s.pid);
+        const bool isNew = it == m_processes.end();
+        const ProcessMemorySummary previous = isNew ? ProcessMemorySummary() : *it;
+
+        quint8 mask = 0;
+        if (isNew || s.processName != previous.processName) mask |= FieldName;
+        if (s.pvt != previous.pvt) mask |= FieldPrivate;
+        if (s.stk != previous.stk) mask |= FieldStack;
+        if (s.img != previous.img) mask |= FieldImage;
+        if (s.map != previous.map) mask |= FieldMapped;
+        if (!mask) continue;
+
+        writeVarint(records, quint64(s.pid));
+        records.append(char(mask));
+        if (mask & FieldName) writeString(records, s.processName);
+        if (mask & FieldPrivate) writeDelta(records, s.pvt, previous.pvt);
+        if (mask & FieldStack) writeDelta(records, s.stk, previous.stk);
+        if (mask & FieldImage) writeDelta(records, s.img, previous.img);
+        if (mask & FieldMapped) writeDelta(records, s.map, previous.map);
+
+        m_processes.insert(s.pid, s);
+        changed++;
+    }
+
+    QByteArray removed;
+    quint64 removedCount = 0;
+    for (auto it = m_processes.begin(); it != m_processes.end();) {
+        if (!seen.contains(it.key())) {
+            writeVarint(removed, quint64(it.key()));
+            removedCount++;
+            it = m_processes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (changed == 0 && removedCount == 0) return QByteArray();
+
+    QByteArray payload;
+    payload.reserve(records.size() + removed.size() + 12);
+    payload.append(char(Processes));
+    writeVarint(payload, changed);
+    payload.append(records);
+    writeVarint(payload, removedCount);
+    payload.append(removed);
+    return frame(payload);
+}
+
+QByteArray DeltaEncoder::encodePorts(const QList<PortInfo>& current)
+{
+    QByteArray records;
+    quint64 changed = 0;
+    QSet<PortKey> seen;
+    seen.reserve(current.size());
+
+    for (const PortInfo& info : current) {
+        const PortKey key(info.inode, info.netns);
+        seen.insert(key);
+        auto it = m_ports.find(key);
+        const bool isNew = it == m_ports.end();
+
+        quint8 mask = 0;
+        if (isNew || it->pid != info.pid) mask |= FieldPid;
+        if (isNew || it->processName != info.processName) mask |= FieldProcessName;
+        if (isNew || it->state != info.state) mask |= FieldState;
+        if (isNew || it->protocol != info.protocol || it->localAddress != info.localAddress ||
+            it->remoteAddress != info.remoteAddress) {
+            mask |= FieldAddress;
+        }
+        if (isNew || it->namespaceLabel != info.namespaceLabel) mask |= FieldNamespaceLabel;
+        if (!mask) continue;
+
+        writePortKey(records, key);
+        records.append(char(mask));
+        if (mask & FieldPid) writeVarint(records, quint64(qMax<ProcessID>(0, info.pid)));
+        if (mask & FieldProcessName) writeString(records, info.processName);
+        if (mask & FieldState) writeString(records, info.state);
+        if (mask & FieldAddress) writeAddress(records, info);
+        if (mask & FieldNamespaceLabel) writeString(records, info.namespaceLabel);
+
+        m_ports.insert(key, info);
+        changed++;
+    }
+
+    QByteArray removed;
+    quint64 removedCount = 0;
+    for (auto it = m_ports.begin(); it != m_ports.end();) {
+        if (!seen.contains(it.key())) {
+            writePortKey(removed, it.key());
+            removedCount++;
+            it = m_ports.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (changed == 0 && removedCount == 0) return QByteArray();
+
+    QByteArray payload;
+    payload.append(char(Ports));
+    writeVarint(payload, changed);
+    payload.append(records);
+    writeVarint(payload, removedCount);
+    payload.append(removed);
+    return frame(payload);
+}
+
+// ### DECODER ###
+bool DeltaDecoder::feed(const QByteArray& data)
+{
+    m_buffer.append(data);
+
+    const char* begin = m_buffer.constData();
+    const char* p = begin;
+    const char* end = begin + m_buffer.size();
+
+    while (p < end) {
+        const char* frameStart = p;
+        quint64 len;
+        if (!readVarint(p, end, len)) {
+            // Length itself incomplete, wait for more (10 bytes is the longest varint)
+            if (end - frameStart >= 10) return false;
+            p = frameStart;
+            break;
+        }
+        if (len > MaxFrameSize) return false;
+        if (quint64(end - p) < len) {
+            p = frameStart;
+            break;
+        }
+        if (!applyFrame(p, p + len)) return false;
+        p += len;
+    }
+
+    m_buffer.remove(0, p - begin);
+    return true;
+}
+
+bool DeltaDecoder::applyFrame(const char* p, const char* end)
+{
+    if (p >= end) return false;
+
+    switch (quint8(*p++)) {
+    case Hello:
+        return readString(p, end, m_host);
+    case Processes:
+        return applyProcesses(p, end);
+    case Ports:
+        return applyPorts(p, end);
+    default:
+        return false;
+    }
+}
+
+bool DeltaDecoder::applyProcesses(const char* p, const char* end)
+{
+    quint64 changed;
+    if (!readVarint(p, end, changed)) return false;
+
+    for (quint64 i = 0; i < changed; ++i) {
+        quint64 pid;
+        if (!readVarint(p, end, pid) || p >= end) return false;
+        quint8 mask = quint8(*p++);
+
+        ProcessMemorySummary& s = m_processes[ProcessID(pid)];
+        s.pid = ProcessID(pid);
+        if ((mask & FieldName) && !readString(p, end, s.processName)) return false;
+        if ((mask & FieldPrivate) && !readDelta(p, end, s.pvt)) return false;
+        if ((mask & FieldStack) && !readDelta(p, end, s.stk)) return false;
+        if ((mask & FieldImage) && !readDelta(p, end, s.img)) return false;
+        if ((mask & FieldMapped) && !readDelta(p, end, s.map)) return false;
+        s.total = s.pvt + s.stk + s.img + s.map;
+    }
+
+    quint64 removed;
+    if (!readVarint(p, end, removed)) return false;
+    for (quint64 i = 0; i < removed; ++i) {
+        quint64 pid;
+        if (!readVarint(p, end, pid)) return false;
+        m_processes.remove(ProcessID(pid));
+    }
+
+    return p == end;
+}
+
+bool DeltaDecoder::applyPorts(const char* p, const char* end)
+{
+    quint64 changed;
+    if (!readVarint(p, end, changed)) return false;
+
+    for (quint64 i = 0; i < changed; ++i) {
+        PortKey key;
+        if (!readPortKey(p, end, key) || p >= end) return false;
+        quint8 mask = quint8(*p++);
+
+        PortInfo& info = m_ports[key];
+        info.inode = key.first;
+        info.netns = key.second;
+        info.host = m_host;
+
+        quint64 pid;
+        if (mask & FieldPid) {
+            if (!readVarint(p, end, pid)) return false;
+            info.pid = ProcessID(pid);
+        }
+        if ((mask & FieldProcessName) && !readString(p, end, info.processName)) return false;
+        if ((mask & FieldState) && !readString(p, end, info.state)) return false;
+        if (mask & FieldAddress) {
+            if (!readAddress(p, end, info)) return false;
+            info.port = info.localAddress.mid(info.localAddress.indexOf(':') + 1).toInt(nullptr, 16);
+        }
+        if ((mask & FieldNamespaceLabel) && !readString(p, end, info.namespaceLabel)) return false;
+    }
+
+    quint64 removed;
+    if (!readVarint(p, end, removed)) return false;
+    for (quint64 i = 0; i < removed; ++i) {
+        PortKey key;
+        if (!readPortKey(p, end, key)) return false;
+        m_ports.remove(key);
+    }
+
+    return p == end;
+}
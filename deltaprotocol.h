@@ -0,0 +1,102 @@
+#ifndef DELTAPROTOCOL_H
+#define DELTAPROTOCOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include "memoryanalyzer.h"
+#include "portmanager.h"
+
+// Compact binary delta protocol between agents and the aggregator
+//
+// Frame:   varint payloadLength, payload
+// Payload: quint8 type, body
+//   Hello:     string host
+//   Processes: varint changedCount, changed records, varint removedCount, removed PIDs
+//              record = varint pid, quint8 fieldMask, fields in mask order
+//              (name as string, memory values as zigzag varint delta to the last sent value)
+//   Ports:     varint changedCount, changed records, varint removedCount, removed keys
+//              record = key, quint8 fieldMask, fields (pid varint, name string, state string,
+//                       address = quint8 protocol (0 TCP, 1 UDP), string local, string remote,
+//                       namespace label string)
+//              key    = varint socket inode, varint network namespace inode
+//              Addresses can repeat (SO_REUSEPORT, the same address in two namespaces),
+//              so sockets are told apart by inode and namespace
+// string = varint byte length, UTF-8 bytes
+//
+// Both sides keep the last state per connection, only changed fields are sent.
+namespace DeltaProtocol {
+
+enum MessageType : quint8 {
+    Hello = 1,
+    Processes = 2,
+    Ports = 3
+};
+
+enum ProcessField : quint8 {
+    FieldName = 1 << 0,
+    FieldPrivate = 1 << 1,
+    FieldStack = 1 << 2,
+    FieldImage = 1 << 3,
+    FieldMapped = 1 << 4
+};
+
+enum PortField : quint8 {
+    FieldPid = 1 << 0,
+    FieldProcessName = 1 << 1,
+    FieldState = 1 << 2,
+    FieldAddress = 1 << 3,
+    FieldNamespaceLabel = 1 << 4
+};
+
+using PortKey = QPair<quint64, quint64>; // Socket inode, network namespace inode
+
+// Frames larger than this are treated as a corrupt stream
+constexpr quint64 MaxFrameSize = 64 * 1024 * 1024;
+
+void writeVarint(QByteArray& out, quint64 value);
+bool readVarint(const char*& p, const char* end, quint64& value);
+inline quint64 zigzag(qint64 v) { return (quint64(v) << 1) ^ quint64(v >> 63); }
+inline qint64 unzigzag(quint64 v) { return qint64(v >> 1) ^ -qint64(v & 1); }
+
+} // namespace DeltaProtocol
+
+// Agent side, turns full samples into delta frames
+class DeltaEncoder
+{
+public:
+    QByteArray hello(const QString& host) const;
+    QByteArray encodeProcesses(const QList<ProcessMemorySummary>& current); // Empty when nothing changed
+    QByteArray encodePorts(const QList<PortInfo>& current);                 // Empty when nothing changed
+    void reset(); // New connection, the next frames carry everything
+
+private:
+    QHash<ProcessID, ProcessMemorySummary> m_processes;
+    QHash<DeltaProtocol::PortKey, PortInfo> m_ports;
+};
+
+// Aggregator side, rebuilds the agent's state from delta frames
+class DeltaDecoder
+{
+public:
+    // Append bytes from the socket and apply every complete frame
+    // Returns false if the stream is malformed
+    bool feed(const QByteArray& data);
+
+    const QString& host() const { return m_host; }
+    const QHash<ProcessID, ProcessMemorySummary>& processes() const { return m_processes; }
+    const QHash<DeltaProtocol::PortKey, PortInfo>& ports() const { return m_ports; }
+
+private:
+    QByteArray m_buffer;
+    QString m_host;
+    QHash<ProcessID, ProcessMemorySummary> m_processes;
+    QHash<DeltaProtocol::PortKey, PortInfo> m_ports;
+
+    bool applyFrame(const char* p, const char* end);
+    bool applyProcesses(const char* p, const char* end);
+    bool applyPorts(const char* p, const char* end);
+};
+
+#endif // DELTAPROTOCOL_H
@@ -0,0 +1,308 @@
+#include "faultmonitor.h"
+#include "procfsreader.h"
+#include "systemmemory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <QSet>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+int openCounter(int tid, quint64 config, int groupFd, bool excludeKernel)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // perf_event_paranoid 2 only allows faults taken in user mode
+    attr.exclude_kernel = excludeKernel;
+    attr.exclude_hv = 1;
+    return int(syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+
+// Thread ids of a process, sorted, empty once it is gone
+std::vector<int> listThreads(ProcessID pid)
+{
+    std::vector<int> tids;
+    DIR* dir = opendir(("/proc/" + std::to_string(pid) + "/task").c_str());
+    if (!dir) return tids;
+
+    while (const dirent* entry = readdir(dir)) {
+        int tid = atoi(entry->d_name);
+        if (tid > 0) tids.push_back(tid);
+    }
+    closedir(dir);
+    std::sort(tids.begin(), tids.end());
+    return tids;
+}
+
+// minflt and majflt are fields 10 and 12, counted after the ")" closing comm
+bool parseFaults(const std::string& stat, quint64& minor, quint64& major)
+{
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) return false;
+
+    const char* p = stat.c_str() + pos + 1;
+    for (int field = 3; field <= 12; ++field) {
+        while (*p == ' ') ++p;
+        if (!*p) return false;
+        if (field == 10) minor = strtoull(p, nullptr, 10);
+        if (field == 12) major = strtoull(p, nullptr, 10);
+        while (*p && *p != ' ') ++p;
+    }
+    return true;
+}
+}
+
+FaultMonitor::FaultMonitor()
+{
+    m_clock.start();
+}
+
+FaultMonitor::~FaultMonitor()
+{
+    for (Watched& w : m_processes) close(w);
+}
+
+void FaultMonitor::setPids(const QList<ProcessID>& pids)
+{
+    const QSet<ProcessID> wanted(pids.cbegin(), pids.cend());
+    for (auto it = m_processes.begin(); it != m_processes.end();) {
+        if (wanted.contains(it.key())) {
+            ++it;
+        } else {
+            close(*it);
+            it = m_processes.erase(it);
+        }
+    }
+    for (ProcessID pid : pids) {
+        if (pid > 0 && !m_processes.contains(pid)) {
+            Watched w;
+            w.perf = m_perfAvailable;
+            m_processes.insert(pid, w);
+        }
+    }
+}
+
+int FaultMonitor::maxCounterFds()
+{
+    static const int budget = []() {
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 512;
+        const rlim_t soft = limit.rlim_cur == RLIM_INFINITY ? 65536 : limit.rlim_cur;
+        return int(std::min<rlim_t>(soft / 2, 65536));
+    }();
+    return budget;
+}
+
+bool FaultMonitor::openThread(ThreadCounters& t)
+{
+    if (m_counterFds + 2 > maxCounterFds()) return false;
+
+    m_syscalls += 2;
+    t.major = openCounter(t.tid, PERF_COUNT_SW_PAGE_FAULTS_MAJ, -1, m_excludeKernel);
+    if (t.major < 0 && !m_excludeKernel && (errno == EACCES || errno == EPERM)) {
+        // Paranoid setting or no access to the process, only the first is system wide
+        ++m_syscalls;
+        t.major = openCounter(t.tid, PERF_COUNT_SW_PAGE_FAULTS_MAJ, -1, true);
+        if (t.major >= 0) m_excludeKernel = true;
+    }
+    if (t.major < 0) {
+        // Permission errors are per process, these mean no perf at all
+        if (errno == ENOSYS || errno == ENOENT || errno == EOPNOTSUPP) m_perfAvailable = false;
+        return false;
+    }
+    t.minor = openCounter(t.tid, PERF_COUNT_SW_PAGE_FAULTS_MIN, t.major, m_excludeKernel);
+    if (t.minor < 0) {
+        ::close(t.major);
+        t.major = -1;
+        return false;
+    }
+    m_counterFds += 2;
+    return true;
+}
+
+void FaultMonitor::closeThread(ThreadCounters& t)
+{
+    if (t.minor >= 0) ::close(t.minor);
+    if (t.major >= 0) ::close(t.major);
+    if (t.major >= 0) m_counterFds -= 2;
+    t.major = t.minor = -1;
+}
+
+// One read returns the whole group: { nr, major, minor }
+// Counters of an exited thread still read back its final counts
+bool FaultMonitor::readThread(ThreadCounters& t)
+{
+    quint64 values[3] = {0, 0, 0};
+    ++m_syscalls;
+    if (read(t.major, values, sizeof(values)) != ssize_t(sizeof(values)) || values[0] != 2) return false;
+    t.lastMajor = values[1];
+    t.lastMinor = values[2];
+    return true;
+}
+
+void FaultMonitor::close(Watched& w)
+{
+    for (ThreadCounters& t : w.threads) closeThread(t);
+    w.threads.clear();
+}
+
+// Follow the thread list, open counters of new threads and retire exited ones
+bool FaultMonitor::refreshPerf(ProcessID pid, Watched& w, quint64& major, quint64& minor)
+{
+    m_syscalls += 4; // open, getdents (twice), close
+    const std::vector<int> tids = listThreads(pid);
+    if (tids.empty()) return false;
+
+    std::vector<ThreadCounters> threads;
+    threads.reserve(tids.size());
+    size_t old = 0;
+    for (int tid : tids) {
+        while (old < w.threads.size() && w.threads[old].tid < tid) {
+            ThreadCounters& gone = w.threads[old++];
+            readThread(gone);
+            w.retiredMajor += gone.lastMajor;
+            w.retiredMinor += gone.lastMinor;
+            closeThread(gone);
+        }
+        if (old < w.threads.size() && w.threads[old].tid == tid) {
+            threads.push_back(w.threads[old++]);
+            continue;
+        }
+
+        ThreadCounters t;
+        t.tid = tid;
+        if (!openThread(t)) {
+            // Mixed perf and stat counts can't be combined, give up on the process.
+            // Counters not carried over yet are closed here, the rest by the caller
+            for (; old < w.threads.size(); ++old) closeThread(w.threads[old]);
+            w.threads.swap(threads);
+            return false;
+        }
+        threads.push_back(t);
+    }
+    for (; old < w.threads.size(); ++old) {
+        ThreadCounters& gone = w.threads[old];
+        readThread(gone);
+        w.retiredMajor += gone.lastMajor;
+        w.retiredMinor += gone.lastMinor;
+        closeThread(gone);
+    }
+    w.threads.swap(threads);
+
+    major = w.retiredMajor;
+    minor = w.retiredMinor;
+    for (ThreadCounters& t : w.threads) {
+        readThread(t);
+        major += t.lastMajor;
+        minor += t.lastMinor;
+    }
+    return true;
+}
+
+FaultSample FaultMonitor::sample()
+{
+    FaultSample s;
+    m_syscalls = 0;
+
+    const qint64 nowNs = m_clock.nsecsElapsed();
+    s.intervalSec = m_lastSampleNs < 0 ? 0 : (nowNs - m_lastSampleNs) / 1e9;
+    s.valid = s.intervalSec > 0;
+    m_lastSampleNs = nowNs;
+
+    auto record = [&s](ProcessID pid, Watched& w, quint64 major, quint64 minor, bool perf) {
+        if (w.primed && s.valid) {
+            ProcessFaultRate rate;
+            rate.pid = pid;
+            rate.perf = perf;
+            rate.majorPerSec = major >= w.lastMajor ? (major - w.lastMajor) / s.intervalSec : 0;
+            rate.minorPerSec = minor >= w.lastMinor ? (minor - w.lastMinor) / s.intervalSec : 0;
+            s.majorPerSec += rate.majorPerSec;
+            s.minorPerSec += rate.minorPerSec;
+            s.processes.append(rate);
+        }
+        w.lastMajor = major;
+        w.lastMinor = minor;
+        w.primed = true;
+        perf ? ++s.perfProcesses : ++s.statProcesses;
+    };
+
+    QList<ProcessID> statPids;
+    for (auto it = m_processes.begin(); it != m_processes.end(); ++it) {
+        if (!it->perf) {
+            statPids.append(it.key());
+            continue;
+        }
+
+        quint64 major = 0;
+        quint64 minor = 0;
+        if (refreshPerf(it.key(), *it, major, minor)) {
+            record(it.key(), *it, major, minor, true);
+        } else {
+            // Counts restart from the stat file
+            close(*it);
+            it->perf = false;
+            it->primed = false;
+            statPids.append(it.key());
+        }
+    }
+
+    ProcfsReader& reader = ProcfsReader::forCurrentThread();
+    const quint64 readerSyscalls = reader.stats().syscalls;
+    for (qsizetype start = 0; start < statPids.size(); start += ProcfsReader::BatchSize) {
+        const qsizetype count = qMin<qsizetype>(ProcfsReader::BatchSize, statPids.size() - start);
+        std::vector<std::string> paths;
+        paths.reserve(size_t(count));
+        for (qsizetype k = 0; k < count; ++k) {
+            paths.push_back("/proc/" + std::to_string(statPids[start + k]) + "/stat");
+        }
+
+        std::vector<std::string> contents;
+        reader.readFiles(paths, contents);
+        for (qsizetype k = 0; k < count; ++k) {
+            quint64 major = 0;
+            quint64 minor = 0;
+            if (parseFaults(contents[size_t(k)], minor, major)) {
+                record(statPids[start + k], m_processes[statPids[start + k]], major, minor, false);
+            }
+        }
+    }
+    m_syscalls += reader.stats().syscalls - readerSyscalls;
+
+    // System reclaim, counters are in pages or events
+    const QHash<QString, qint64> vmstat = SystemMemory::readVmstat();
+    m_syscalls += 3;
+    if (s.valid && !m_lastVmstat.isEmpty()) {
+        auto rate = [&](std::initializer_list<const char*> names) {
+            qint64 delta = 0;
+            for (const char* name : names) delta += vmstat.value(name) - m_lastVmstat.value(name);
+            return delta > 0 ? delta / s.intervalSec : 0.0;
+        };
+
+        ReclaimRates& r = s.reclaim;
+        r.directScannedPerSec = rate({"pgscan_direct"});
+        r.scannedPerSec = rate({"pgscan_kswapd", "pgscan_khugepaged"}) + r.directScannedPerSec;
+        r.stolenPerSec = rate({"pgsteal_kswapd", "pgsteal_direct", "pgsteal_khugepaged"});
+        r.swapInPerSec = rate({"pswpin"});
+        r.swapOutPerSec = rate({"pswpout"});
+        // Split into anon and file since 5.9
+        r.refaultsPerSec = rate({"workingset_refault", "workingset_refault_anon", "workingset_refault_file"});
+        r.allocStallsPerSec = rate({"allocstall", "allocstall_dma", "allocstall_dma32",
+                                    "allocstall_normal", "allocstall_movable", "allocstall_device"});
+        r.majorFaultsPerSec = rate({"pgmajfault"});
+    }
+    m_lastVmstat = vmstat;
+
+    s.perfUserOnly = m_excludeKernel && s.perfProcesses > 0;
+    s.syscalls = m_syscalls;
+    return s;
+}
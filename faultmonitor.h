@@ -0,0 +1,108 @@
+#ifndef FAULTMONITOR_H
+#define FAULTMONITOR_H
+
+#include <QList>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <vector>
+#include "memoryanalyzer.h"
+
+struct ProcessFaultRate {
+    ProcessID pid = 0;
+    double minorPerSec = 0;
+    double majorPerSec = 0;
+    bool perf = false;          // Counted by perf, stat deltas otherwise
+};
+
+// System wide reclaim activity from /proc/vmstat (pages per second)
+struct ReclaimRates {
+    double scannedPerSec = 0;       // kswapd + direct
+    double directScannedPerSec = 0; // Scanned by allocating tasks, they stall meanwhile
+    double stolenPerSec = 0;        // Reclaimed
+    double swapInPerSec = 0;
+    double swapOutPerSec = 0;
+    double refaultsPerSec = 0;      // Reclaimed pages needed again soon after
+    double allocStallsPerSec = 0;
+    double majorFaultsPerSec = 0;
+};
+
+struct FaultSample {
+    bool valid = false;         // Rates need two samples
+    double intervalSec = 0;
+    double minorPerSec = 0;     // Sum over the watched processes
+    double majorPerSec = 0;
+    QList<ProcessFaultRate> processes;
+    int perfProcesses = 0;
+    int statProcesses = 0;
+    bool perfUserOnly = false;  // perf counts leave out faults taken in kernel mode
+    quint64 syscalls = 0;       // Issued by this sample
+    ReclaimRates reclaim;
+};
+
+// Page fault rates of a set of processes, plus system reclaim rates
+// Faults are counted with perf software counters: one group per thread, the
+// major fault counter leading and the minor one as member, so both come back
+// from a single read. Processes perf can't watch (no permission, fd budget
+// spent, kernel without perf) fall back to minflt/majflt deltas of their stat
+// file, read in ProcfsReader batches. Kernel mode faults (copies to and from
+// user memory in syscalls) are counted like in stat unless perf_event_paranoid
+// forbids it, then perf only counts user mode faults and the sample says so.
+// Not thread safe, sample from one thread at a time.
+class FaultMonitor
+{
+public:
+    FaultMonitor();
+    ~FaultMonitor();
+
+    FaultMonitor(const FaultMonitor&) = delete;
+    FaultMonitor& operator=(const FaultMonitor&) = delete;
+
+    // Counters of processes leaving the set are closed, new ones opened
+    void setPids(const QList<ProcessID>& pids);
+    QList<ProcessID> pids() const { return m_processes.keys(); }
+
+    FaultSample sample();
+
+    // Counter fds kept open at most, two per thread: half of the soft
+    // RLIMIT_NOFILE, the rest is left to the application
+    static int maxCounterFds();
+
+private:
+    struct ThreadCounters {
+        int tid = 0;
+        int major = -1;         // Group leader
+        int minor = -1;
+        quint64 lastMajor = 0;
+        quint64 lastMinor = 0;
+    };
+
+    struct Watched {
+        bool perf = false;
+        std::vector<ThreadCounters> threads;
+        quint64 retiredMajor = 0;   // Final counts of exited threads
+        quint64 retiredMinor = 0;
+        quint64 lastMajor = 0;
+        quint64 lastMinor = 0;
+        bool primed = false;
+    };
+
+    QHash<ProcessID, Watched> m_processes;
+    QHash<QString, qint64> m_lastVmstat;
+    QElapsedTimer m_clock;
+    qint64 m_lastSampleNs = -1;
+    int m_counterFds = 0;
+    bool m_perfAvailable = true;
+    bool m_excludeKernel = false;   // Set once paranoid refused kernel counting
+    quint64 m_syscalls = 0;
+
+    bool openThread(ThreadCounters& t);
+    void closeThread(ThreadCounters& t);
+    bool readThread(ThreadCounters& t);
+    bool refreshPerf(ProcessID pid, Watched& w, quint64& major, quint64& minor);
+    void close(Watched& w);
+};
+
+Q_DECLARE_METATYPE(FaultSample)
+
+#endif // FAULTMONITOR_H
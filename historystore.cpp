@@ -0,0 +1,794 @@
+#include "historystore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <set>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char Magic[4] = { 'M', 'Y', 'Z', 'H' };
+const uint32_t Version = 1;
+const int ColumnCount = 5; // time, pvt, stk, img, map
+const char* const ChunkSuffix = ".mhc";
+const char* const MergedSuffix = ".merged.mhc";
+const char* const SourcesSuffix = ".sources";   // Next to a merged chunk, one source file name per line
+const char* const CompactLockName = "/compact.lock";
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t startMs;
+    int64_t endMs;
+    uint32_t seriesCount;
+    uint32_t reserved;
+};
+
+// Fixed part of a series directory entry, followed by the key bytes
+struct SeriesEntry {
+    uint32_t keyLength;
+    uint32_t count;
+    int64_t minMs;
+    int64_t maxMs;
+    uint64_t offset[ColumnCount];
+    uint64_t size[ColumnCount];
+};
+
+// ### BIT PACKING ###
+class BitWriter
+{
+public:
+    void write(uint64_t value, int bits)
+    {
+        for (int i = bits - 1; i >= 0; --i) {
+            m_acc = (m_acc << 1) | ((value >> i) & 1);
+            if (++m_used == 8) {
+                m_bytes.push_back(uint8_t(m_acc));
+                m_acc = 0;
+                m_used = 0;
+            }
+        }
+    }
+
+    std::vector<uint8_t>& finish()
+    {
+        if (m_used > 0) {
+            m_bytes.push_back(uint8_t(m_acc << (8 - m_used)));
+            m_acc = 0;
+            m_used = 0;
+        }
+        return m_bytes;
+    }
+
+private:
+    std::vector<uint8_t> m_bytes;
+    uint64_t m_acc = 0;
+    int m_used = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t* data, size_t size) : m_data(data), m_bits(size * 8) {}
+
+    bool read(int bits, uint64_t& value)
+    {
+        if (m_pos + size_t(bits) > m_bits) return false;
+        value = 0;
+        for (int i = 0; i < bits; ++i, ++m_pos) {
+            value = (value << 1) | ((m_data[m_pos >> 3] >> (7 - (m_pos & 7))) & 1);
+        }
+        return true;
+    }
+
+    bool bit(bool& b)
+    {
+        uint64_t v;
+        if (!read(1, v)) return false;
+        b = v != 0;
+        return true;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_bits;
+    size_t m_pos = 0;
+};
+
+int64_t signExtend(uint64_t v, int bits)
+{
+    uint64_t sign = uint64_t(1) << (bits - 1);
+    return int64_t((v ^ sign) - sign);
+}
+
+// ### TIMESTAMP COLUMN (delta of delta) ###
+// First value raw, then the change of the delta in buckets of 7, 9, 12 or 64 bits
+void encodeTimestamps(const std::vector<HistoryPoint>& points, BitWriter& out)
+{
+    int64_t prev = 0;
+    int64_t prevDelta = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        int64_t t = points[i].timestampMs;
+        if (i == 0) {
+            out.write(uint64_t(t), 64);
+            prev = t;
+            continue;
+        }
+        int64_t delta = t - prev;
+        int64_t dod = delta - prevDelta;
+        if (dod == 0) {
+            out.write(0, 1);
+        } else if (dod >= -64 && dod <= 63) {
+            out.write(0b10, 2);
+            out.write(uint64_t(dod) & 0x7F, 7);
+        } else if (dod >= -256 && dod <= 255) {
+            out.write(0b110, 3);
+            out.write(uint64_t(dod) & 0x1FF, 9);
+        } else if (dod >= -2048 && dod <= 2047) {
+            out.write(0b1110, 4);
+            out.write(uint64_t(dod) & 0xFFF, 12);
+        } else {
+            out.write(0b1111, 4);
+            out.write(uint64_t(dod), 64);
+        }
+        prevDelta = delta;
+        prev = t;
+    }
+}
+
+bool decodeTimestamps(BitReader& in, uint32_t count, std::vector<int64_t>& out)
+{
+    out.resize(count);
+    int64_t prev = 0;
+    int64_t prevDelta = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t raw;
+        if (i == 0) {
+            if (!in.read(64, raw)) return false;
+            prev = int64_t(raw);
+            out[i] = prev;
+            continue;
+        }
+
+        // Count leading ones of the bucket prefix (at most 4)
+        int ones = 0;
+        bool b = true;
+        while (ones < 4) {
+            if (!in.bit(b)) return false;
+            if (!b) break;
+            ones++;
+        }
+
+        int64_t dod = 0;
+        static const int widths[] = { 0, 7, 9, 12, 64 };
+        if (ones > 0) {
+            if (!in.read(widths[ones], raw)) return false;
+            dod = ones == 4 ? int64_t(raw) : signExtend(raw, widths[ones]);
+        }
+
+        int64_t delta = prevDelta + dod;
+        prev += delta;
+        prevDelta = delta;
+        out[i] = prev;
+    }
+    return true;
+}
+
+// ### VALUE COLUMNS (XOR) ###
+// Each value is XORed with the previous one, only the meaningful bits are
+// stored, reusing the previous leading/trailing zero window when it fits
+void encodeValues(const std::vector<HistoryPoint>& points, int64_t HistoryPoint::*field, BitWriter& out)
+{
+    uint64_t prev = 0;
+    int prevLeading = -1;
+    int prevTrailing = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        uint64_t v = uint64_t(points[i].*field);
+        if (i == 0) {
+            out.write(v, 64);
+            prev = v;
+            continue;
+        }
+        uint64_t x = v ^ prev;
+        prev = v;
+        if (x == 0) {
+            out.write(0, 1);
+            continue;
+        }
+        out.write(1, 1);
+
+        int leading = std::min(__builtin_clzll(x), 63);
+        int trailing = __builtin_ctzll(x);
+        if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) {
+            out.write(0, 1);
+            out.write(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            out.write(1, 1);
+            out.write(uint64_t(leading), 6);
+            out.write(uint64_t(meaningful - 1), 6);
+            out.write(x >> trailing, meaningful);
+            prevLeading = leading;
+            prevTrailing = trailing;
+        }
+    }
+}
+
+bool decodeValues(BitReader& in, uint32_t count, std::vector<int64_t>& out)
+{
+    out.resize(count);
+    uint64_t prev = 0;
+    int leading = 0;
+    int trailing = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t raw;
+        if (i == 0) {
+            if (!in.read(64, raw)) return false;
+            prev = raw;
+            out[i] = int64_t(prev);
+            continue;
+        }
+        bool changed;
+        if (!in.bit(changed)) return false;
+        if (changed) {
+            bool newWindow;
+            if (!in.bit(newWindow)) return false;
+            if (newWindow) {
+                uint64_t l, m;
+                if (!in.read(6, l) || !in.read(6, m)) return false;
+                leading = int(l);
+                trailing = 64 - leading - int(m + 1);
+                if (trailing < 0) return false; // Corrupt window
+            }
+            int meaningful = 64 - leading - trailing;
+            if (!in.read(meaningful, raw)) return false;
+            prev ^= raw << trailing;
+        }
+        out[i] = int64_t(prev);
+    }
+    return true;
+}
+
+// ### MAPPED CHUNK ###
+// Read-only mapping of a chunk file, only the pages actually touched get loaded
+class MappedChunk
+{
+public:
+    struct Series {
+        std::string key;
+        const SeriesEntry* entry;
+    };
+
+    ~MappedChunk()
+    {
+        if (m_base != MAP_FAILED) munmap(m_base, m_size);
+    }
+
+    bool open(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(FileHeader)) {
+            close(fd);
+            return false;
+        }
+        m_size = size_t(st.st_size);
+        m_base = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m_base == MAP_FAILED) return false;
+
+        const FileHeader* header = static_cast<const FileHeader*>(m_base);
+        if (memcmp(header->magic, Magic, 4) != 0 || header->version != Version) return false;
+
+        // Walk the directory
+        size_t pos = sizeof(FileHeader);
+        for (uint32_t i = 0; i < header->seriesCount; ++i) {
+            if (pos + sizeof(SeriesEntry) > m_size) return false;
+            const SeriesEntry* entry = reinterpret_cast<const SeriesEntry*>(bytes() + pos);
+            pos += sizeof(SeriesEntry);
+            if (pos + entry->keyLength > m_size) return false;
+            m_series.push_back({ std::string(reinterpret_cast<const char*>(bytes() + pos), entry->keyLength), entry });
+            pos += entry->keyLength;
+            pos = (pos + 7) & ~size_t(7); // Keep entries 8-byte aligned
+        }
+        return true;
+    }
+
+    const std::vector<Series>& series() const { return m_series; }
+
+    const SeriesEntry* find(const std::string& key) const
+    {
+        for (const Series& s : m_series) {
+            if (s.key == key) return s.entry;
+        }
+        return nullptr;
+    }
+
+    // Decode one series completely
+    bool decode(const SeriesEntry* entry, std::vector<HistoryPoint>& out) const
+    {
+        std::vector<int64_t> columns[ColumnCount];
+        for (int c = 0; c < ColumnCount; ++c) {
+            if (entry->offset[c] + entry->size[c] > m_size) return false;
+            BitReader reader(bytes() + entry->offset[c], size_t(entry->size[c]));
+            bool ok = c == 0 ? decodeTimestamps(reader, entry->count, columns[c])
+                             : decodeValues(reader, entry->count, columns[c]);
+            if (!ok) return false;
+        }
+
+        out.resize(entry->count);
+        for (uint32_t i = 0; i < entry->count; ++i) {
+            out[i] = { columns[0][i], columns[1][i], columns[2][i], columns[3][i], columns[4][i] };
+        }
+        return true;
+    }
+
+private:
+    void* m_base = MAP_FAILED;
+    size_t m_size = 0;
+    std::vector<Series> m_series;
+
+    const uint8_t* bytes() const { return static_cast<const uint8_t*>(m_base); }
+};
+
+bool writeAll(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// Exclusive flock on a file, released when it goes out of scope
+class LockFile
+{
+public:
+    explicit LockFile(const std::string& path)
+    {
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (m_fd >= 0 && flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+    ~LockFile()
+    {
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    bool isLocked() const { return m_fd >= 0; }
+
+private:
+    int m_fd = -1;
+};
+
+bool isDirectory(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Whole small file, false if it cannot be read
+bool readFile(const std::string& path, std::string& content)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    content.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;
+        content.append(buffer, size_t(n));
+    }
+    close(fd);
+    return n == 0;
+}
+
+// Write a file atomically through a rename
+bool writeFileAtomic(const std::string& path, const std::string& content)
+{
+    const std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, content.data(), content.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// File names listed in the sources file of a merged chunk
+std::vector<std::string> readSources(const std::string& mergedPath)
+{
+    std::vector<std::string> names;
+    std::string content;
+    if (!readFile(mergedPath + SourcesSuffix, content)) return names;
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string::npos) end = content.size();
+        if (end > pos) names.push_back(content.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return names;
+}
+
+std::string baseName(const std::string& path)
+{
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// mkdir -p
+bool makeDirectories(const std::string& path)
+{
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos == path.size() || path[pos] == '/') {
+            std::string part = path.substr(0, pos);
+            if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+HistoryStore::HistoryStore(const std::string& directory, int64_t chunkWindowMs, OpenMode mode)
+    : m_directory(directory)
+    , m_chunkWindowMs(std::max<int64_t>(1000, chunkWindowMs))
+    , m_readOnly(mode == ReadOnly)
+{
+    m_valid = m_readOnly ? isDirectory(m_directory) : makeDirectories(m_directory);
+}
+
+HistoryStore::~HistoryStore()
+{
+    flush();
+}
+
+void HistoryStore::append(const std::string& series, const HistoryPoint& point)
+{
+    if (m_readOnly) return;
+
+    // Seal the open chunk once its window is over
+    if (m_openStartMs >= 0 && point.timestampMs >= m_openStartMs + m_chunkWindowMs) {
+        flush();
+    }
+    if (m_openStartMs < 0) {
+        m_openStartMs = point.timestampMs - point.timestampMs % m_chunkWindowMs;
+    }
+    m_buffer[series].push_back(point);
+}
+
+bool HistoryStore::flush()
+{
+    if (m_buffer.empty()) {
+        m_openStartMs = -1;
+        return true;
+    }
+
+    int64_t startMs = INT64_MAX;
+    int64_t endMs = INT64_MIN;
+    for (const auto& series : m_buffer) {
+        for (const HistoryPoint& p : series.second) {
+            startMs = std::min(startMs, p.timestampMs);
+            endMs = std::max(endMs, p.timestampMs);
+        }
+    }
+
+    bool ok = writeChunk(m_buffer, startMs, endMs);
+    m_buffer.clear();
+    m_openStartMs = -1;
+    return ok;
+}
+
+std::string HistoryStore::chunkPath(int64_t startMs, int64_t endMs, bool merged) const
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/%016lld-%016lld%s", (long long)startMs, (long long)endMs,
+             merged ? MergedSuffix : ChunkSuffix);
+    return m_directory + name;
+}
+
+// Write a sealed chunk next to the others, atomically through a rename
+bool HistoryStore::writeChunk(const std::map<std::string, std::vector<HistoryPoint>>& series,
+                              int64_t startMs, int64_t endMs, bool merged) const
+{
+    if (!m_valid || m_readOnly) return false;
+
+    // Encode every column first, offsets are known once the directory size is
+    std::vector<std::vector<uint8_t>> blobs;
+    std::vector<SeriesEntry> entries;
+    size_t directorySize = sizeof(FileHeader);
+
+    for (const auto& s : series) {
+        const std::vector<HistoryPoint>& points = s.second;
+        if (points.empty()) continue;
+
+        SeriesEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.keyLength = uint32_t(s.first.size());
+        entry.count = uint32_t(points.size());
+        entry.minMs = points.front().timestampMs;
+        entry.maxMs = points.back().timestampMs;
+
+        for (int c = 0; c < ColumnCount; ++c) {
+            BitWriter writer;
+            if (c == 0) {
+                encodeTimestamps(points, writer);
+            } else {
+                static int64_t HistoryPoint::* const fields[] = {
+                    nullptr, &HistoryPoint::pvt, &HistoryPoint::stk, &HistoryPoint::img, &HistoryPoint::map
+                };
+                encodeValues(points, fields[c], writer);
+            }
+            blobs.push_back(std::move(writer.finish()));
+        }
+
+        entries.push_back(entry);
+        directorySize += sizeof(SeriesEntry) + entry.keyLength;
+        directorySize = (directorySize + 7) & ~size_t(7);
+    }
+
+    uint64_t offset = directorySize;
+    size_t blob = 0;
+    for (SeriesEntry& entry : entries) {
+        for (int c = 0; c < ColumnCount; ++c, ++blob) {
+            entry.offset[c] = offset;
+            entry.size[c] = blobs[blob].size();
+            offset += blobs[blob].size();
+        }
+    }
+
+    // The temporary name is per process, writers can share the directory
+    std::string path = chunkPath(startMs, endMs, merged);
+    std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Magic, 4);
+    header.version = Version;
+    header.startMs = startMs;
+    header.endMs = endMs;
+    header.seriesCount = uint32_t(entries.size());
+
+    bool ok = writeAll(fd, &header, sizeof(header));
+    size_t written = sizeof(header);
+    const char zeros[8] = {};
+    size_t index = 0;
+    for (const auto& s : series) {
+        if (s.second.empty()) continue;
+        ok = ok && writeAll(fd, &entries[index], sizeof(SeriesEntry)) && writeAll(fd, s.first.data(), s.first.size());
+        written += sizeof(SeriesEntry) + s.first.size();
+        size_t padding = ((written + 7) & ~size_t(7)) - written;
+        ok = ok && writeAll(fd, zeros, padding);
+        written += padding;
+        index++;
+    }
+    for (const auto& b : blobs) {
+        ok = ok && writeAll(fd, b.data(), b.size());
+    }
+    ok = ok && fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Chunk files sorted by start time, the time range comes from the file name
+// Files listed as sources of a merged chunk are skipped, they are deleted by
+// the next compaction if the one that merged them was interrupted
+std::vector<HistoryStore::ChunkName> HistoryStore::listChunks() const
+{
+    std::vector<ChunkName> chunks;
+    DIR* dir = opendir(m_directory.c_str());
+    if (!dir) return chunks;
+
+    std::vector<ChunkName> merged;
+    while (dirent* e = readdir(dir)) {
+        long long start, end;
+        int length = 0;
+        if (sscanf(e->d_name, "%lld-%lld%n", &start, &end, &length) != 2) continue;
+
+        const char* suffix = e->d_name + length;
+        const bool isMerged = strcmp(suffix, MergedSuffix) == 0;
+        if (!isMerged && strcmp(suffix, ChunkSuffix) != 0) continue;
+        chunks.push_back({ m_directory + "/" + e->d_name, start, end, isMerged });
+        if (isMerged) merged.push_back(chunks.back());
+    }
+    closedir(dir);
+
+    std::set<std::string> superseded;
+    for (const ChunkName& m : merged) {
+        for (const std::string& name : readSources(m.path)) superseded.insert(m_directory + "/" + name);
+    }
+    if (!superseded.empty()) {
+        chunks.erase(std::remove_if(chunks.begin(), chunks.end(),
+                                    [&superseded](const ChunkName& chunk) { return superseded.count(chunk.path) > 0; }),
+                     chunks.end());
+    }
+
+    std::sort(chunks.begin(), chunks.end(), [](const ChunkName& a, const ChunkName& b) {
+        return a.startMs < b.startMs;
+    });
+    return chunks;
+}
+
+std::vector<HistoryPoint> HistoryStore::query(const std::string& series, int64_t fromMs, int64_t toMs) const
+{
+    std::vector<HistoryPoint> result;
+    std::vector<HistoryPoint> decoded;
+
+    for (const ChunkName& chunk : listChunks()) {
+        if (chunk.endMs < fromMs || chunk.startMs > toMs) continue;
+
+        MappedChunk mapped;
+        if (!mapped.open(chunk.path)) continue;
+        const SeriesEntry* entry = mapped.find(series);
+        if (!entry || entry->maxMs < fromMs || entry->minMs > toMs) continue;
+        if (!mapped.decode(entry, decoded)) continue;
+
+        for (const HistoryPoint& p : decoded) {
+            if (p.timestampMs >= fromMs && p.timestampMs <= toMs) result.push_back(p);
+        }
+    }
+
+    auto buffered = m_buffer.find(series);
+    if (buffered != m_buffer.end()) {
+        for (const HistoryPoint& p : buffered->second) {
+            if (p.timestampMs >= fromMs && p.timestampMs <= toMs) result.push_back(p);
+        }
+    }
+
+    // Chunks written by compaction or after a restart can overlap
+    std::stable_sort(result.begin(), result.end(), [](const HistoryPoint& a, const HistoryPoint& b) {
+        return a.timestampMs < b.timestampMs;
+    });
+    return result;
+}
+
+std::vector<std::string> HistoryStore::listSeries(int64_t fromMs, int64_t toMs) const
+{
+    std::set<std::string> keys;
+    for (const ChunkName& chunk : listChunks()) {
+        if (chunk.endMs < fromMs || chunk.startMs > toMs) continue;
+        MappedChunk mapped;
+        if (!mapped.open(chunk.path)) continue;
+        for (const auto& s : mapped.series()) keys.insert(s.key);
+    }
+    for (const auto& s : m_buffer) keys.insert(s.first);
+    return std::vector<std::string>(keys.begin(), keys.end());
+}
+
+// Drop chunks that lie entirely before the retention horizon
+int HistoryStore::applyRetention(int64_t nowMs, int64_t maxAgeMs)
+{
+    if (m_readOnly) return 0;
+
+    int removed = 0;
+    for (const ChunkName& chunk : listChunks()) {
+        if (chunk.endMs >= nowMs - maxAgeMs) continue;
+        if (chunk.merged) removeSources(chunk.path);
+        if (unlink(chunk.path.c_str()) == 0) removed++;
+    }
+    return removed;
+}
+
+// Delete the sources of a merged chunk, then the list of them once none is left
+int HistoryStore::removeSources(const std::string& mergedPath) const
+{
+    int removed = 0;
+    bool allGone = true;
+    for (const std::string& name : readSources(mergedPath)) {
+        const std::string path = m_directory + "/" + name;
+        if (unlink(path.c_str()) == 0) {
+            removed++;
+            if (path.size() > strlen(MergedSuffix) &&
+                path.compare(path.size() - strlen(MergedSuffix), std::string::npos, MergedSuffix) == 0) {
+                unlink((path + SourcesSuffix).c_str());
+            }
+        } else if (errno != ENOENT) {
+            allGone = false;
+        }
+    }
+    if (allGone) unlink((mergedPath + SourcesSuffix).c_str());
+    return removed;
+}
+
+// Merge chunks older than olderThanMs into one chunk per targetWindowMs
+// The source list is written before the merged chunk is renamed into place and
+// the sources are deleted after, readers skip them as soon as the chunk exists
+int HistoryStore::compact(int64_t olderThanMs, int64_t targetWindowMs)
+{
+    if (targetWindowMs <= 0 || !m_valid || m_readOnly) return 0;
+
+    // Another process compacting the same directory does the work
+    LockFile lock(m_directory + CompactLockName);
+    if (!lock.isLocked()) return 0;
+
+    std::vector<ChunkName> chunks = listChunks();
+    int removed = 0;
+
+    // Sources of a compaction that was interrupted before deleting them
+    for (const ChunkName& chunk : chunks) {
+        if (chunk.merged) removed += removeSources(chunk.path);
+    }
+
+    // Old chunks grouped by the target window they lie within
+    std::map<int64_t, std::vector<const ChunkName*>> windows;
+    for (const ChunkName& chunk : chunks) {
+        const int64_t window = chunk.startMs / targetWindowMs;
+        if (chunk.endMs < olderThanMs && chunk.endMs / targetWindowMs == window) {
+            windows[window].push_back(&chunk);
+        }
+    }
+
+    std::vector<HistoryPoint> decoded;
+    for (const auto& window : windows) {
+        const std::vector<const ChunkName*>& sources = window.second;
+        if (sources.size() < 2) continue;
+
+        std::map<std::string, std::vector<HistoryPoint>> merged;
+        int64_t startMs = INT64_MAX;
+        int64_t endMs = INT64_MIN;
+        bool ok = true;
+        for (size_t k = 0; k < sources.size() && ok; ++k) {
+            MappedChunk mapped;
+            ok = mapped.open(sources[k]->path);
+            for (size_t s = 0; ok && s < mapped.series().size(); ++s) {
+                ok = mapped.decode(mapped.series()[s].entry, decoded);
+                auto& target = merged[mapped.series()[s].key];
+                target.insert(target.end(), decoded.begin(), decoded.end());
+            }
+            startMs = std::min(startMs, sources[k]->startMs);
+            endMs = std::max(endMs, sources[k]->endMs);
+        }
+        if (!ok) continue;
+
+        for (auto& s : merged) {
+            std::stable_sort(s.second.begin(), s.second.end(), [](const HistoryPoint& a, const HistoryPoint& b) {
+                return a.timestampMs < b.timestampMs;
+            });
+        }
+
+        // A merged source with the same range is replaced by the rename
+        const std::string path = chunkPath(startMs, endMs, true);
+        std::string names;
+        for (const ChunkName* source : sources) {
+            if (source->path != path) names += baseName(source->path) + "\n";
+            if (source->merged) {
+                for (const std::string& name : readSources(source->path)) names += name + "\n";
+            }
+        }
+        if (!writeFileAtomic(path + SourcesSuffix, names)) continue;
+        if (!writeChunk(merged, startMs, endMs, true)) {
+            unlink((path + SourcesSuffix).c_str());
+            continue;
+        }
+        removed += removeSources(path);
+    }
+    return removed;
+}
@@ -0,0 +1,88 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// One sample of a series (memory in KB)
+struct HistoryPoint {
+    int64_t timestampMs = 0;
+    int64_t pvt = 0;
+    int64_t stk = 0;
+    int64_t img = 0;
+    int64_t map = 0;
+};
+
+// Append-only on-disk history of sampled category values
+//
+// Samples are buffered per series and sealed into immutable chunk files once
+// the chunk window is over. A chunk is columnar: for every series it stores a
+// timestamp column (delta-of-delta encoded) and one column per category (XOR
+// encoded), each bit packed. Readers mmap chunks and only touch the directory
+// and the columns of the series they ask for, so long ranges never have to be
+// loaded as a whole. Chunk files are named after their time range, which lets
+// queries, retention and compaction skip files without opening them.
+//
+// Compaction records the exact file names of its sources next to the merged
+// chunk before renaming it into place, and readers skip those files, so a
+// crash before they are deleted never shows a sample twice while a chunk
+// another writer seals late is left alone. It takes a lock file in the
+// directory, a GUI and an agent can share one. Retention and compaction only
+// touch files and may run on another thread than the writer.
+class HistoryStore
+{
+public:
+    enum OpenMode { ReadWrite, ReadOnly }; // ReadOnly never creates or changes files
+
+    static constexpr int64_t DefaultChunkWindowMs = 10 * 60 * 1000;
+
+    explicit HistoryStore(const std::string& directory, int64_t chunkWindowMs = DefaultChunkWindowMs,
+                          OpenMode mode = ReadWrite);
+    ~HistoryStore(); // Seals the open chunk
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    bool isValid() const { return m_valid; }
+    const std::string& directory() const { return m_directory; }
+
+    // Writing (timestamps of one series must not go backwards)
+    void append(const std::string& series, const HistoryPoint& point);
+    bool flush(); // Seal the buffered samples into a chunk now
+
+    // Reading, includes samples that are still buffered
+    std::vector<HistoryPoint> query(const std::string& series, int64_t fromMs, int64_t toMs) const;
+    std::vector<std::string> listSeries(int64_t fromMs, int64_t toMs) const;
+
+    // Maintenance
+    int applyRetention(int64_t nowMs, int64_t maxAgeMs);        // Deletes whole chunks, returns count
+    int compact(int64_t olderThanMs, int64_t targetWindowMs);   // Merges small chunks, returns chunks removed
+
+private:
+    struct ChunkName {
+        std::string path;
+        int64_t startMs = 0;
+        int64_t endMs = 0;
+        bool merged = false;    // Written by compaction
+    };
+
+    std::string m_directory;
+    int64_t m_chunkWindowMs;
+    bool m_readOnly;
+    bool m_valid = false;
+
+    // Open chunk
+    int64_t m_openStartMs = -1;
+    std::map<std::string, std::vector<HistoryPoint>> m_buffer;
+
+    // Sources of merged chunks (left behind by an interrupted compaction) are left out
+    std::vector<ChunkName> listChunks() const;
+    std::string chunkPath(int64_t startMs, int64_t endMs, bool merged) const;
+    int removeSources(const std::string& mergedPath) const;
+    bool writeChunk(const std::map<std::string, std::vector<HistoryPoint>>& series,
+                    int64_t startMs, int64_t endMs, bool merged = false) const;
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,165 @@
+#include "hugepages.h"
+#include "smaps.h"
+#include "scanarena.h"
+#include "stringpool.h"
+#include "procfsreader.h"
+#include "memoryanalyzer.h"
+#include "systemmemory.h"
+
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// sysfs selector files print every choice with the active one in brackets
+QString selectedValue(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    const QString text = QString::fromLatin1(file.readAll()).trimmed();
+    int open = text.indexOf('[');
+    int close = text.indexOf(']', open);
+    return (open >= 0 && close > open) ? text.mid(open + 1, close - open - 1) : text;
+}
+
+long readNumber(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    return file.readAll().trimmed().toLong();
+}
+
+// Value of "Key:   123 kB" in a smaps_rollup file
+qint64 rollupValue(const std::string& content, const char* key)
+{
+    size_t pos = content.find(key);
+    if (pos == std::string::npos) return 0;
+    return strtoll(content.c_str() + pos + strlen(key), nullptr, 10);
+}
+}
+
+ProcessHugePages HugePages::readProcess(ProcessID pid, qint64 largeVmaKB)
+{
+    ProcessHugePages p;
+    p.pid = pid;
+    p.name = MemoryAnalyzer::getProcessName(pid);
+
+    ScanArena::Scope scope;
+    std::vector<Vma> vmas;
+    if (!Smaps::read(pid, vmas)) return p;
+    p.ok = true;
+
+    for (const Vma& vma : vmas) {
+        p.rssKB += vma.rssKB;
+        p.anonymousKB += vma.anonymousKB;
+        p.anonHugeKB += vma.anonHugePagesKB;
+        p.shmemPmdKB += vma.shmemPmdMappedKB;
+        p.filePmdKB += vma.filePmdMappedKB;
+        p.privateHugetlbKB += vma.privateHugetlbKB;
+        p.sharedHugetlbKB += vma.sharedHugetlbKB;
+
+        if (qint64(vma.sizeKB) < largeVmaKB) continue;
+
+        HugePageVma large;
+        large.start = vma.start;
+        large.end = vma.end;
+        large.path = StringPool::internUtf8(vma.path);
+        large.sizeKB = qint64(vma.sizeKB);
+        // hugetlb pages are not part of Rss
+        large.rssKB = qint64(vma.rssKB + vma.hugetlbKB());
+        large.hugeKB = qint64(vma.anonHugePagesKB + vma.shmemPmdMappedKB + vma.filePmdMappedKB + vma.hugetlbKB());
+        large.thpEligible = vma.thpEligible;
+        if (vma.hasFlag("hg")) large.advice = "hugepage";
+        else if (vma.hasFlag("nh")) large.advice = "nohugepage";
+        p.largeVmas.append(large);
+    }
+
+    std::sort(p.largeVmas.begin(), p.largeVmas.end(), [](const HugePageVma& a, const HugePageVma& b) {
+        return a.sizeKB > b.sizeKB;
+    });
+    return p;
+}
+
+HugePageSystemReport HugePages::readSystem(int topUserCount)
+{
+    HugePageSystemReport r;
+
+    const QString thp = "/sys/kernel/mm/transparent_hugepage/";
+    r.thpEnabled = selectedValue(thp + "enabled");
+    r.thpDefrag = selectedValue(thp + "defrag");
+    r.shmemEnabled = selectedValue(thp + "shmem_enabled");
+
+    const QHash<QString, qint64> mi = SystemMemory::readMeminfo();
+    r.anonPagesKB = mi.value("AnonPages");
+    r.anonHugeKB = mi.value("AnonHugePages");
+    r.shmemHugeKB = mi.value("ShmemHugePages");
+    r.shmemPmdMappedKB = mi.value("ShmemPmdMapped");
+    r.fileHugeKB = mi.value("FileHugePages");
+    r.filePmdMappedKB = mi.value("FilePmdMapped");
+
+    // One directory per supported huge page size (hugepages-2048kB, hugepages-1048576kB)
+    QDir pools("/sys/kernel/mm/hugepages");
+    for (const QString& entry : pools.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        HugetlbPool pool;
+        pool.pageSizeKB = entry.mid(strlen("hugepages-")).chopped(2).toLongLong();
+        const QString dir = pools.absoluteFilePath(entry) + '/';
+        pool.total = readNumber(dir + "nr_hugepages");
+        pool.free = readNumber(dir + "free_hugepages");
+        pool.reserved = readNumber(dir + "resv_hugepages");
+        pool.surplus = readNumber(dir + "surplus_hugepages");
+        r.pools.append(pool);
+    }
+
+    const QHash<QString, qint64> vmstat = SystemMemory::readVmstat();
+    for (auto it = vmstat.cbegin(); it != vmstat.cend(); ++it) {
+        if (it.key().startsWith("thp_")) r.thpCounters.append({ it.key(), it.value() });
+    }
+    std::sort(r.thpCounters.begin(), r.thpCounters.end());
+
+    if (topUserCount <= 0) return r;
+
+    // smaps_rollup has the per-process totals without walking every mapping
+    const QList<ProcessID> pids = MemoryAnalyzer::listPids();
+    ProcfsReader& reader = ProcfsReader::forCurrentThread();
+    std::vector<std::string> paths;
+    std::vector<std::string> contents;
+
+    for (int i = 0; i < pids.size(); i += ProcfsReader::BatchSize) {
+        const int count = qMin<int>(ProcfsReader::BatchSize, pids.size() - i);
+        paths.clear();
+        for (int j = 0; j < count; ++j) {
+            paths.push_back("/proc/" + std::to_string(pids[i + j]) + "/smaps_rollup");
+        }
+        reader.readFiles(paths, contents);
+
+        for (int j = 0; j < count; ++j) {
+            const std::string& c = contents[j];
+            if (c.empty()) continue;
+
+            ProcessHugePages p;
+            p.pid = pids[i + j];
+            p.ok = true;
+            p.rssKB = rollupValue(c, "Rss:");
+            p.anonymousKB = rollupValue(c, "Anonymous:");
+            p.anonHugeKB = rollupValue(c, "AnonHugePages:");
+            p.shmemPmdKB = rollupValue(c, "ShmemPmdMapped:");
+            p.filePmdKB = rollupValue(c, "FilePmdMapped:");
+            p.sharedHugetlbKB = rollupValue(c, "Shared_Hugetlb:");
+            p.privateHugetlbKB = rollupValue(c, "Private_Hugetlb:");
+            if (p.thpKB() + p.hugetlbKB() > 0) r.topUsers.append(p);
+        }
+    }
+
+    auto hugeKB = [](const ProcessHugePages& p) { return p.thpKB() + p.hugetlbKB(); };
+    std::sort(r.topUsers.begin(), r.topUsers.end(), [&](const ProcessHugePages& a, const ProcessHugePages& b) {
+        return hugeKB(a) > hugeKB(b);
+    });
+    if (r.topUsers.size() > topUserCount) r.topUsers.resize(topUserCount);
+
+    for (ProcessHugePages& p : r.topUsers) {
+        p.name = MemoryAnalyzer::getProcessName(p.pid);
+    }
+    return r;
+}
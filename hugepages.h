@@ -0,0 +1,86 @@
+#ifndef HUGEPAGES_H
+#define HUGEPAGES_H
+
+#include <QString>
+#include <QList>
+#include <QMetaType>
+#include <sys/types.h>
+
+typedef pid_t ProcessID;
+
+// Huge page coverage of one large mapping (in KB)
+struct HugePageVma {
+    quint64 start = 0;
+    quint64 end = 0;
+    QString path;
+    qint64 sizeKB = 0;
+    qint64 rssKB = 0;
+    qint64 hugeKB = 0;          // AnonHugePages + ShmemPmdMapped + FilePmdMapped + hugetlb
+    bool thpEligible = false;
+    QString advice;             // "hugepage" / "nohugepage" from madvise, empty otherwise
+
+    double coverage() const { return rssKB > 0 ? double(hugeKB) / rssKB : 0.0; }
+};
+
+// Huge page usage of one process (in KB)
+struct ProcessHugePages {
+    ProcessID pid = 0;
+    QString name;
+    bool ok = false;
+    qint64 rssKB = 0;
+    qint64 anonymousKB = 0;
+    qint64 anonHugeKB = 0;
+    qint64 shmemPmdKB = 0;
+    qint64 filePmdKB = 0;
+    qint64 privateHugetlbKB = 0;
+    qint64 sharedHugetlbKB = 0;
+    QList<HugePageVma> largeVmas; // Largest first
+
+    qint64 thpKB() const { return anonHugeKB + shmemPmdKB + filePmdKB; }
+    qint64 hugetlbKB() const { return privateHugetlbKB + sharedHugetlbKB; }
+};
+
+// One hugetlbfs pool from /sys/kernel/mm/hugepages
+struct HugetlbPool {
+    qint64 pageSizeKB = 0;
+    long total = 0;
+    long free = 0;
+    long reserved = 0;
+    long surplus = 0;
+};
+
+// System-wide THP and hugetlb state
+struct HugePageSystemReport {
+    QString thpEnabled;          // Selected value of transparent_hugepage/enabled
+    QString thpDefrag;
+    QString shmemEnabled;
+    qint64 anonPagesKB = 0;
+    qint64 anonHugeKB = 0;
+    qint64 shmemHugeKB = 0;
+    qint64 shmemPmdMappedKB = 0;
+    qint64 fileHugeKB = 0;
+    qint64 filePmdMappedKB = 0;
+    QList<HugetlbPool> pools;
+    QList<QPair<QString, qint64>> thpCounters; // thp_* from /proc/vmstat
+    QList<ProcessHugePages> topUsers;          // Largest THP + hugetlb users first
+};
+
+// Transparent and hugetlbfs huge page analysis
+// Per process from smaps (every mapping above a size threshold gets its own
+// coverage), per system from meminfo, vmstat, sysfs and smaps_rollup.
+class HugePages
+{
+public:
+    static ProcessHugePages readProcess(ProcessID pid, qint64 largeVmaKB = 8 * 1024);
+
+    // topUserCount > 0 also reads smaps_rollup of every process
+    static HugePageSystemReport readSystem(int topUserCount = 10);
+
+private:
+    HugePages() = delete;
+};
+
+Q_DECLARE_METATYPE(ProcessHugePages)
+Q_DECLARE_METATYPE(HugePageSystemReport)
+
+#endif // HUGEPAGES_H
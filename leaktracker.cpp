@@ -0,0 +1,193 @@
+#include "leaktracker.h"
+
+#include <algorithm>
+
+namespace {
+const size_t None = size_t(-1);
+
+// Union find root, paths are halved on the way
+size_t findRoot(std::vector<size_t>& parent, size_t i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+}
+
+double LeakRegion::slopeKBPerHour() const
+{
+    const double n = samples;
+    const double denominator = n * sumTT - sumT * sumT;
+    if (samples < 2 || denominator <= 1e-12) return 0;
+    return (n * sumTV - sumT * sumV) / denominator;
+}
+
+double LeakRegion::sustained() const
+{
+    if (samples < 2) return 0;
+    return double(samples - 1 - shrinkingSteps) / double(samples - 1);
+}
+
+double LeakRegion::score() const
+{
+    const double slope = slopeKBPerHour();
+    return slope > 0 ? slope * sustained() : 0;
+}
+
+LeakRegion::Kind LeakTracker::kindOf(std::string_view path)
+{
+    if (path == "[heap]") return LeakRegion::Heap;
+    if (path.substr(0, 6) == "[stack") return LeakRegion::Stack;
+    if (path.empty() || path[0] == '[') return LeakRegion::Anonymous;
+    return LeakRegion::File;
+}
+
+// What a leak grows: private memory (resident or swapped) of anonymous
+// regions, resident pages of files
+uint64_t LeakTracker::valueKB(const Vma& vma)
+{
+    if (kindOf(vma.path) == LeakRegion::File) return vma.rssKB;
+    return vma.privateCleanKB + vma.privateDirtyKB + vma.swapKB;
+}
+
+void LeakTracker::reset()
+{
+    m_regions.clear();
+    m_pieces.clear();
+    m_samples = 0;
+    m_originMs = 0;
+    m_totalKB = 0;
+}
+
+// Both lists are address sorted and each is free of overlaps, so one forward
+// sweep finds every overlapping (mapping, previous piece) pair. A mapping
+// overlapping pieces of several regions joins them, the oldest region lives on.
+void LeakTracker::addSample(int64_t timestampMs, std::vector<Vma> vmas)
+{
+    std::sort(vmas.begin(), vmas.end(), [](const Vma& a, const Vma& b) { return a.start < b.start; });
+
+    if (m_samples == 0) m_originMs = timestampMs;
+    const double t = double(timestampMs - m_originMs) / (60.0 * 60 * 1000);
+
+    std::vector<size_t> parent(m_regions.size());
+    for (size_t r = 0; r < parent.size(); ++r) parent[r] = r;
+
+    std::vector<size_t> assigned(vmas.size());
+    size_t first = 0;
+    for (size_t i = 0; i < vmas.size(); ++i) {
+        const Vma& vma = vmas[i];
+        while (first < m_pieces.size() && m_pieces[first].end <= vma.start) ++first;
+
+        size_t target = None;
+        for (size_t q = first; q < m_pieces.size() && m_pieces[q].start < vma.end; ++q) {
+            size_t region = findRoot(parent, m_pieces[q].region);
+            if (region == target || m_regions[region].path != vma.path) continue;
+
+            if (target == None) {
+                target = region;
+            } else {
+                // Joined by the kernel, the older region keeps its history
+                size_t older = m_regions[region].id < m_regions[target].id ? region : target;
+                size_t newer = older == region ? target : region;
+                parent[newer] = older;
+                target = older;
+            }
+        }
+
+        if (target == None) {
+            LeakRegion region;
+            region.id = m_nextId++;
+            region.path.assign(vma.path.data(), vma.path.size());
+            region.kind = kindOf(vma.path);
+            target = m_regions.size();
+            m_regions.push_back(std::move(region));
+            parent.push_back(target);
+        }
+        assigned[i] = target;
+    }
+
+    // Sum the mappings of every surviving region
+    struct Totals {
+        uint64_t valueKB = 0;
+        uint64_t sizeKB = 0;
+        uint32_t mappings = 0;
+        uint64_t start = 0;
+        uint64_t end = 0;
+    };
+    std::vector<Totals> totals(m_regions.size());
+    m_totalKB = 0;
+    for (size_t i = 0; i < vmas.size(); ++i) {
+        const size_t root = findRoot(parent, assigned[i]);
+        assigned[i] = root;
+
+        Totals& sum = totals[root];
+        if (sum.mappings == 0) sum.start = vmas[i].start;
+        sum.end = vmas[i].end;
+        sum.valueKB += valueKB(vmas[i]);
+        sum.sizeKB += vmas[i].sizeKB;
+        ++sum.mappings;
+        m_totalKB += valueKB(vmas[i]);
+    }
+
+    // Regions without mappings were unmapped or joined into an older one
+    std::vector<LeakRegion> regions;
+    regions.reserve(m_regions.size());
+    std::vector<size_t> renumber(m_regions.size(), None);
+    for (size_t r = 0; r < m_regions.size(); ++r) {
+        const Totals& sum = totals[r];
+        if (sum.mappings == 0) continue;
+
+        LeakRegion& region = m_regions[r];
+        const double v = double(sum.valueKB);
+        if (region.samples == 0) {
+            region.firstKB = sum.valueKB;
+            region.firstSeenMs = timestampMs;
+        } else if (sum.valueKB < region.currentKB) {
+            ++region.shrinkingSteps;
+        }
+        region.currentKB = sum.valueKB;
+        region.sizeKB = sum.sizeKB;
+        region.mappings = sum.mappings;
+        region.start = sum.start;
+        region.end = sum.end;
+        region.lastSeenMs = timestampMs;
+        ++region.samples;
+        region.sumT += t;
+        region.sumV += v;
+        region.sumTT += t * t;
+        region.sumTV += t * v;
+
+        renumber[r] = regions.size();
+        regions.push_back(std::move(region));
+    }
+    m_regions.swap(regions);
+
+    m_pieces.clear();
+    m_pieces.reserve(vmas.size());
+    for (size_t i = 0; i < vmas.size(); ++i) {
+        m_pieces.push_back({ vmas[i].start, vmas[i].end, renumber[assigned[i]] });
+    }
+    ++m_samples;
+}
+
+std::vector<LeakRegion> LeakTracker::suspects(size_t limit, uint32_t minSamples) const
+{
+    std::vector<std::pair<double, size_t>> scored;
+    for (size_t r = 0; r < m_regions.size(); ++r) {
+        const double score = m_regions[r].score();
+        if (m_regions[r].samples >= minSamples && score > 0) scored.emplace_back(score, r);
+    }
+
+    const size_t count = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<LeakRegion> result;
+    result.reserve(count);
+    for (size_t k = 0; k < count; ++k) {
+        result.push_back(m_regions[scored[k].second]);
+    }
+    return result;
+}
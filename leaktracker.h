@@ -0,0 +1,91 @@
+#ifndef LEAKTRACKER_H
+#define LEAKTRACKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "smaps.h"
+
+// One region followed across samples, sizes in KB
+// A region starts as one mapping and keeps every mapping that later overlaps
+// its address range with the same path: a heap or anonymous region that grows
+// in place, a mapping that gets split by mprotect, or neighbours the kernel
+// merged into it.
+struct LeakRegion {
+    enum Kind { Heap, Anonymous, Stack, File };
+
+    uint64_t id = 0;
+    std::string path;
+    Kind kind = Anonymous;
+    uint64_t start = 0;         // Span of the mappings in the last sample
+    uint64_t end = 0;
+    uint32_t mappings = 0;
+    uint64_t sizeKB = 0;
+    uint64_t firstKB = 0;       // Private + swap for anonymous memory, Rss for files
+    uint64_t currentKB = 0;
+    int64_t firstSeenMs = 0;
+    int64_t lastSeenMs = 0;
+    uint32_t samples = 0;
+    uint32_t shrinkingSteps = 0;
+
+    // Least squares fit of the value over time (t in hours since the tracker started)
+    double sumT = 0;
+    double sumV = 0;
+    double sumTT = 0;
+    double sumTV = 0;
+
+    double slopeKBPerHour() const;
+    double sustained() const;   // Fraction of sample to sample steps that did not shrink
+    double score() const;       // Slope weighted by how sustained the growth is
+};
+
+// State of a tracking run after one sample
+struct LeakSnapshot {
+    int pid = 0;
+    bool ok = false;            // False once smaps can't be read (process gone)
+    uint32_t samples = 0;
+    size_t regions = 0;
+    uint64_t totalKB = 0;
+    int64_t firstSampleMs = 0;
+    int64_t timestampMs = 0;
+    std::vector<LeakRegion> suspects;
+};
+
+// Leak suspects of one process from per-mapping growth
+// Every sample is matched against the regions of the previous one with a
+// single sweep over both address sorted lists, so a sample costs
+// O(mappings log mappings) however long the tracking runs. A region only keeps
+// its running fit sums, not its samples.
+class LeakTracker
+{
+public:
+    void addSample(int64_t timestampMs, std::vector<Vma> vmas);
+    void reset();
+
+    // Regions with at least minSamples samples, highest score first
+    std::vector<LeakRegion> suspects(size_t limit, uint32_t minSamples = 3) const;
+
+    uint32_t samples() const { return m_samples; }
+    size_t regionCount() const { return m_regions.size(); }
+    uint64_t totalKB() const { return m_totalKB; }
+    int64_t firstSampleMs() const { return m_originMs; }
+
+    static LeakRegion::Kind kindOf(std::string_view path);
+    static uint64_t valueKB(const Vma& vma);
+
+private:
+    struct Piece {
+        uint64_t start;
+        uint64_t end;
+        size_t region;
+    };
+
+    std::vector<LeakRegion> m_regions;
+    std::vector<Piece> m_pieces;     // Mappings of the last sample, address sorted
+    uint64_t m_nextId = 1;
+    uint32_t m_samples = 0;
+    int64_t m_originMs = 0;
+    uint64_t m_totalKB = 0;
+};
+
+#endif // LEAKTRACKER_H
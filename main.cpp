@@ -1,10 +1,300 @@
 #include "mainwindow.h"
+#include "memoryanalyzer.h"
+#include "procfsreader.h"
+#include "remoteagent.h"
+#include "remoteaggregator.h"
+#include "historystore.h"
+#include "processgroup.h"
+#include "alertengine.h"
+#include "scanexecutor.h"
 
 #include <QIcon>
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+#include <QHostInfo>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QSocketNotifier>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <csignal>
+#include <memory>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Compare the synchronous and io_uring procfs readers on this host
+// Reads comm and smaps of every process once with each backend
+static int runProcfsBenchmark()
+{
+    std::vector<std::string> paths;
+    for (ProcessID pid : MemoryAnalyzer::listPids()) {
+        std::string base = "/proc/" + std::to_string(pid);
+        paths.push_back(base + "/comm");
+        paths.push_back(base + "/smaps");
+    }
+
+    for (bool useIoUring : { false, true }) {
+        ProcfsReader reader(useIoUring);
+        if (useIoUring && !reader.usingIoUring()) {
+            printf("io_uring: not available\n");
+            continue;
+        }
+
+        std::vector<std::string> contents;
+        QElapsedTimer timer;
+        timer.start();
+        reader.readFiles(paths, contents);
+        qint64 ns = timer.nsecsElapsed();
+
+        const ProcfsReader::Stats& stats = reader.stats();
+        printf("%-8s files=%llu bytes=%llu syscalls=%llu wall=%.2f ms\n",
+               reader.usingIoUring() ? "io_uring" : "sync",
+               (unsigned long long)stats.files, (unsigned long long)stats.bytes,
+               (unsigned long long)stats.syscalls, ns / 1e6);
+    }
+    return 0;
+}
+
+// Value following a command line option, or nullptr
+static const char* optionValue(int argc, char *argv[], const char* name)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// Location of the sample history shared by the GUI, the agent and the CLI
+static std::string historyDirectory()
+{
+    return (QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/memyze/history").toStdString();
+}
+
+// Time option as epoch milliseconds or ISO 8601
+static qint64 timeOption(int argc, char *argv[], const char* name, qint64 fallback)
+{
+    const char* value = optionValue(argc, argv, name);
+    if (!value) return fallback;
+
+    bool ok;
+    qint64 ms = QByteArray(value).toLongLong(&ok);
+    if (ok) return ms;
+
+    QDateTime dt = QDateTime::fromString(QString::fromLocal8Bit(value), Qt::ISODate);
+    return dt.isValid() ? dt.toMSecsSinceEpoch() : fallback;
+}
+
+// History CLI:
+//   memyze --history-list [--from <time>] [--to <time>]
+//   memyze --history-query <series> [--from <time>] [--to <time>]   (CSV on stdout)
+static int runHistoryQuery(int argc, char *argv[], const char* series)
+{
+    HistoryStore store(historyDirectory(), HistoryStore::DefaultChunkWindowMs, HistoryStore::ReadOnly);
+    qint64 from = timeOption(argc, argv, "--from", 0);
+    qint64 to = timeOption(argc, argv, "--to", INT64_MAX);
+
+    if (!series) {
+        for (const std::string& name : store.listSeries(from, to)) {
+            printf("%s\n", name.c_str());
+        }
+        return 0;
+    }
+
+    printf("timestamp_ms,private_kb,stack_kb,image_kb,mapped_kb\n");
+    for (const HistoryPoint& p : store.query(series, from, to)) {
+        printf("%lld,%lld,%lld,%lld,%lld\n", (long long)p.timestampMs, (long long)p.pvt,
+               (long long)p.stk, (long long)p.img, (long long)p.map);
+    }
+    return 0;
+}
+
+// Memory of every process matching a group rule, CSV on stdout:
+//   memyze --group "<rule>"
+// The files read to match go to stderr
+static int runGroupQuery(const char* text)
+{
+    QString error;
+    const ProcessGroupRule rule = ProcessGroupRule::compile(QString::fromLocal8Bit(text), &error);
+    if (!rule.isValid()) {
+        fprintf(stderr, "Invalid rule: %s\n", qPrintable(error));
+        return 1;
+    }
+
+    const ProcessGroupMatch matched = rule.match(MemoryAnalyzer::listPids());
+    fprintf(stderr, "%lld of %d processes matched, read stat=%d status=%d cgroup=%d cmdline=%d exe=%d\n",
+            (long long)matched.pids.size(), matched.candidates, matched.statReads, matched.statusReads,
+            matched.cgroupReads, matched.cmdlineReads, matched.exeReads);
+
+    printf("pid,name,private_kb,stack_kb,image_kb,mapped_kb\n");
+    for (qsizetype start = 0; start < matched.pids.size(); start += ProcfsReader::BatchSize) {
+        const QList<ProcessMemorySummary> batch =
+            MemoryAnalyzer::analyzePidBatch(matched.pids.mid(start, ProcfsReader::BatchSize));
+        for (const ProcessMemorySummary& s : batch) {
+            printf("%d,%s,%ld,%ld,%ld,%ld\n", s.pid, qPrintable(s.processName), s.pvt, s.stk, s.img, s.map);
+        }
+    }
+    return 0;
+}
+
+// Alert rules: --alerts <file>, else alerts.rules in the config directory when present
+static QString alertRulesPath(int argc, char *argv[])
+{
+    if (const char* path = optionValue(argc, argv, "--alerts")) return QString::fromLocal8Bit(path);
+
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/memyze/alerts.rules";
+    return QFile::exists(path) ? path : QString();
+}
+
+// SIGTERM and SIGINT quit the event loop through a socket pair, so the
+// destructors run and the recorded history is flushed
+static int terminateFds[2] = {-1, -1};
+
+static void onTerminateSignal(int)
+{
+    const char c = 1;
+    [[maybe_unused]] ssize_t n = write(terminateFds[0], &c, 1);
+}
+
+static void quitOnTerminate(QCoreApplication& app)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, terminateFds) != 0) return;
+
+    QSocketNotifier* notifier = new QSocketNotifier(terminateFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onTerminateSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+}
+
+// Headless agent: memyze --agent <aggregator-host>:<port> [--name <host>] [--interval <ms>] [--record] [--alerts <file>]
+// --record also keeps the per-process samples in the local history store,
+// alert events are printed to stdout as JSON lines
+static int runAgent(int argc, char *argv[], const char* target)
+{
+    QCoreApplication app(argc, argv);
+
+    QString address = QString::fromLocal8Bit(target);
+    int colon = address.lastIndexOf(':');
+    bool ok = false;
+    quint16 port = colon > 0 ? address.mid(colon + 1).toUShort(&ok) : 0;
+    if (!ok || port == 0) {
+        fprintf(stderr, "Usage: memyze --agent <host>:<port> [--name <name>] [--interval <ms>] [--record] [--alerts <file>]\n");
+        return 1;
+    }
+
+    const char* name = optionValue(argc, argv, "--name");
+    const char* interval = optionValue(argc, argv, "--interval");
+
+    RemoteAgent agent(address.left(colon), port,
+                      name ? QString::fromLocal8Bit(name) : QHostInfo::localHostName(),
+                      interval ? qMax(100, atoi(interval)) : 1000);
+    std::unique_ptr<HistoryStore> history;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--record") == 0 && !history) {
+            history = std::make_unique<HistoryStore>(historyDirectory());
+            agent.setHistoryStore(history.get());
+        }
+    }
+
+    AlertEngine alerts;
+    const QString rulesPath = alertRulesPath(argc, argv);
+    if (!rulesPath.isEmpty()) {
+        QStringList errors;
+        alerts.loadRules(rulesPath, &errors);
+        for (const QString& error : std::as_const(errors)) {
+            fprintf(stderr, "%s\n", qPrintable(error));
+        }
+        if (alerts.ruleCount() > 0) agent.setAlertEngine(&alerts);
+    }
+
+    quitOnTerminate(app);
+    agent.start();
+    return app.exec();
+}
+
+// Scan threads, shared by the GUI, the agent and the CLI:
+//   --scan-threads <n> --scan-nice <0-19> --scan-idle --scan-cpus <0-3,8> --scan-budget <ms per second>
+static bool configureScans(int argc, char *argv[])
+{
+    ScanExecutor::Settings settings;
+    if (const char* threads = optionValue(argc, argv, "--scan-threads")) settings.threads = qMax(1, atoi(threads));
+    if (const char* nice = optionValue(argc, argv, "--scan-nice")) settings.nice = qBound(0, atoi(nice), 19);
+    if (const char* budget = optionValue(argc, argv, "--scan-budget")) settings.cpuBudgetMs = qMax(0, atoi(budget));
+    if (const char* cpus = optionValue(argc, argv, "--scan-cpus")) {
+        if (!ScanExecutor::parseCpuList(QString::fromLocal8Bit(cpus), settings.cpus)) {
+            fprintf(stderr, "Invalid CPU list: %s\n", cpus);
+            return false;
+        }
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--scan-idle") == 0) settings.idle = true;
+    }
+
+    ScanExecutor::configure(settings);
+    return true;
+}
+
+// Off by default, enable with QT_LOGGING_RULES="memyze.startup.info=true"
+Q_LOGGING_CATEGORY(lcStartup, "memyze.startup", QtWarningMsg)
+
+// Logs how long the window took to paint for the first time
+class FirstPaintLog : public QObject
+{
+public:
+    FirstPaintLog(const QElapsedTimer& clock, QWidget* window) : m_clock(clock), m_window(window) {}
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint && watched->isWidgetType() &&
+            static_cast<QWidget*>(watched)->window() == m_window) {
+            qCInfo(lcStartup) << "First paint after" << m_clock.elapsed() << "ms";
+            QCoreApplication::instance()->removeEventFilter(this);
+        }
+        return false;
+    }
+
+private:
+    QElapsedTimer m_clock;
+    QWidget* m_window;
+};
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
+    if (!configureScans(argc, argv)) return 1;
+
+    if (argc > 1 && strcmp(argv[1], "--bench-procfs") == 0) {
+        return runProcfsBenchmark();
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--history-list") == 0) return runHistoryQuery(argc, argv, nullptr);
+    }
+    if (const char* series = optionValue(argc, argv, "--history-query")) {
+        return runHistoryQuery(argc, argv, series);
+    }
+
+    if (const char* rule = optionValue(argc, argv, "--group")) {
+        return runGroupQuery(rule);
+    }
+
+    if (const char* target = optionValue(argc, argv, "--agent")) {
+        return runAgent(argc, argv, target);
+    }
+
     QApplication a(argc, argv);
 
     QApplication::setApplicationName("memyze");
@@ -13,7 +303,26 @@ int main(int argc, char *argv[])
     QIcon appIcon(":/assets/logo.png");
     a.setWindowIcon(appIcon);
 
+    // Aggregator for multi-host mode: memyze --aggregate <port>
+    RemoteAggregator aggregator;
+    HistoryStore history(historyDirectory());
+
     MainWindow w;
+    w.setHistoryStore(&history);
+    if (const char* port = optionValue(argc, argv, "--aggregate")) {
+        if (aggregator.listen(quint16(atoi(port)))) {
+            w.setAggregator(&aggregator);
+        }
+    }
+
+    const QString rulesPath = alertRulesPath(argc, argv);
+    if (!rulesPath.isEmpty()) {
+        w.loadAlertRules(rulesPath);
+    }
+
+    FirstPaintLog firstPaint(startup, &w);
+    if (lcStartup().isInfoEnabled()) a.installEventFilter(&firstPaint);
+
     w.show();
     return a.exec();
 }
@@ -1,9 +1,14 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 #include "memoryanalyzer.h"
+#include "stringpool.h"
+#include "scanarena.h"
+#include "smaps.h"
+#include "scanexecutor.h"
 
 #include <QIntValidator>
 #include <QFileDialog>
+#include <QFile>
 #include <QProcess>
 #include <QRegularExpression>
 #include <QMessageBox>
@@ -13,9 +18,19 @@
 #include <QTimer>
 #include <QIcon>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QPixmap>
 #include <QCompleter>
 #include <QStringListModel>
 #include <QDir>
+#include <QDateTime>
+#include <QSet>
+#include <QAbstractItemView>
+#include <QStatusBar>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutexLocker>
 #include <unistd.h>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -67,17 +82,32 @@ MainWindow::MainWindow(QWidget *parent)
     processModel = new QStringListModel(this);
     processCompleter = new QCompleter(processModel, this);
     processCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    processCompleter->setFilterMode(Qt::MatchContains);
+    // Suggestions are already filtered and ranked by the search index
+    processCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
     ui->processNameLineEdit->setCompleter(processCompleter);
+    connect(ui->processNameLineEdit, &QLineEdit::textEdited, this, &MainWindow::updateProcessSuggestions);
 
-    // Refresh timers
+    // Refresh timers, the process list one starts with the memory tab
     processRefreshTimer = new QTimer(this);
+    processRefreshTimer->setInterval(2000);
     connect(processRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshProcessList);
-    processRefreshTimer->start(2000);
+
+    // CPU and memory memyze itself uses
+    overheadLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(overheadLabel);
+    lastOverhead = ScanExecutor::stats();
+    overheadClock.start();
+    QTimer* overheadTimer = new QTimer(this);
+    connect(overheadTimer, &QTimer::timeout, this, &MainWindow::updateOverheadLabel);
+    overheadTimer->start(2000);
 
     portRefreshTimer = new QTimer(this);
+    portRefreshTimer->setInterval(3000);
     connect(portRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshPortList);
 
+    rollingScanTimer = new QTimer(this);
+    connect(rollingScanTimer, &QTimer::timeout, this, &MainWindow::runRollingScanTick);
+
     // Memory Visualization
     memoryBar = new MemoryBar(this);
     QVBoxLayout *layout = qobject_cast<QVBoxLayout*>(ui->memoryBarPlaceholder->layout());
@@ -87,9 +117,13 @@ MainWindow::MainWindow(QWidget *parent)
     }
     layout->addWidget(memoryBar);
 
-    // Set port manager
-    portManager = new PortManager(this);
-    setupPortTable();
+    // Memory history below the bar
+    memoryHistory = new MemoryHistory(this);
+    layout->addWidget(memoryHistory);
+
+    // System accounting breakdown (replaces the bar in that mode)
+    setupSystemPanel();
+    setupLayoutPanel();
 
     // Set future watchers for single and multi thread analysis
     singleAnalysisWatcher = new QFutureWatcher<ProcessMemorySummary>(this);
@@ -100,52 +134,195 @@ MainWindow::MainWindow(QWidget *parent)
     connect(multiAnalysisWatcher, &QFutureWatcher<ProcessMemorySummary>::finished,
             this, &MainWindow::handleMultiAnalysisResult);
 
+    // Long scans stream partial aggregates while running
+    connect(singleAnalysisWatcher, &QFutureWatcher<ProcessMemorySummary>::resultReadyAt,
+            this, [this](int index) { handlePartialAnalysisResult(singleAnalysisWatcher, index); });
+    connect(multiAnalysisWatcher, &QFutureWatcher<ProcessMemorySummary>::resultReadyAt,
+            this, [this](int index) { handlePartialAnalysisResult(multiAnalysisWatcher, index); });
+
+    systemAccountingWatcher = new QFutureWatcher<SystemMemoryReport>(this);
+    connect(systemAccountingWatcher, &QFutureWatcher<SystemMemoryReport>::finished,
+            this, &MainWindow::handleSystemAccountingResult);
+
+    hugePageWatcher = new QFutureWatcher<HugePageResult>(this);
+    connect(hugePageWatcher, &QFutureWatcher<HugePageResult>::finished,
+            this, &MainWindow::handleHugePageResult);
+
+    numaWatcher = new QFutureWatcher<NumaReport>(this);
+    connect(numaWatcher, &QFutureWatcher<NumaReport>::finished, this, &MainWindow::handleNumaResult);
+
+    // Residency results stream in while files are scanned
+    pageCacheWatcher = new QFutureWatcher<QList<FileResidency>>(this);
+    connect(pageCacheWatcher, &QFutureWatcher<QList<FileResidency>>::resultReadyAt,
+            this, &MainWindow::handlePageCacheResult);
+    connect(pageCacheWatcher, &QFutureWatcher<QList<FileResidency>>::finished, this, [this]() {
+        ui->scanButton->setText("SCAN");
+    });
+
+    // Tracking runs until cancelled, snapshots are handed over through
+    // pendingLeakSnapshot so the future doesn't keep every one of them
+    leakWatcher = new QFutureWatcher<void>(this);
+    connect(leakWatcher, &QFutureWatcher<void>::finished, this, [this]() {
+        ui->scanButton->setText("SCAN");
+    });
+
+    addressMapWatcher = new QFutureWatcher<AddressMap>(this);
+    connect(addressMapWatcher, &QFutureWatcher<AddressMap>::finished, this, &MainWindow::handleAddressMapResult);
+
+    // One result per side, both profiled at the same time
+    compareWatcher = new QFutureWatcher<TargetProfile>(this);
+    connect(compareWatcher, &QFutureWatcher<TargetProfile>::finished, this, &MainWindow::handleCompareResult);
+
+    // Fault and reclaim rates of the scanned target, sampled off the GUI thread
+    faultWatcher = new QFutureWatcher<FaultSample>(this);
+    connect(faultWatcher, &QFutureWatcher<FaultSample>::finished, this, &MainWindow::handleFaultSample);
+    faultTimer = new QTimer(this);
+    faultTimer->setInterval(1000);
+    connect(faultTimer, &QTimer::timeout, this, &MainWindow::sampleFaults);
+
+    faultLabel = new QLabel(this);
+    faultLabel->setWordWrap(true);
+    faultLabel->setStyleSheet("color: gray; font-family: 'Consolas';");
+    faultLabel->setVisible(false);
+    ui->verticalLayout_2->insertWidget(ui->verticalLayout_2->indexOf(ui->statsGroup) + 1, faultLabel);
+
+    workingSetWatcher = new QFutureWatcher<WorkingSetReport>(this);
+    connect(workingSetWatcher, &QFutureWatcher<WorkingSetReport>::finished,
+            this, &MainWindow::handleWorkingSetResult);
+    connect(workingSetWatcher, &QFutureWatcher<WorkingSetReport>::progressValueChanged, this, [this](int elapsedMs) {
+        ui->infoLabel->setText(QString("Measuring working set of PID %1... %2 s left")
+                                   .arg(currentPID)
+                                   .arg((workingSetWatcher->progressMaximum() - elapsedMs + 999) / 1000));
+    });
+
+    // Rolling scan watcher and its options (only visible in rolling mode)
+    rollingScanWatcher = new QFutureWatcher<ShardSlice>(this);
+    connect(rollingScanWatcher, &QFutureWatcher<ShardSlice>::finished,
+            this, &MainWindow::handleRollingScanResult);
+
+    rollingScanner.setShardCount(ui->shardCountSpin->value());
+    rollingScanner.setMaxPidsPerTick(ui->maxPidsPerTickSpin->value());
+    ui->rollingOptionsWidget->setVisible(false);
+    ui->groupRuleWidget->setVisible(false);
+    connect(ui->groupRuleEdit, &QLineEdit::returnPressed, this, &MainWindow::onScanClicked);
+
+    connect(ui->shardCountSpin, QOverload<int>::of(&QSpinBox::valueChanged), [this](int count) {
+        rollingScanner.setShardCount(count);
+    });
+    connect(ui->maxPidsPerTickSpin, QOverload<int>::of(&QSpinBox::valueChanged), [this](int count) {
+        rollingScanner.setMaxPidsPerTick(count);
+    });
+    connect(ui->tickIntervalSpin, QOverload<int>::of(&QSpinBox::valueChanged), [this](int ms) {
+        rollingScanTimer->setInterval(ms);
+    });
+
     // Connect slots to ui
     connect(ui->processNameLineEdit, &QLineEdit::editingFinished, this, &MainWindow::resolvePidFromInput);
     connect(ui->scanButton, &QPushButton::clicked, this, &MainWindow::onScanClicked);
 
-    if (ui->portRefreshButton)
-        connect(ui->portRefreshButton, &QPushButton::clicked, this, &MainWindow::refreshPortList);
+    // Modes
+    ui->analysisModeCombo->clear();
+    ui->analysisModeCombo->addItem("Single Process Mode", SingleThreadMode);
+    ui->analysisModeCombo->addItem("Application Group Mode (Related PIDs)", ApplicationGroupMode);
+    ui->analysisModeCombo->addItem("Process Group Mode (Rule Based)", RuleGroupMode);
+    ui->analysisModeCombo->addItem("System-wide Mode (All Processes)", MultiThreadMode);
+    ui->analysisModeCombo->addItem("Rolling System-wide Mode (Sharded)", RollingScanMode);
+    ui->analysisModeCombo->addItem("System Accounting Mode (Kernel + User, fast)", SystemAccountingMode);
+    ui->analysisModeCombo->addItem("Huge Pages Mode (THP + hugetlb)", HugePageMode);
+    ui->analysisModeCombo->addItem("NUMA Mode (Placement per Node)", NumaMode);
+    ui->analysisModeCombo->addItem("Working Set Mode (Active vs Idle)", WorkingSetMode);
+    ui->analysisModeCombo->addItem("Page Cache Mode (Mapped File Residency)", PageCacheMode);
+    ui->analysisModeCombo->addItem("Leak Suspects Mode (Growth per Region)", LeakMode);
+    ui->analysisModeCombo->addItem("Address Space Mode (Layout Map)", LayoutMode);
+    ui->analysisModeCombo->addItem("Shared Memory Mode (Segments, Deduplicated)", SharedMemoryMode);
+    ui->analysisModeCombo->addItem("Comparison Mode (Side by Side)", CompareMode);
+    connect(ui->analysisModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onAnalysisModeChanged);
 
-    if (ui->killPortButton) {
-        connect(ui->killPortButton, &QPushButton::clicked, this, &MainWindow::onKillPortProcess);
-        connect(ui->portTableWidget->selectionModel(), &QItemSelectionModel::selectionChanged,
-                this, &MainWindow::onPortTableSelectionChanged);
-        ui->killPortButton->setEnabled(false);
+    // Process list and port table come from background walks streaming into
+    // the tabs, each tab starts its walks when first shown
+    processListWatcher = new QFutureWatcher<ProcessListBatch>(this);
+    connect(processListWatcher, &QFutureWatcher<ProcessListBatch>::resultReadyAt,
+            this, &MainWindow::handleProcessListBatch);
+    connect(processListWatcher, &QFutureWatcher<ProcessListBatch>::finished,
+            this, &MainWindow::handleProcessListFinished);
+    portListWatcher = new QFutureWatcher<QList<PortInfo>>(this);
+    connect(portListWatcher, &QFutureWatcher<QList<PortInfo>>::finished, this, &MainWindow::handlePortListResult);
+
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MainWindow::setupTab);
+    QTimer::singleShot(0, this, [this]() { setupTab(ui->tabWidget->currentIndex()); });
+}
+
+// Tabs start their subsystem the first time they are shown, so the window
+// paints before any /proc walk
+void MainWindow::setupTab(int index) {
+    QWidget* tab = ui->tabWidget->widget(index);
+
+    if (tab == ui->memoryTab && !processRefreshTimer->isActive()) {
+        processRefreshTimer->start();
+        refreshProcessList();
     }
 
-    if (ui->portAutoRefreshCheck) {
-        connect(ui->portAutoRefreshCheck, &QCheckBox::toggled, [this](bool checked) {
-            if (checked) {
-                portRefreshTimer->start(3000);
-            } else {
-                portRefreshTimer->stop();
-            }
+    if (tab == ui->portTab && !portManager) {
+        portManager = new PortManager(this);
+        setupPortTable();
+
+        if (ui->portRefreshButton)
+            connect(ui->portRefreshButton, &QPushButton::clicked, this, &MainWindow::refreshPortList);
+
+        if (ui->killPortButton) {
+            connect(ui->killPortButton, &QPushButton::clicked, this, &MainWindow::onKillPortProcess);
+            connect(ui->killAllOnPortButton, &QPushButton::clicked, this, &MainWindow::onKillAllOnPort);
+            connect(ui->killGroupButton, &QPushButton::clicked, this, &MainWindow::onKillApplicationGroup);
+            connect(ui->portTableWidget->selectionModel(), &QItemSelectionModel::selectionChanged,
+                    this, &MainWindow::onPortTableSelectionChanged);
+            ui->killPortButton->setEnabled(false);
+        }
+
+        connect(ui->tcpInfoCheck, &QCheckBox::toggled, [this](bool checked) {
+            portManager->setCollectTcpInfo(checked);
+            refreshPortList();
         });
-    }
 
-    // Modes
-    ui->analysisModeCombo->clear();
-    ui->analysisModeCombo->addItem("Single Process Mode");
-    ui->analysisModeCombo->addItem("Application Group Mode (Related PIDs)");
-    ui->analysisModeCombo->addItem("System-wide Mode (All Processes)");
-    connect(ui->analysisModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
-            this, &MainWindow::onAnalysisModeChanged);
+        // Kills finish asynchronously, results land here
+        portManager->setKillGracePeriod(ui->gracePeriodSpin->value());
+        connect(ui->gracePeriodSpin, QOverload<int>::of(&QSpinBox::valueChanged), [this](int ms) {
+            portManager->setKillGracePeriod(ms);
+        });
+        killRefreshTimer = new QTimer(this);
+        killRefreshTimer->setSingleShot(true);
+        killRefreshTimer->setInterval(500);
+        connect(killRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshPortList);
+        connect(portManager, &PortManager::processKilled, this, &MainWindow::onProcessKilled);
+        connect(portManager, &PortManager::batchKillFinished, this, &MainWindow::onBatchKillFinished);
+
+        if (ui->portAutoRefreshCheck) {
+            connect(ui->portAutoRefreshCheck, &QCheckBox::toggled, [this](bool checked) {
+                // Port rules keep the walk going with auto refresh off
+                if (checked || alertEngine.hasRules(AlertTargetKind::Port)) {
+                    portRefreshTimer->start();
+                } else {
+                    portRefreshTimer->stop();
+                }
+            });
+        }
 
-    // INITIAL LOAD
-    refreshProcessList();
-    refreshPortList();
+        refreshPortList();
+    }
 }
 
 MainWindow::~MainWindow() {
     // Stop timers and running futures
     if (processRefreshTimer) processRefreshTimer->stop();
     if (portRefreshTimer) portRefreshTimer->stop();
+    if (rollingScanTimer) rollingScanTimer->stop();
+    if (faultTimer) faultTimer->stop();
     cleanupWatchers();
 }
 
 // Cleans up the watchers
 void MainWindow::cleanupWatchers() {
+    historyMaintenance.waitForFinished();
     if (singleAnalysisWatcher && singleAnalysisWatcher->isRunning()) {
         singleAnalysisWatcher->cancel();
         singleAnalysisWatcher->waitForFinished();
@@ -154,39 +331,229 @@ void MainWindow::cleanupWatchers() {
         multiAnalysisWatcher->cancel();
         multiAnalysisWatcher->waitForFinished();
     }
+    if (rollingScanWatcher && rollingScanWatcher->isRunning()) {
+        rollingScanWatcher->waitForFinished();
+    }
+    if (systemAccountingWatcher && systemAccountingWatcher->isRunning()) {
+        systemAccountingWatcher->waitForFinished();
+    }
+    if (leakWatcher && leakWatcher->isRunning()) {
+        leakWatcher->cancel();
+        leakWatcher->waitForFinished();
+    }
+    if (compareWatcher && compareWatcher->isRunning()) {
+        compareWatcher->cancel();
+        compareWatcher->waitForFinished();
+    }
+    if (addressMapWatcher && addressMapWatcher->isRunning()) {
+        addressMapWatcher->waitForFinished();
+    }
+    if (faultWatcher && faultWatcher->isRunning()) {
+        faultWatcher->waitForFinished();
+    }
+    if (processListWatcher && processListWatcher->isRunning()) {
+        processListWatcher->cancel();
+        processListWatcher->waitForFinished();
+    }
+    if (portListWatcher && portListWatcher->isRunning()) {
+        portListWatcher->waitForFinished();
+    }
+    // The estimate sleeps through its window, only cancelling stops it early
+    if (workingSetWatcher && workingSetWatcher->isRunning()) {
+        workingSetWatcher->cancel();
+        workingSetWatcher->waitForFinished();
+    }
+    if (pageCacheWatcher && pageCacheWatcher->isRunning()) {
+        pageCacheWatcher->cancel();
+        pageCacheWatcher->waitForFinished();
+    }
+    if (numaWatcher && numaWatcher->isRunning()) {
+        numaWatcher->waitForFinished();
+    }
+    if (hugePageWatcher && hugePageWatcher->isRunning()) {
+        hugePageWatcher->waitForFinished();
+    }
 }
 
 // proc is a virtual file system in linux that contains all the insformation
 // about every running process with each process having its own folder (named after its PID)
 // Refresh procees list
+// The search index is updated incrementally, only new processes get their
+// command line read, known ones only refresh their memory
 void MainWindow::refreshProcessList() {
-    QVector<ProcessInfo> list;
-    QDir procDir("/proc");
-
-    if (!procDir.exists()) {
-        qWarning() << "Cannot access /proc directory";
-        return;
+    // Skipped while the previous walk is still running
+    if (processListWatcher->isRunning()) return;
+
+    QHash<ProcessID, quint64> known;
+    const QList<ProcessID> indexed = processIndex.pids();
+    known.reserve(indexed.size());
+    for (ProcessID pid : indexed) {
+        known.insert(pid, processIndex.startTimeOf(pid));
     }
 
-    // Store name and PID for all processes through /proc
-    for (const QString& entry : procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-        bool ok;
-        int pid = entry.toInt(&ok);
-        if (ok && pid > 0) {
-            QString name = MemoryAnalyzer::getProcessName(pid);
-            if (!name.isEmpty()) {
-                list.push_back({name, pid});
-            }
+    pendingProcessList.clear();
+    processListWatcher->setFuture(ScanExecutor::run(&readProcessList, known));
+}
+
+// Batches go into the index as they arrive, the first load also fills the
+// process list right away so the tab is usable while the walk runs
+void MainWindow::handleProcessListBatch(int index) {
+    if (processListWatcher->isCanceled()) return;
+
+    const ProcessListBatch batch = processListWatcher->resultAt(index);
+    for (const ProcessListEntry& p : batch) {
+        if (p.known) {
+            processIndex.setMemory(p.pid, p.rssKB);
+        } else {
+            processIndex.upsert(p.pid, p.startTime, p.name, p.commandLine, p.rssKB);
         }
+        pendingProcessList.push_back({p.name, p.pid});
     }
-    processCache = list;
+
+    if (!processListLoaded) processCache = pendingProcessList;
+}
+
+void MainWindow::handleProcessListFinished() {
+    if (processListWatcher->isCanceled() || pendingProcessList.isEmpty()) return;
+
+    // Drop processes that are gone
+    QSet<ProcessID> alive;
+    alive.reserve(pendingProcessList.size());
+    for (const ProcessInfo& p : std::as_const(pendingProcessList)) {
+        alive.insert(p.pid);
+    }
+    const QList<ProcessID> indexed = processIndex.pids();
+    for (ProcessID pid : indexed) {
+        if (!alive.contains(pid)) processIndex.remove(pid);
+    }
+
+    processCache.swap(pendingProcessList);
+    pendingProcessList.clear();
+    processListLoaded = true;
+
+    // Names of processes that are gone are now only held by the pool
+    StringPool::collect();
+
+    // Targets not scanned for an hour are forgotten
+    raiseAlerts(alertEngine.prune(QDateTime::currentMSecsSinceEpoch() - 60 * 60 * 1000));
+}
+
+// Query the search index for the text typed so far
+void MainWindow::updateProcessSuggestions(const QString& text) {
+    const auto matches = processIndex.query(text, 50);
 
     QStringList names;
-    names.reserve(processCache.size());
-    for (const auto& p : std::as_const(processCache)) {
-        names << QString("%1 (PID %2)").arg(p.name).arg(p.pid);
+    names.reserve(matches.size());
+    for (const auto& m : matches) {
+        names << QString("%1 (PID %2)").arg(m.name).arg(m.pid);
     }
     processModel->setStringList(names);
+
+    if (names.isEmpty()) {
+        processCompleter->popup()->hide();
+    } else {
+        processCompleter->complete();
+    }
+}
+
+namespace {
+// Modes showing the table panel instead of the memory bar
+bool usesPanel(AnalysisMode mode) {
+    switch (mode) {
+    case SystemAccountingMode:
+    case HugePageMode:
+    case NumaMode:
+    case WorkingSetMode:
+    case PageCacheMode:
+    case LeakMode:
+    case SharedMemoryMode:
+    case CompareMode:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Name, start time and RSS of every process, the command line only of the
+// ones the index doesn't know yet. Batches stream out while /proc is walked.
+void readProcessList(QPromise<ProcessListBatch>& promise, const QHash<ProcessID, quint64>& known) {
+    const QList<ProcessID> pids = MemoryAnalyzer::listPids();
+
+    ProcessListBatch batch;
+    QElapsedTimer sinceLastResult;
+    sinceLastResult.start();
+    for (ProcessID pid : pids) {
+        ProcessStat stat;
+        if (!MemoryAnalyzer::readStat(pid, stat) || stat.name.isEmpty()) continue;
+
+        ProcessListEntry entry;
+        entry.pid = pid;
+        entry.startTime = stat.startTime;
+        entry.name = stat.name;
+        entry.rssKB = stat.rssKB;
+        auto it = known.constFind(pid);
+        entry.known = it != known.cend() && it.value() == stat.startTime;
+        if (!entry.known) entry.commandLine = MemoryAnalyzer::getCommandLine(pid);
+        batch.append(entry);
+
+        if (sinceLastResult.elapsed() >= MemoryAnalyzer::PartialResultIntervalMs) {
+            promise.addResult(batch);
+            batch.clear();
+            sinceLastResult.restart();
+
+            ScanExecutor::checkpoint([&promise]() { return promise.isCanceled(); });
+            if (promise.isCanceled()) return;
+        }
+    }
+    promise.addResult(batch);
+}
+
+// Sample smaps of a process every intervalMs until cancelled or the process is gone
+// Every snapshot goes to publish, nothing is kept in the future
+void trackLeaks(QPromise<void>& promise, ProcessID pid, int intervalMs,
+                const std::function<void(LeakSnapshot&&)>& publish) {
+    LeakTracker tracker;
+    while (!promise.isCanceled()) {
+        LeakSnapshot snapshot;
+        snapshot.pid = pid;
+        {
+            ScanArena::Scope scope;
+            std::vector<Vma> vmas;
+            snapshot.ok = Smaps::read(pid, vmas);
+            if (snapshot.ok) tracker.addSample(QDateTime::currentMSecsSinceEpoch(), std::move(vmas));
+        }
+        snapshot.samples = tracker.samples();
+        snapshot.regions = tracker.regionCount();
+        snapshot.totalKB = tracker.totalKB();
+        snapshot.firstSampleMs = tracker.firstSampleMs();
+        snapshot.timestampMs = QDateTime::currentMSecsSinceEpoch();
+        snapshot.suspects = tracker.suspects(50);
+        const bool ok = snapshot.ok;
+        publish(std::move(snapshot));
+        if (!ok) return;
+
+        ScanExecutor::checkpoint();
+
+        // Wait in small steps so a cancel is picked up quickly, the thread
+        // is free for other scans meanwhile
+        ScanExecutor::Idle idle;
+        QElapsedTimer waited;
+        waited.start();
+        while (waited.elapsed() < intervalMs && !promise.isCanceled()) {
+            QThread::msleep(quint64(qMin<qint64>(100, intervalMs - waited.elapsed())));
+        }
+    }
+}
+}
+
+// PID from the name search or the PID field, whichever is shown
+ProcessID MainWindow::selectedPid() {
+    if (ui->stackedWidget->currentIndex() == 0) {
+        resolvePidFromInput();
+    } else {
+        currentPID = ui->pidLineEdit->text().toInt();
+    }
+    return currentPID;
 }
 
 // Set the process user has selected
@@ -203,61 +570,336 @@ void MainWindow::resolvePidFromInput() {
 
 // Change analysis mode
 void MainWindow::onAnalysisModeChanged(int index) {
-    if (index == 0) {
-        currentMode = SingleThreadMode;
+    AnalysisMode mode = AnalysisMode(ui->analysisModeCombo->itemData(index).toInt());
+
+    // Leaving rolling mode stops the background ticks
+    if (currentMode == RollingScanMode && mode != RollingScanMode) {
+        stopRollingScan();
+    }
+    ui->rollingOptionsWidget->setVisible(mode == RollingScanMode);
+
+    // Leak tracking would keep drawing into the shared panel
+    if (currentMode == LeakMode && mode != LeakMode && leakWatcher->isRunning()) {
+        leakWatcher->cancel();
+    }
+    ui->groupRuleWidget->setVisible(mode == RuleGroupMode);
+
+    // History of a different target would be meaningless, fault rates too
+    memoryHistory->clear();
+    setFaultTarget(nullptr);
+    currentMode = mode;
+    showSystemPanel(usesPanel(mode));
+    showLayoutPanel(mode == LayoutMode);
+    systemDrillDownButton->setVisible(mode == SystemAccountingMode);
+    workingSetOptions->setVisible(mode == WorkingSetMode);
+    leakOptions->setVisible(mode == LeakMode);
+    compareOptions->setVisible(mode == CompareMode);
+
+    switch (mode) {
+    case SingleThreadMode:
         ui->infoLabel->setText("Single Process Mode: Analyzing only the selected process");
-    } else if (index == 1) {
-        currentMode = ApplicationGroupMode;
+        break;
+    case ApplicationGroupMode:
         ui->infoLabel->setText("Application Group Mode: Analyzing selected process and all related processes");
-    } else {
-        currentMode = MultiThreadMode;
+        break;
+    case RuleGroupMode:
+        ui->infoLabel->setText("Process Group Mode: Analyzing every process matching the rule");
+        break;
+    case MultiThreadMode:
         ui->infoLabel->setText("System-wide Mode: Analyzing all accessible processes");
+        break;
+    case RollingScanMode:
+        ui->infoLabel->setText("Rolling Mode: Analyzing one shard of the process table per tick");
+        break;
+    case SystemAccountingMode:
+        ui->infoLabel->setText("System Accounting Mode: Complete breakdown of RAM including kernel memory");
+        break;
+    case HugePageMode:
+        ui->infoLabel->setText("Huge Pages Mode: THP and hugetlb usage of the selected process and the system");
+        break;
+    case NumaMode:
+        ui->infoLabel->setText("NUMA Mode: Memory per node of the selected process and processes running away from their memory");
+        break;
+    case WorkingSetMode:
+        ui->infoLabel->setText("Working Set Mode: Memory of the selected process touched within the window");
+        break;
+    case PageCacheMode:
+        ui->infoLabel->setText("Page Cache Mode: How much of every file mapped by the selected process is cached");
+        break;
+    case LeakMode:
+        ui->infoLabel->setText("Leak Suspects Mode: Regions of the selected process growing steadily over time");
+        break;
+    case LayoutMode:
+        ui->infoLabel->setText("Address Space Mode: Layout of every mapping of the selected process, wheel to zoom, drag to pan");
+        break;
+    case SharedMemoryMode:
+        ui->infoLabel->setText("Shared Memory Mode: SysV, /dev/shm and memfd segments of all processes, each counted once");
+        break;
+    case CompareMode:
+        ui->infoLabel->setText("Comparison Mode: Two processes, groups or captures side by side, per category and per library");
+        break;
+    case RemoteAggregateMode:
+        ui->infoLabel->setText(QString("Remote Hosts Mode: %1 agents connected").arg(aggregator ? aggregator->hosts().size() : 0));
+        break;
     }
 }
 
 // slot for SCAN BUTTON CLICKED
 void MainWindow::onScanClicked() {
-    ui->scanButton->setEnabled(false);
+    // Remote data arrives on its own, a scan only redraws the current aggregate
+    if (currentMode == RemoteAggregateMode) {
+        onAggregatorUpdated();
+        return;
+    }
 
-    if (currentMode == SingleThreadMode || currentMode == ApplicationGroupMode) {
-        // Get PID
-        if (ui->stackedWidget->currentIndex() == 0) {
-            resolvePidFromInput();
+    // Rolling mode runs continuously, the button toggles it
+    if (currentMode == RollingScanMode) {
+        if (rollingScanTimer->isActive()) {
+            stopRollingScan();
         } else {
-            currentPID = ui->pidLineEdit->text().toInt();
+            startRollingScan();
+        }
+        return;
+    }
+
+    // Only a few small files are read, no need for cancellation
+    if (currentMode == SystemAccountingMode) {
+        if (!systemAccountingWatcher->isRunning()) {
+            systemAccountingWatcher->setFuture(ScanExecutor::run([]() {
+                return SystemMemory::read(10);
+            }));
+        }
+        return;
+    }
+
+    // Without a selected process only the system side is shown
+    if (currentMode == HugePageMode) {
+        if (!hugePageWatcher->isRunning()) {
+            hugePageWatcher->setFuture(ScanExecutor::run([](ProcessID pid) {
+                ProcessHugePages process = pid > 0 ? HugePages::readProcess(pid) : ProcessHugePages();
+                return HugePageResult(process, HugePages::readSystem(10));
+            }, selectedPid()));
         }
+        return;
+    }
 
-        if (currentPID <= 0) {
+    // Reads numa_maps of every process, spread over the thread pool
+    if (currentMode == NumaMode) {
+        if (!numaWatcher->isRunning()) {
+            ui->infoLabel->setText("Reading NUMA placement of every process...");
+            numaWatcher->setFuture(ScanExecutor::run([](ProcessID pid) {
+                return Numa::read(pid, true);
+            }, selectedPid()));
+        }
+        return;
+    }
+
+    // Runs in small CPU budgeted steps, a second click cancels it
+    if (currentMode == PageCacheMode) {
+        if (pageCacheWatcher->isRunning()) {
+            pageCacheWatcher->cancel();
+            ui->infoLabel->setText("Page cache scan cancelled");
+            return;
+        }
+        if (selectedPid() <= 0) {
             ui->infoLabel->setText("Error: Select a valid process first.");
+            return;
+        }
+
+        ui->scanButton->setText("CANCEL");
+        ui->infoLabel->setText(QString("Scanning page cache residency of PID %1...").arg(currentPID));
+        pageCacheWatcher->setFuture(ScanExecutor::run([](QPromise<QList<FileResidency>>& promise, ProcessID pid) {
+            PageCacheScanner::scan(promise, pid);
+        }, currentPID));
+        return;
+    }
+
+    // Samples until stopped, the ranking sharpens with every sample
+    if (currentMode == LeakMode) {
+        if (leakWatcher->isRunning()) {
+            leakWatcher->cancel();
+            ui->infoLabel->setText("Leak tracking stopped");
+            return;
+        }
+        if (selectedPid() <= 0) {
+            ui->infoLabel->setText("Error: Select a valid process first.");
+            return;
+        }
+
+        ui->scanButton->setText("STOP");
+        ui->infoLabel->setText(QString("Tracking regions of PID %1...").arg(currentPID));
+        // Only the latest snapshot is kept, the GUI is told to pick it up
+        auto publish = [this](LeakSnapshot&& snapshot) {
+            {
+                QMutexLocker lock(&leakSnapshotMutex);
+                pendingLeakSnapshot = std::move(snapshot);
+            }
+            QMetaObject::invokeMethod(this, [this]() { handleLeakSnapshot(); }, Qt::QueuedConnection);
+        };
+        leakWatcher->setFuture(ScanExecutor::run(&trackLeaks, currentPID, leakIntervalSpin->value() * 1000,
+                                                 std::function<void(LeakSnapshot&&)>(publish)));
+        return;
+    }
+
+    // One smaps read, the map is built off the GUI thread as well
+    if (currentMode == LayoutMode) {
+        if (addressMapWatcher->isRunning()) return;
+        if (selectedPid() <= 0) {
+            ui->infoLabel->setText("Error: Select a valid process first.");
+            return;
+        }
+
+        ui->infoLabel->setText(QString("Reading address space of PID %1...").arg(currentPID));
+        addressMapWatcher->setFuture(ScanExecutor::run([](ProcessID pid, bool compact) {
+            AddressMap map;
+            map.setCompactGaps(compact);
+            ScanArena::Scope scope;
+            std::vector<Vma> vmas;
+            if (Smaps::read(pid, vmas)) map.build(pid, vmas);
+            return map;
+        }, currentPID, compactGapsCheck->isChecked()));
+        return;
+    }
+
+    // Both sides are profiled at the same time, a second click cancels
+    if (currentMode == CompareMode) {
+        if (compareWatcher->isRunning()) {
+            compareWatcher->cancel();
+            ui->infoLabel->setText("Comparison cancelled");
+            return;
+        }
+
+        // The selected process is the default left side
+        if (compareEdits[0]->text().trimmed().isEmpty() && selectedPid() > 0) {
+            compareEdits[0]->setText(QString::number(currentPID));
+        }
+
+        QList<CompareTarget> targets;
+        for (QLineEdit* edit : compareEdits) {
+            QString error;
+            targets.append(CompareTarget::parse(edit->text(), &error));
+            if (!error.isEmpty()) {
+                ui->infoLabel->setText("Error: " + error);
+                return;
+            }
+        }
+
+        ui->scanButton->setText("CANCEL");
+        ui->infoLabel->setText(QString("Comparing %1 with %2...").arg(targets[0].text, targets[1].text));
+        compareClock.start();
+        compareWatcher->setFuture(QtConcurrent::mapped(ScanExecutor::pool(), std::move(targets), &Comparison::profile));
+        return;
+    }
+
+    // The window can be long, a second click cancels it
+    if (currentMode == WorkingSetMode) {
+        if (workingSetWatcher->isRunning()) {
+            workingSetWatcher->cancel();
+            ui->infoLabel->setText("Working set measurement cancelled");
+            return;
+        }
+        if (selectedPid() <= 0) {
+            ui->infoLabel->setText("Error: Select a valid process first.");
+            return;
+        }
+
+        ui->scanButton->setText("CANCEL");
+        workingSetWatcher->setFuture(ScanExecutor::run(&WorkingSetEstimator::estimate,
+                                                       currentPID, workingSetWindowSpin->value() * 1000));
+        return;
+    }
+
+    // A click while a group or system-wide scan runs cancels it
+    if (singleAnalysisWatcher->isRunning() || multiAnalysisWatcher->isRunning()) {
+        singleAnalysisWatcher->cancel();
+        multiAnalysisWatcher->cancel();
+        ui->infoLabel->setText("Analysis cancelled");
+        return;
+    }
+
+    ui->scanButton->setEnabled(false);
+
+    // Only processes matching the rule on cheap fields get their smaps read
+    if (currentMode == RuleGroupMode) {
+        QString error;
+        const ProcessGroupRule rule = ProcessGroupRule::compile(ui->groupRuleEdit->text(), &error);
+        if (!rule.isValid()) {
+            ui->infoLabel->setText("Error: " + error);
             ui->scanButton->setEnabled(true);
             return;
         }
 
+        if (rule.text() != historyGroupRule) {
+            memoryHistory->clear();
+            historyGroupRule = rule.text();
+        }
+
+        // Matching again now and then picks up processes started later
+        setFaultTarget([rule]() { return rule.match(MemoryAnalyzer::listPids()).pids; });
+
+        ui->infoLabel->setText(QString("Matching processes against \"%1\"...").arg(rule.text()));
+        singleAnalysisWatcher->setFuture(ScanExecutor::run([](QPromise<ProcessMemorySummary>& promise,
+                                                              const ProcessGroupRule& rule) {
+            ProcessGroupRule::analyze(promise, rule, QString("Group: %1").arg(rule.text()));
+        }, rule));
+
+        ui->scanButton->setText("CANCEL");
+        ui->scanButton->setEnabled(true);
+        return;
+    }
+
+    if (currentMode == SingleThreadMode || currentMode == ApplicationGroupMode) {
+        if (selectedPid() <= 0) {
+            ui->infoLabel->setText("Error: Select a valid process first.");
+            ui->scanButton->setEnabled(true);
+            return;
+        }
+
+        if (currentPID != historyPID) {
+            memoryHistory->clear();
+            historyPID = currentPID;
+        }
+
         if (currentMode == SingleThreadMode) {
             ui->infoLabel->setText(QString("Analyzing single PID %1...").arg(currentPID));
         } else {
             ui->infoLabel->setText(QString("Analyzing PID %1 and related processes...").arg(currentPID));
         }
 
+        if (currentMode == SingleThreadMode) {
+            setFaultTarget([pid = currentPID]() { return QList<ProcessID>{pid}; });
+        } else {
+            setFaultTarget([pid = currentPID]() { return MemoryAnalyzer::findRelatedPids(pid); });
+        }
+
         // Cancel any existing analysis
         if (singleAnalysisWatcher->isRunning()) {
             singleAnalysisWatcher->cancel();
             singleAnalysisWatcher->waitForFinished();
         }
 
-        // Run async analysis
-        auto future = QtConcurrent::run([](int pid, bool groupMode) {
-            if (groupMode) {
-                // Analyze the all related PIDs (application group)
-                return MemoryAnalyzer::analyzeApplication(pid);
-            } else {
-                // Analyze ONLY the single PID
+        // Run async analysis, group mode streams partial results and can be cancelled
+        QFuture<ProcessMemorySummary> future;
+        if (currentMode == ApplicationGroupMode) {
+            // Analyze the all related PIDs (application group)
+            future = ScanExecutor::run([](QPromise<ProcessMemorySummary>& promise, int pid) {
+                MemoryAnalyzer::analyzeApplication(promise, pid);
+            }, currentPID);
+        } else {
+            // Analyze ONLY the single PID
+            future = ScanExecutor::run([](int pid) {
                 return MemoryAnalyzer::analyzeSinglePid(pid);
-            }
-        }, currentPID, currentMode == ApplicationGroupMode);
+            }, currentPID);
+        }
 
         singleAnalysisWatcher->setFuture(future);
 
+        // Group scans can take a while, let the button cancel them
+        if (currentMode == ApplicationGroupMode) {
+            ui->scanButton->setText("CANCEL");
+            ui->scanButton->setEnabled(true);
+        }
+
     } else {
         // Analye ALL processes
         QList<int> pids;
@@ -280,64 +922,980 @@ void MainWindow::onScanClicked() {
             multiAnalysisWatcher->waitForFinished();
         }
 
-        auto future = QtConcurrent::run([pids]() {
-            ProcessMemorySummary total;
-            total.processName = "System-wide Analysis";
-
-            for (int pid : pids) {
-                // se PSS (Proportional Set Size) to avoid double-counting shared memory
-                ProcessMemorySummary s = MemoryAnalyzer::analyzeSinglePid(pid, true);
-                total.pvt += s.pvt;
-                total.stk += s.stk;
-                total.img += s.img;
-                total.map += s.map;
-            }
-            total.total = total.pvt + total.stk + total.img + total.map;
-            return total;
-        });
+        // Use PSS (Proportional Set Size) to avoid double-counting shared memory
+        // Shared memory segments are collected from the same smaps reads
+        sharedMemoryResult = std::make_shared<SharedMemoryReport>();
+        auto future = ScanExecutor::run([](QPromise<ProcessMemorySummary>& promise, const QList<int>& pids,
+                                           std::shared_ptr<SharedMemoryReport> shared) {
+            SharedMemoryScan scan;
+            MemoryAnalyzer::analyzePids(promise, pids, "System-wide Analysis", true, &scan);
+            if (!promise.isCanceled()) *shared = scan.finish();
+        }, pids, sharedMemoryResult);
 
         multiAnalysisWatcher->setFuture(future);
+        ui->scanButton->setText("CANCEL");
+        ui->scanButton->setEnabled(true);
     }
 }
 
 // RESULT HANDLERS after analysis
 // Single PID
 void MainWindow::handleSingleAnalysisResult() {
+    ui->scanButton->setText("SCAN");
     if (singleAnalysisWatcher->isCanceled()) {
         ui->scanButton->setEnabled(true);
         return;
     }
 
-    ProcessMemorySummary s = singleAnalysisWatcher->result();
+    QFuture<ProcessMemorySummary> future = singleAnalysisWatcher->future();
+    if (future.resultCount() == 0) {
+        ui->scanButton->setEnabled(true);
+        return;
+    }
+
+    ProcessMemorySummary s = future.resultAt(future.resultCount() - 1);
     updateUIWithStats(s);
+    if (currentMode == RuleGroupMode) {
+        ui->infoLabel->setText(QString("Group Analysis Complete: %1 matching processes - %2")
+                                   .arg(singleAnalysisWatcher->progressMaximum())
+                                   .arg(MemoryAnalyzer::formatMemory(s.total)));
+        ui->scanButton->setEnabled(true);
+        return;
+    }
     ui->infoLabel->setText(QString("Analysis Complete: %1 (PID %2) - %3")
                                .arg(s.processName)
                                .arg(currentPID)
-                               .arg(formatMemory(s.total)));
+                               .arg(MemoryAnalyzer::formatMemory(s.total)));
     ui->scanButton->setEnabled(true);
 }
 
+// Partial aggregate streamed by a running scan
+// Only the bar is updated, change labels keep comparing complete scans
+void MainWindow::handlePartialAnalysisResult(QFutureWatcher<ProcessMemorySummary>* watcher, int index) {
+    if (!watcher || watcher->isCanceled()) return;
+
+    ProcessMemorySummary s = watcher->resultAt(index);
+    memoryBar->setValues(s.pvt, s.stk, s.img, s.map);
+
+    int total = watcher->progressMaximum();
+    if (total > 0) {
+        ui->infoLabel->setText(QString("Analyzing %1/%2 processes... %3 so far")
+                                   .arg(watcher->progressValue())
+                                   .arg(total)
+                                   .arg(MemoryAnalyzer::formatMemory(s.total)));
+    }
+}
+
 // ALL processes
 void MainWindow::handleMultiAnalysisResult() {
+    ui->scanButton->setText("SCAN");
     if (multiAnalysisWatcher->isCanceled()) {
         ui->scanButton->setEnabled(true);
         return;
     }
 
-    ProcessMemorySummary s = multiAnalysisWatcher->result();
+    QFuture<ProcessMemorySummary> future = multiAnalysisWatcher->future();
+    if (future.resultCount() == 0) {
+        ui->scanButton->setEnabled(true);
+        return;
+    }
+
+    ProcessMemorySummary s = future.resultAt(future.resultCount() - 1);
     updateUIWithStats(s);
-    ui->infoLabel->setText(QString("Global Analysis Complete (%1 total)")
-                               .arg(formatMemory(s.total)));
     ui->scanButton->setEnabled(true);
+
+    const SharedMemoryReport shared = sharedMemoryResult ? *sharedMemoryResult : SharedMemoryReport();
+    if (currentMode == SharedMemoryMode) {
+        showSharedMemory(shared);
+        return;
+    }
+    ui->infoLabel->setText(QString("Global Analysis Complete (%1 total, %2 in %3 shared memory segments)")
+                               .arg(MemoryAnalyzer::formatMemory(s.total))
+                               .arg(MemoryAnalyzer::formatMemory(shared.residentKB()))
+                               .arg(shared.segments.size()));
+}
+
+// Comparison
+// Category totals first, then every aligned path by the size of its change
+void MainWindow::handleCompareResult() {
+    ui->scanButton->setText("SCAN");
+    if (compareWatcher->isCanceled() || compareWatcher->future().resultCount() < 2) return;
+
+    const QList<TargetProfile> profiles = compareWatcher->future().results();
+    for (const TargetProfile& profile : profiles) {
+        if (!profile.ok()) {
+            ui->infoLabel->setText("Error: " + profile.error);
+            return;
+        }
+    }
+    compareProfiles = profiles;
+    for (QPushButton* button : saveCaptureButtons) button->setEnabled(true);
+
+    const TargetProfile& a = compareProfiles[0];
+    const TargetProfile& b = compareProfiles[1];
+    static const char* const categoryNames[] = {"Private", "Stack", "Image", "Mapped"};
+    auto change = [](qint64 left, qint64 right) {
+        const qint64 delta = right - left;
+        QString text = (delta < 0 ? "-" : "+") + MemoryAnalyzer::formatMemory(qAbs(delta));
+        if (left > 0) text += QString(" (%1%2%)").arg(delta < 0 ? "" : "+").arg(100.0 * delta / left, 0, 'f', 1);
+        return text;
+    };
+
+    resetPanel({"Path", "Category", "A: " + a.name, "B: " + b.name, "Change"});
+    const qint64 left[] = {a.summary.pvt, a.summary.stk, a.summary.img, a.summary.map};
+    const qint64 right[] = {b.summary.pvt, b.summary.stk, b.summary.img, b.summary.map};
+    for (int c = 0; c < 4; ++c) {
+        addPanelRow({categoryNames[c], "", MemoryAnalyzer::formatMemory(left[c]), MemoryAnalyzer::formatMemory(right[c]), change(left[c], right[c])}, true);
+    }
+    addPanelRow({"Total", "", MemoryAnalyzer::formatMemory(a.summary.total), MemoryAnalyzer::formatMemory(b.summary.total),
+                 change(a.summary.total, b.summary.total)}, true);
+
+    // Unchanged paths and the long tail are left out
+    const int maxRows = 500;
+    int shown = 0;
+    const QList<ComparisonRow> rows = Comparison::compare(a, b);
+    for (const ComparisonRow& row : rows) {
+        if (row.deltaKB() == 0 || shown++ == maxRows) break;
+
+        QString delta = change(row.leftKB, row.rightKB);
+        if (!row.inLeft) delta += ", only in B";
+        if (!row.inRight) delta += ", only in A";
+        addPanelRow({row.key,
+                     categoryNames[int(row.category)],
+                     row.inLeft ? MemoryAnalyzer::formatMemory(row.leftKB) : "-",
+                     row.inRight ? MemoryAnalyzer::formatMemory(row.rightKB) : "-",
+                     delta});
+    }
+
+    QString note;
+    if (a.pss != b.pss) note = " - A measured with " + QString(a.pss ? "Pss" : "Rss") + ", B with " + (b.pss ? "Pss" : "Rss");
+    if (a.host != b.host) note += QString(" - A on %1, B on %2").arg(a.host, b.host);
+    ui->infoLabel->setText(QString("Comparison: %1 (%2 processes) vs %3 (%4 processes), %5 in %6 ms%7")
+                               .arg(a.name).arg(a.processes)
+                               .arg(b.name).arg(b.processes)
+                               .arg(change(a.summary.total, b.summary.total))
+                               .arg(compareClock.elapsed())
+                               .arg(note));
+}
+
+void MainWindow::saveCapture(int side) {
+    if (side >= compareProfiles.size()) return;
+
+    const QString file = QFileDialog::getSaveFileName(this, "Save Capture", QDir::homePath() + "/capture.json",
+                                                      "Captures (*.json)");
+    if (file.isEmpty()) return;
+
+    QString error;
+    if (Comparison::save(compareProfiles[side], file, &error)) {
+        ui->infoLabel->setText(QString("Saved %1 to %2").arg(compareProfiles[side].name, file));
+    } else {
+        ui->infoLabel->setText("Error: " + error);
+    }
+}
+
+// Shared memory
+// One row per segment however many processes map it
+void MainWindow::showSharedMemory(const SharedMemoryReport& report) {
+    resetPanel({"Segment", "Type", "Size", "Resident", "Swap", "Processes"});
+    static const char* const kinds[] = {"SysV", "POSIX", "memfd"};
+    const int maxNames = 4;
+
+    for (const SharedSegment& segment : report.segments) {
+        QString type = kinds[segment.kind];
+        if (segment.deleted) type += " (deleted)";
+
+        // Only the first few attachers by name, the kernel's count for the rest
+        QStringList attachers;
+        for (int i = 0; i < segment.pids.size() && i < maxNames; ++i) {
+            attachers << QString("%1 (%2)").arg(segment.names[i]).arg(segment.pids[i]);
+        }
+        QString processes = attachers.join(", ");
+        if (segment.attached > attachers.size()) {
+            processes += QString(attachers.isEmpty() ? "%1 attached" : " +%1 more").arg(segment.attached - attachers.size());
+        } else if (attachers.isEmpty()) {
+            processes = "none";
+        }
+
+        addPanelRow({segment.name,
+                     type,
+                     MemoryAnalyzer::formatMemory(segment.sizeKB),
+                     MemoryAnalyzer::formatMemory(segment.residentKB) + (segment.exact ? "" : " mapped"),
+                     MemoryAnalyzer::formatMemory(segment.swapKB),
+                     processes});
+    }
+
+    ui->infoLabel->setText(QString("Shared memory: %1 segments, %2 resident counted once")
+                               .arg(report.segments.size())
+                               .arg(MemoryAnalyzer::formatMemory(report.residentKB())));
+}
+
+// Rolling scan
+// Start ticking from a clean state so no shard from an older run is reused
+void MainWindow::startRollingScan() {
+    rollingScanner.reset();
+    rollingScanTimer->start(ui->tickIntervalSpin->value());
+    ui->scanButton->setText("STOP");
+    ui->infoLabel->setText(QString("Rolling scan started: %1 shards, up to %2 PIDs per tick")
+                               .arg(rollingScanner.shardCount())
+                               .arg(rollingScanner.maxPidsPerTick()));
+    runRollingScanTick();
+}
+
+void MainWindow::stopRollingScan() {
+    rollingScanTimer->stop();
+    ui->scanButton->setText("SCAN");
+}
+
+// Analyze the next slice of the current shard in the background
+void MainWindow::runRollingScanTick() {
+    // Previous slice still running, skip this tick instead of queueing work
+    if (rollingScanWatcher->isRunning()) return;
+
+    auto future = ScanExecutor::run(&RollingScanner::scanSlice, rollingScanner.nextJob());
+    rollingScanWatcher->setFuture(future);
+}
+
+void MainWindow::handleRollingScanResult() {
+    if (rollingScanWatcher->isCanceled() || !rollingScanTimer->isActive()) return;
+
+    rollingScanner.commitSlice(rollingScanWatcher->result());
+
+    int done = rollingScanner.completedShards();
+    int shards = rollingScanner.shardCount();
+
+    // Totals are only meaningful once every shard has reported at least once
+    if (done < shards) {
+        ui->infoLabel->setText(QString("Rolling scan warming up: %1/%2 shards scanned").arg(done).arg(shards));
+        return;
+    }
+
+    ProcessMemorySummary s = rollingScanner.aggregate();
+    updateUIWithStats(s);
+    ui->infoLabel->setText(QString("Rolling Analysis: %1 total over %2 processes - oldest shard %3s old")
+                               .arg(MemoryAnalyzer::formatMemory(s.total))
+                               .arg(rollingScanner.trackedProcesses())
+                               .arg(rollingScanner.oldestShardAgeMs() / 1000.0, 0, 'f', 1));
+}
+
+// Multi-host mode
+// The aggregator is created by main() when started with --aggregate <port>
+void MainWindow::setAggregator(RemoteAggregator* remoteAggregator) {
+    aggregator = remoteAggregator;
+    if (!aggregator) return;
+
+    ui->analysisModeCombo->addItem("Remote Hosts Mode (Aggregated Agents)", RemoteAggregateMode);
+    connect(aggregator, &RemoteAggregator::updated, this, &MainWindow::onAggregatorUpdated);
+}
+
+void MainWindow::onAggregatorUpdated() {
+    if (!aggregator) return;
+
+    if (currentMode == RemoteAggregateMode) {
+        ProcessMemorySummary s = aggregator->aggregate();
+        updateUIWithStats(s);
+        ui->infoLabel->setText(QString("Remote Analysis: %1 total over %2 processes on %3 hosts")
+                                   .arg(MemoryAnalyzer::formatMemory(s.total))
+                                   .arg(aggregator->processCount())
+                                   .arg(aggregator->hosts().size()));
+    }
+
+    // Remote ports join the table with the next local walk, so walk /proc at
+    // most once per refresh interval and only while the table is visible
+    if (portManager && ui->tabWidget->currentWidget() == ui->portTab &&
+        ui->portAutoRefreshCheck && ui->portAutoRefreshCheck->isChecked() &&
+        portListClock.isValid() && portListClock.elapsed() >= portRefreshTimer->interval()) {
+        refreshPortList();
+    }
+}
+
+// Persistent history
+// Samples of every analysis are appended to the store, old chunks are
+// compacted and dropped once an hour
+void MainWindow::setHistoryStore(HistoryStore* store) {
+    historyStore = store;
+    if (!historyStore || !historyStore->isValid()) {
+        historyStore = nullptr;
+        return;
+    }
+
+    if (!historyMaintenanceTimer) {
+        historyMaintenanceTimer = new QTimer(this);
+        connect(historyMaintenanceTimer, &QTimer::timeout, this, &MainWindow::runHistoryMaintenance);
+    }
+    historyMaintenanceTimer->start(60 * 60 * 1000);
+
+    // Compaction rewrites chunks on disk, keep it out of the startup path
+    QTimer::singleShot(30 * 1000, this, &MainWindow::runHistoryMaintenance);
+}
+
+// Alerts
+// Rules come from a file, one per line (see AlertRule)
+void MainWindow::loadAlertRules(const QString& path) {
+    QStringList errors;
+    int count = alertEngine.loadRules(path, &errors);
+    for (const QString& error : std::as_const(errors)) {
+        qWarning().noquote() << "Alert rule:" << error;
+    }
+    if (count > 0) {
+        statusBar()->showMessage(QString("%1 alert rules loaded from %2").arg(count).arg(path), 5000);
+    }
+
+    // Port rules are evaluated on the port walks, which otherwise only start
+    // with the Ports tab, so set the tab up in the background and keep walking
+    if (alertEngine.hasRules(AlertTargetKind::Port)) {
+        QTimer::singleShot(0, this, [this]() {
+            setupTab(ui->tabWidget->indexOf(ui->portTab));
+            portRefreshTimer->start();
+        });
+    }
+}
+
+// Desktop notification when a tray is available, the status bar otherwise
+void MainWindow::raiseAlerts(const QList<AlertEvent>& events) {
+    for (const AlertEvent& e : events) {
+        if (!trayIcon && QSystemTrayIcon::isSystemTrayAvailable()) {
+            trayIcon = new QSystemTrayIcon(windowIcon(), this);
+            trayIcon->show();
+        }
+        if (trayIcon) {
+            trayIcon->showMessage(e.title(), e.message(),
+                                  e.type == AlertEvent::Fired ? QSystemTrayIcon::Warning : QSystemTrayIcon::Information,
+                                  10000);
+        } else {
+            statusBar()->showMessage(QString("%1: %2").arg(e.title(), e.message()), 15000);
+        }
+    }
+}
+
+// Only files are touched, appends on the GUI thread go on meanwhile
+void MainWindow::runHistoryMaintenance() {
+    if (!historyStore || historyMaintenance.isRunning()) return;
+
+    historyMaintenance = ScanExecutor::run([](HistoryStore* store) {
+        const qint64 day = 24LL * 60 * 60 * 1000;
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        store->applyRetention(now, 30 * day); // Keep a month
+        store->compact(now - day, day);       // One chunk per day once a day old
+    }, historyStore);
+}
+
+// System accounting
+// A table with the reconciled breakdown, the largest slab caches and reclaim
+// counters, plus a button to drill down into the per-process PSS scan
+void MainWindow::setupSystemPanel() {
+    systemPanel = new QWidget(this);
+    QVBoxLayout* panelLayout = new QVBoxLayout(systemPanel);
+    panelLayout->setContentsMargins(0, 0, 0, 0);
+
+    systemTable = new QTableWidget(systemPanel);
+    systemTable->setColumnCount(3);
+    systemTable->setHorizontalHeaderLabels({"Category", "Size", "% of RAM"});
+    systemTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    systemTable->setColumnWidth(1, 110);
+    systemTable->setColumnWidth(2, 90);
+    systemTable->verticalHeader()->setVisible(false);
+    systemTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    systemTable->setSelectionMode(QAbstractItemView::NoSelection);
+    systemTable->setAlternatingRowColors(true);
+    panelLayout->addWidget(systemTable);
+
+    systemDrillDownButton = new QPushButton("Per-process drill-down (PSS scan of every process)", systemPanel);
+    connect(systemDrillDownButton, &QPushButton::clicked, this, &MainWindow::onSystemDrillDown);
+    panelLayout->addWidget(systemDrillDownButton);
+
+    // Working set window, only shown in that mode
+    workingSetOptions = new QWidget(systemPanel);
+    QHBoxLayout* optionsLayout = new QHBoxLayout(workingSetOptions);
+    optionsLayout->setContentsMargins(0, 0, 0, 0);
+    optionsLayout->addWidget(new QLabel("Window:", workingSetOptions));
+    workingSetWindowSpin = new QSpinBox(workingSetOptions);
+    workingSetWindowSpin->setRange(1, 3600);
+    workingSetWindowSpin->setValue(10);
+    workingSetWindowSpin->setSuffix(" s");
+    optionsLayout->addWidget(workingSetWindowSpin);
+    optionsLayout->addStretch();
+    panelLayout->insertWidget(0, workingSetOptions);
+    workingSetOptions->setVisible(false);
+
+    // Leak sampling interval, only shown in that mode
+    leakOptions = new QWidget(systemPanel);
+    QHBoxLayout* leakLayout = new QHBoxLayout(leakOptions);
+    leakLayout->setContentsMargins(0, 0, 0, 0);
+    leakLayout->addWidget(new QLabel("Sample every:", leakOptions));
+    leakIntervalSpin = new QSpinBox(leakOptions);
+    leakIntervalSpin->setRange(1, 24 * 3600);
+    leakIntervalSpin->setValue(60);
+    leakIntervalSpin->setSuffix(" s");
+    leakLayout->addWidget(leakIntervalSpin);
+    leakLayout->addStretch();
+    panelLayout->insertWidget(0, leakOptions);
+    leakOptions->setVisible(false);
+
+    // Both sides of a comparison, only shown in that mode
+    compareOptions = new QWidget(systemPanel);
+    QHBoxLayout* compareLayout = new QHBoxLayout(compareOptions);
+    compareLayout->setContentsMargins(0, 0, 0, 0);
+    const char* const sides[] = {"A:", "B:"};
+    for (int side = 0; side < 2; ++side) {
+        compareLayout->addWidget(new QLabel(sides[side], compareOptions));
+        compareEdits[side] = new QLineEdit(compareOptions);
+        compareEdits[side]->setPlaceholderText("PID, app:<pid>, rule:<rule> or capture file");
+        connect(compareEdits[side], &QLineEdit::returnPressed, this, &MainWindow::onScanClicked);
+        compareLayout->addWidget(compareEdits[side], 1);
+
+        saveCaptureButtons[side] = new QPushButton("Save...", compareOptions);
+        saveCaptureButtons[side]->setToolTip("Save this side of the last comparison as a capture");
+        saveCaptureButtons[side]->setEnabled(false);
+        connect(saveCaptureButtons[side], &QPushButton::clicked, this, [this, side]() { saveCapture(side); });
+        compareLayout->addWidget(saveCaptureButtons[side]);
+    }
+    panelLayout->insertWidget(0, compareOptions);
+    compareOptions->setVisible(false);
+
+    int index = ui->verticalLayout_2->indexOf(ui->memoryBarPlaceholder);
+    ui->verticalLayout_2->insertWidget(index + 1, systemPanel);
+    systemPanel->setVisible(false);
+}
+
+void MainWindow::showSystemPanel(bool visible) {
+    systemPanel->setVisible(visible);
+    ui->memoryBarPlaceholder->setVisible(!visible);
+    ui->statsGroup->setVisible(!visible);
+}
+
+// Address space layout
+// The map of the scanned process, replacing the bar like the system panel
+void MainWindow::setupLayoutPanel() {
+    layoutPanel = new QWidget(this);
+    QVBoxLayout* panelLayout = new QVBoxLayout(layoutPanel);
+    panelLayout->setContentsMargins(0, 0, 0, 0);
+
+    compactGapsCheck = new QCheckBox("Compact unmapped gaps", layoutPanel);
+    compactGapsCheck->setChecked(true);
+    compactGapsCheck->setToolTip("Draw large unmapped gaps no wider than an average mapping");
+    connect(compactGapsCheck, &QCheckBox::toggled, this, [this](bool compact) {
+        addressMapView->setCompactGaps(compact);
+    });
+    panelLayout->addWidget(compactGapsCheck);
+
+    addressMapView = new AddressMapView(layoutPanel);
+    panelLayout->addWidget(addressMapView, 1);
+
+    int index = ui->verticalLayout_2->indexOf(ui->memoryBarPlaceholder);
+    ui->verticalLayout_2->insertWidget(index + 1, layoutPanel);
+    layoutPanel->setVisible(false);
+}
+
+void MainWindow::showLayoutPanel(bool visible) {
+    layoutPanel->setVisible(visible);
+    if (visible) {
+        ui->memoryBarPlaceholder->setVisible(false);
+        ui->statsGroup->setVisible(false);
+    }
+}
+
+void MainWindow::handleAddressMapResult() {
+    const AddressMap map = addressMapWatcher->result();
+    if (map.isEmpty()) {
+        ui->infoLabel->setText(QString("Error: Cannot read smaps of PID %1 (process gone or no permission)").arg(currentPID));
+        return;
+    }
+
+    // The box may have been toggled while the scan ran
+    addressMapView->setMap(map);
+    addressMapView->setCompactGaps(compactGapsCheck->isChecked());
+    ui->infoLabel->setText(QString("Address space of PID %1: %2 mappings, %3 mapped, %4 resident")
+                               .arg(map.pid())
+                               .arg(map.size())
+                               .arg(MemoryAnalyzer::formatMemory(qint64(map.mappedBytes() / 1024)))
+                               .arg(MemoryAnalyzer::formatMemory(qint64(map.residentBytes() / 1024))));
+}
+
+// The panel table is shared by every table based mode
+void MainWindow::resetPanel(const QStringList& headers) {
+    systemTable->setRowCount(0);
+    systemTable->setColumnCount(headers.size());
+    systemTable->setHorizontalHeaderLabels(headers);
+    systemTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+}
+
+void MainWindow::addPanelRow(const QStringList& cells, bool header) {
+    int row = systemTable->rowCount();
+    systemTable->insertRow(row);
+    for (int column = 0; column < cells.size() && column < systemTable->columnCount(); ++column) {
+        QTableWidgetItem* item = new QTableWidgetItem(cells[column]);
+        if (header && column == 0) {
+            QFont f = item->font();
+            f.setBold(true);
+            item->setFont(f);
+        }
+        systemTable->setItem(row, column, item);
+    }
+}
+
+void MainWindow::handleSystemAccountingResult() {
+    if (systemAccountingWatcher->isCanceled()) return;
+
+    const SystemMemoryReport r = systemAccountingWatcher->result();
+    if (r.totalKB <= 0) {
+        ui->infoLabel->setText("Error: Cannot read /proc/meminfo");
+        return;
+    }
+
+    resetPanel({"Category", "Size", "% of RAM"});
+    auto addRow = [this, &r](const QString& name, qint64 kb, bool header = false) {
+        int row = systemTable->rowCount();
+        systemTable->insertRow(row);
+        QTableWidgetItem* nameItem = new QTableWidgetItem(name);
+        if (header) {
+            QFont f = nameItem->font();
+            f.setBold(true);
+            nameItem->setFont(f);
+        }
+        systemTable->setItem(row, 0, nameItem);
+        if (kb >= 0) {
+            systemTable->setItem(row, 1, new QTableWidgetItem(MemoryAnalyzer::formatMemory(kb)));
+            systemTable->setItem(row, 2, new QTableWidgetItem(QString::number(100.0 * kb / r.totalKB, 'f', 1) + "%"));
+        }
+    };
+
+    qint64 userKB = 0;
+    qint64 kernelKB = 0;
+    for (const SystemMemoryItem& item : r.items) {
+        (item.kernel ? kernelKB : userKB) += item.kb;
+    }
+
+    addRow("User space and caches", userKB, true);
+    for (const SystemMemoryItem& item : r.items) {
+        if (!item.kernel) addRow("    " + item.name, item.kb);
+    }
+    addRow("Kernel", kernelKB, true);
+    for (const SystemMemoryItem& item : r.items) {
+        if (item.kernel) addRow("    " + item.name, item.kb);
+    }
+
+    if (r.slabInfoAvailable) {
+        addRow("Top slab caches", -1, true);
+        for (const SlabCache& slab : r.topSlabs) {
+            addRow(QString("    %1 (%2 objects)").arg(slab.name).arg(slab.objects), slab.sizeKB);
+        }
+    } else {
+        addRow("Top slab caches: /proc/slabinfo needs root", -1, true);
+    }
+
+    addRow(QString("Reclaim: %1 major faults, %2 pages scanned, %3 stolen, %4/%5 swapped in/out (since boot)")
+               .arg(r.vmstat.value("pgmajfault"))
+               .arg(r.vmstat.value("pgscan_kswapd") + r.vmstat.value("pgscan_direct"))
+               .arg(r.vmstat.value("pgsteal_kswapd") + r.vmstat.value("pgsteal_direct"))
+               .arg(r.vmstat.value("pswpin"))
+               .arg(r.vmstat.value("pswpout")), -1, true);
+
+    QString pressure = r.pressure.available
+        ? QString(" - pressure some %1% / full %2% (avg10)").arg(r.pressure.someAvg10, 0, 'f', 2).arg(r.pressure.fullAvg10, 0, 'f', 2)
+        : QString();
+    ui->infoLabel->setText(QString("System: %1 total, %2 available, swap %3 used%4")
+                               .arg(MemoryAnalyzer::formatMemory(r.totalKB))
+                               .arg(MemoryAnalyzer::formatMemory(r.availableKB))
+                               .arg(MemoryAnalyzer::formatMemory(r.swapTotalKB - r.swapFreeKB))
+                               .arg(pressure));
+}
+
+// Huge pages
+// Process part first (totals, then coverage of every large mapping), then
+// the system: THP settings and sizes, hugetlb pools, THP counters, top users
+void MainWindow::handleHugePageResult() {
+    if (hugePageWatcher->isCanceled()) return;
+
+    const HugePageResult result = hugePageWatcher->result();
+    const ProcessHugePages& p = result.first;
+    const HugePageSystemReport& r = result.second;
+
+    resetPanel({"Item", "Size", "Detail"});
+    auto percent = [](qint64 part, qint64 whole) {
+        return whole > 0 ? QString::number(100.0 * part / whole, 'f', 1) + "%" : QString("-");
+    };
+
+    if (p.ok) {
+        addPanelRow({QString("%1 [%2]").arg(p.name).arg(p.pid), MemoryAnalyzer::formatMemory(p.rssKB),
+                     QString("%1 in huge pages").arg(percent(p.thpKB() + p.hugetlbKB(), p.rssKB + p.hugetlbKB()))}, true);
+        addPanelRow({"    Anonymous THP (AnonHugePages)", MemoryAnalyzer::formatMemory(p.anonHugeKB),
+                     percent(p.anonHugeKB, p.anonymousKB) + " of anonymous memory"});
+        addPanelRow({"    Shmem PMD-mapped", MemoryAnalyzer::formatMemory(p.shmemPmdKB)});
+        addPanelRow({"    File PMD-mapped", MemoryAnalyzer::formatMemory(p.filePmdKB)});
+        addPanelRow({"    hugetlb private", MemoryAnalyzer::formatMemory(p.privateHugetlbKB)});
+        addPanelRow({"    hugetlb shared", MemoryAnalyzer::formatMemory(p.sharedHugetlbKB)});
+
+        if (!p.largeVmas.isEmpty()) {
+            addPanelRow({"Large mappings (8 MB and up)"}, true);
+            for (const HugePageVma& vma : p.largeVmas.mid(0, 50)) {
+                QString detail = QString("%1 of %2 resident in huge pages")
+                                     .arg(percent(vma.hugeKB, vma.rssKB), MemoryAnalyzer::formatMemory(vma.rssKB));
+                if (!vma.thpEligible) detail += ", not THP eligible";
+                if (!vma.advice.isEmpty()) detail += ", madvise " + vma.advice;
+                addPanelRow({QString("    %1 %2").arg(vma.start, 12, 16, QChar('0'))
+                                                   .arg(vma.path.isEmpty() ? QString("[anon]") : vma.path),
+                             MemoryAnalyzer::formatMemory(vma.sizeKB), detail});
+            }
+        }
+    } else if (p.pid > 0) {
+        addPanelRow({QString("PID %1: cannot read smaps (process gone or no permission)").arg(p.pid)}, true);
+    }
+
+    addPanelRow({QString("System THP: enabled [%1], defrag [%2], shmem [%3]")
+                     .arg(r.thpEnabled, r.thpDefrag, r.shmemEnabled)}, true);
+    addPanelRow({"    Anonymous THP", MemoryAnalyzer::formatMemory(r.anonHugeKB), percent(r.anonHugeKB, r.anonPagesKB) + " of anonymous memory"});
+    addPanelRow({"    Shmem huge pages", MemoryAnalyzer::formatMemory(r.shmemHugeKB), MemoryAnalyzer::formatMemory(r.shmemPmdMappedKB) + " PMD-mapped"});
+    addPanelRow({"    File huge pages", MemoryAnalyzer::formatMemory(r.fileHugeKB), MemoryAnalyzer::formatMemory(r.filePmdMappedKB) + " PMD-mapped"});
+
+    for (const HugetlbPool& pool : r.pools) {
+        addPanelRow({QString("hugetlb pool, %1 pages").arg(MemoryAnalyzer::formatMemory(pool.pageSizeKB)),
+                     MemoryAnalyzer::formatMemory(pool.total * pool.pageSizeKB),
+                     QString("%1 of %2 pages in use, %3 reserved, %4 surplus")
+                         .arg(pool.total - pool.free).arg(pool.total).arg(pool.reserved).arg(pool.surplus)}, true);
+    }
+
+    if (!r.topUsers.isEmpty()) {
+        addPanelRow({"Top huge page users"}, true);
+        for (const ProcessHugePages& user : r.topUsers) {
+            addPanelRow({QString("    %1 [%2]").arg(user.name).arg(user.pid), MemoryAnalyzer::formatMemory(user.thpKB() + user.hugetlbKB()),
+                         QString("THP %1, hugetlb %2").arg(MemoryAnalyzer::formatMemory(user.thpKB()), MemoryAnalyzer::formatMemory(user.hugetlbKB()))});
+        }
+    }
+
+    addPanelRow({"THP events (since boot)"}, true);
+    for (const auto& counter : r.thpCounters) {
+        if (counter.second > 0) addPanelRow({"    " + counter.first, QString::number(counter.second)});
+    }
+
+    ui->infoLabel->setText(QString("Huge pages: %1 anonymous THP, %2 hugetlb pools")
+                               .arg(MemoryAnalyzer::formatMemory(r.anonHugeKB)).arg(r.pools.size()));
 }
 
-// Show memory in MB if bigger than 1024KB and GB if bigger than 1024MB
-QString MainWindow::formatMemory(qint64 kb) const {
-    if (kb >= 1024LL * 1024LL)
-        return QString::number(kb / 1024.0 / 1024.0, 'f', 2) + " GB";
-    if (kb >= 1024)
-        return QString::number(kb / 1024.0, 'f', 1) + " MB";
-    return QString::number(kb) + " KB";
+// NUMA
+// Nodes, then the selected process per node and category, then every
+// process with most of its memory away from the node it runs on
+void MainWindow::handleNumaResult() {
+    if (numaWatcher->isCanceled()) return;
+
+    const NumaReport r = numaWatcher->result();
+    if (r.nodes.isEmpty()) {
+        ui->infoLabel->setText("Error: No NUMA information in /sys/devices/system/node");
+        return;
+    }
+
+    resetPanel({"Item", "Size", "Detail"});
+    auto percent = [](qint64 part, qint64 whole) {
+        return whole > 0 ? QString::number(100.0 * part / whole, 'f', 1) + "%" : QString("-");
+    };
+
+    addPanelRow({QString("Nodes (%1)").arg(r.nodes.size())}, true);
+    for (const NumaNode& node : r.nodes) {
+        addPanelRow({QString("    Node %1 (%2 CPUs)").arg(node.id).arg(node.cpus.size()), MemoryAnalyzer::formatMemory(node.totalKB),
+                     QString("%1 used, %2 free, %3 file, %4 anonymous")
+                         .arg(MemoryAnalyzer::formatMemory(node.usedKB()), MemoryAnalyzer::formatMemory(node.freeKB),
+                              MemoryAnalyzer::formatMemory(node.filePagesKB), MemoryAnalyzer::formatMemory(node.anonPagesKB))});
+    }
+
+    const ProcessNuma& p = r.selected;
+    if (p.ok) {
+        addPanelRow({QString("%1 [%2] on CPU %3 (node %4)").arg(p.name).arg(p.pid).arg(p.cpu).arg(p.runningNode),
+                     MemoryAnalyzer::formatMemory(p.totalKB()), percent(p.localKB(), p.totalKB()) + " local"}, true);
+        for (auto it = p.nodes.cbegin(); it != p.nodes.cend(); ++it) {
+            const NumaCategoryKB& kb = it.value();
+            addPanelRow({QString("    Node %1%2").arg(it.key()).arg(it.key() == p.runningNode ? " (running)" : ""),
+                         MemoryAnalyzer::formatMemory(kb.total()),
+                         QString("Private %1, Stack %2, Image %3, Mapped %4")
+                             .arg(MemoryAnalyzer::formatMemory(kb.pvt), MemoryAnalyzer::formatMemory(kb.stk), MemoryAnalyzer::formatMemory(kb.img), MemoryAnalyzer::formatMemory(kb.map))});
+        }
+    } else if (p.pid > 0) {
+        addPanelRow({QString("PID %1: cannot read numa_maps (process gone or no permission)").arg(p.pid)}, true);
+    }
+
+    if (r.nodes.size() < 2) {
+        addPanelRow({"Single node system, every access is local"}, true);
+    } else {
+        addPanelRow({QString("Mostly off their running node (%1 of %2 processes)")
+                         .arg(r.offNode.size()).arg(r.scannedProcesses)}, true);
+        for (const ProcessNuma& off : r.offNode.mid(0, 100)) {
+            addPanelRow({QString("    %1 [%2]").arg(off.name).arg(off.pid), MemoryAnalyzer::formatMemory(off.totalKB() - off.localKB()),
+                         QString("%1 of %2 on other nodes, runs on node %3")
+                             .arg(percent(off.totalKB() - off.localKB(), off.totalKB()), MemoryAnalyzer::formatMemory(off.totalKB()))
+                             .arg(off.runningNode)});
+        }
+    }
+
+    ui->infoLabel->setText(QString("NUMA: %1 nodes, %2 processes mostly remote").arg(r.nodes.size()).arg(r.offNode.size()));
+}
+
+// Working set
+// Active and idle memory per category over the window
+void MainWindow::handleWorkingSetResult() {
+    ui->scanButton->setText("SCAN");
+    if (workingSetWatcher->isCanceled() || workingSetWatcher->future().resultCount() == 0) return;
+
+    const WorkingSetReport r = workingSetWatcher->result();
+    if (!r.ok) {
+        ui->infoLabel->setText("Error: " + r.error);
+        return;
+    }
+
+    resetPanel({"Category", "Active", "Idle", "Active %"});
+    auto addCategory = [this](const QString& name, qint64 active, qint64 idle, bool header = false) {
+        QString percent = active + idle > 0 ? QString::number(100.0 * active / (active + idle), 'f', 1) + "%" : QString("-");
+        addPanelRow({name, MemoryAnalyzer::formatMemory(active), MemoryAnalyzer::formatMemory(idle), percent}, header);
+    };
+
+    const char* names[4] = {"Private", "Stack", "Image", "Mapped"};
+    static_assert(int(MemoryCategory::Private) == 0 && int(MemoryCategory::Mapped) == 3, "names follow MemoryCategory");
+
+    addCategory(QString("%1 [%2]").arg(r.name).arg(r.pid), r.totalActiveKB(), r.totalIdleKB(), true);
+    for (int i = 0; i < 4; ++i) {
+        addCategory(QString("    ") + names[i], r.activeKB[i], r.idleKB[i]);
+    }
+
+    ui->infoLabel->setText(QString("Working set of %1 over %2 s: %3 active, %4 idle (%5, %6 syscalls)")
+                               .arg(r.name)
+                               .arg(r.windowMs / 1000.0, 0, 'f', 1)
+                               .arg(MemoryAnalyzer::formatMemory(r.totalActiveKB()))
+                               .arg(MemoryAnalyzer::formatMemory(r.totalIdleKB()))
+                               .arg(r.method == WorkingSetReport::PageIdle ? "page_idle" : "clear_refs")
+                               .arg(r.syscalls));
+}
+
+// Page cache
+// One row per mapped file, the heatmap shows residency along the file
+// The first result lists every file, later ones only the files scanned since,
+// so only their rows are rebuilt
+void MainWindow::handlePageCacheResult(int index) {
+    if (pageCacheWatcher->isCanceled()) return;
+
+    const QList<FileResidency> files = pageCacheWatcher->resultAt(index);
+    if (index == 0) {
+        pageCacheFiles = files;
+        resetPanel({"File", "Size", "Cached", "Residency"});
+        systemTable->setColumnWidth(3, PageCacheScanner::HeatmapBuckets * 3 + 8);
+        systemTable->setIconSize(QSize(PageCacheScanner::HeatmapBuckets * 3, 12));
+        systemTable->setRowCount(int(files.size()));
+        for (int row = 0; row < files.size(); ++row) showPageCacheRow(row);
+    } else {
+        for (const FileResidency& file : files) {
+            if (file.row < 0 || file.row >= pageCacheFiles.size()) continue;
+            pageCacheFiles[file.row] = file;
+            showPageCacheRow(file.row);
+        }
+    }
+
+    qint64 totalKB = 0;
+    qint64 cachedKB = 0;
+    int done = 0;
+    for (const FileResidency& file : std::as_const(pageCacheFiles)) {
+        totalKB += file.sizeKB;
+        cachedKB += file.residentKB;
+        if (file.done) ++done;
+    }
+
+    ui->infoLabel->setText(QString("Page cache: %1 of %2 mapped file data cached (%3 of %4 files scanned)")
+                               .arg(MemoryAnalyzer::formatMemory(cachedKB), MemoryAnalyzer::formatMemory(totalKB))
+                               .arg(done).arg(pageCacheFiles.size()));
+}
+
+void MainWindow::showPageCacheRow(int row) {
+    const FileResidency& file = pageCacheFiles[row];
+
+    QString cached = file.error ? QString("unreadable")
+                                : QString("%1 (%2%)").arg(MemoryAnalyzer::formatMemory(file.residentKB))
+                                      .arg(file.sizeKB > 0 ? 100 * file.residentKB / file.sizeKB : 0);
+    const QStringList cells = {file.path, MemoryAnalyzer::formatMemory(file.sizeKB),
+                               file.done || file.residentKB > 0 ? cached : QString("...")};
+    for (int column = 0; column < cells.size(); ++column) {
+        systemTable->setItem(row, column, new QTableWidgetItem(cells[column]));
+    }
+    if (file.heatmap.isEmpty()) return;
+
+    // One 3 px column per slice, from cold (dark) to fully cached (bright)
+    QPixmap heatmap(file.heatmap.size() * 3, 12);
+    heatmap.fill(QColor("#252525"));
+    QPainter painter(&heatmap);
+    QString ranges;
+    for (int b = 0; b < file.heatmap.size(); ++b) {
+        int heat = file.heatmap[b];
+        painter.fillRect(b * 3, 0, 3, 12, QColor(30 + heat * 195 / 255, 60 + heat * 120 / 255, 90));
+
+        // Tooltip in eighths of the file
+        if (b % (file.heatmap.size() / 8) == 0) {
+            int slice = file.heatmap.size() / 8;
+            int sum = 0;
+            for (int i = b; i < b + slice; ++i) sum += file.heatmap[i];
+            ranges += QString("%1 - %2: %3%\n")
+                          .arg(MemoryAnalyzer::formatMemory(file.sizeKB * b / file.heatmap.size()))
+                          .arg(MemoryAnalyzer::formatMemory(file.sizeKB * (b + slice) / file.heatmap.size()))
+                          .arg(100 * sum / (slice * 255));
+        }
+    }
+    painter.end();
+
+    QTableWidgetItem* item = new QTableWidgetItem();
+    item->setData(Qt::DecorationRole, heatmap);
+    item->setToolTip(ranges.trimmed());
+    systemTable->setItem(row, 3, item);
+}
+
+// Leak suspects
+// Regions ranked by sustained growth, refreshed after every sample
+void MainWindow::handleLeakSnapshot() {
+    std::optional<LeakSnapshot> taken;
+    {
+        QMutexLocker lock(&leakSnapshotMutex);
+        taken.swap(pendingLeakSnapshot);
+    }
+    if (!taken || leakWatcher->isCanceled()) return;
+
+    const LeakSnapshot& snapshot = *taken;
+    if (!snapshot.ok) {
+        ui->infoLabel->setText(QString("Error: Cannot read smaps of PID %1 (process gone or no permission)").arg(snapshot.pid));
+        return;
+    }
+
+    resetPanel({"Region", "Address", "Now", "Growth / h", "Sustained", "At start"});
+    static const char* const kinds[] = {"heap", "anonymous", "stack", "file"};
+
+    for (const LeakRegion& r : snapshot.suspects) {
+        QString name = r.path.empty() ? QString("[%1]").arg(kinds[r.kind]) : QString::fromStdString(r.path);
+        if (r.mappings > 1) name += QString(" (%1 mappings)").arg(r.mappings);
+
+        addPanelRow({name,
+                     QString("%1-%2").arg(r.start, 0, 16).arg(r.end, 0, 16),
+                     MemoryAnalyzer::formatMemory(qint64(r.currentKB)),
+                     "+" + MemoryAnalyzer::formatMemory(qint64(r.slopeKBPerHour())),
+                     QString::number(100 * r.sustained(), 'f', 0) + "%",
+                     MemoryAnalyzer::formatMemory(qint64(r.firstKB))});
+    }
+
+    const double hours = (snapshot.timestampMs - snapshot.firstSampleMs) / 3600000.0;
+    if (snapshot.samples < 3) {
+        ui->infoLabel->setText(QString("Leak tracking of PID %1: %2 regions, sample %3, ranking starts at 3 samples")
+                                   .arg(snapshot.pid).arg(snapshot.regions).arg(snapshot.samples));
+    } else {
+        ui->infoLabel->setText(QString("Leak tracking of PID %1: %2 growing of %3 regions over %4 h (%5 samples, %6 tracked)")
+                                   .arg(snapshot.pid)
+                                   .arg(snapshot.suspects.size())
+                                   .arg(snapshot.regions)
+                                   .arg(hours, 0, 'f', 1)
+                                   .arg(snapshot.samples)
+                                   .arg(MemoryAnalyzer::formatMemory(qint64(snapshot.totalKB))));
+    }
+}
+
+// Fault rates
+// The target is resolved in the worker, again every 10 samples for groups
+void MainWindow::setFaultTarget(std::function<QList<ProcessID>()> target) {
+    faultTarget = std::move(target);
+    faultTargetChanged = true;
+    faultTicks = 0;
+
+    if (!faultTarget) {
+        faultTimer->stop();
+        faultLabel->setVisible(false);
+        // Counters stay open until no sample runs
+        if (!faultWatcher->isRunning()) faultMonitor.setPids({});
+        return;
+    }
+
+    faultLabel->setText("Faults: measuring...");
+    faultLabel->setVisible(true);
+    faultTimer->start();
+    sampleFaults();
+}
+
+void MainWindow::sampleFaults() {
+    if (!faultTarget || faultWatcher->isRunning()) return;
+
+    std::function<QList<ProcessID>()> resolve;
+    if (faultTargetChanged || ++faultTicks % 10 == 0) {
+        resolve = faultTarget;
+        faultTargetChanged = false;
+    }
+
+    faultWatcher->setFuture(ScanExecutor::run([this, resolve]() {
+        if (resolve) faultMonitor.setPids(resolve());
+        return faultMonitor.sample();
+    }));
+}
+
+void MainWindow::handleFaultSample() {
+    if (!faultTarget) {
+        faultMonitor.setPids({});
+        return;
+    }
+    // Rates of the previous target
+    if (faultTargetChanged) return;
+
+    const FaultSample s = faultWatcher->result();
+    if (!s.valid || s.perfProcesses + s.statProcesses == 0) {
+        faultLabel->setText(s.valid ? "Faults: no accessible process" : "Faults: measuring...");
+        return;
+    }
+
+    auto rate = [](double perSec) { return QString::number(perSec, 'f', perSec < 10 ? 1 : 0) + "/s"; };
+    // perf_event_paranoid may restrict perf to user mode faults, stat counts every fault
+    const QString perf = s.perfUserOnly ? "perf, user mode only" : "perf";
+    const QString source = s.statProcesses == 0 ? perf
+                           : s.perfProcesses == 0 ? "stat"
+                           : QString("%1 %2, stat %3").arg(perf).arg(s.perfProcesses).arg(s.statProcesses);
+    const ReclaimRates& r = s.reclaim;
+
+    faultLabel->setText(QString("Faults: %1 minor, %2 major (%3) · Reclaim: scanned %4 (direct %5), "
+                                "stolen %6, swap in %7 out %8, refaults %9, stalls %10")
+                            .arg(rate(s.minorPerSec), rate(s.majorPerSec), source,
+                                 rate(r.scannedPerSec), rate(r.directScannedPerSec), rate(r.stolenPerSec),
+                                 rate(r.swapInPerSec), rate(r.swapOutPerSec), rate(r.refaultsPerSec))
+                            .arg(rate(r.allocStallsPerSec)));
+
+    // Major faults or direct reclaim mean the target is waiting on memory
+    const bool pressure = s.majorPerSec > 0 || r.directScannedPerSec > 0 || r.allocStallsPerSec > 0;
+    faultLabel->setStyleSheet(QString("color: %1; font-family: 'Consolas';").arg(pressure ? "orange" : "gray"));
+}
+
+// Own overhead
+// CPU of the whole process and of the scan threads over the last refresh
+void MainWindow::updateOverheadLabel() {
+    const ScanExecutor::Stats now = ScanExecutor::stats();
+    const double wallMs = qMax<qint64>(1, overheadClock.restart());
+    const double processPercent = 100.0 * (now.processCpuMs - lastOverhead.processCpuMs) / wallMs;
+    const double scanPercent = 100.0 * (now.scanCpuMs - lastOverhead.scanCpuMs) / wallMs;
+    const qint64 throttledMs = now.throttledMs - lastOverhead.throttledMs;
+    lastOverhead = now;
+
+    // Resident pages are the second field of statm
+    qint64 rssKB = 0;
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) rssKB = fields[1].toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    QString text = QString("memyze: %1% CPU (scans %2%), %3")
+                       .arg(processPercent, 0, 'f', 1)
+                       .arg(scanPercent, 0, 'f', 1)
+                       .arg(MemoryAnalyzer::formatMemory(rssKB));
+    if (throttledMs > 0) text += QString(", throttled %1 ms").arg(throttledMs);
+    overheadLabel->setText(text);
+
+    // Pool and arenas stay bounded across refreshes
+    const StringPool::Stats pool = StringPool::stats();
+    overheadLabel->setToolTip(QString("String pool: %1 strings, %2 (%3% hits)\nScan arenas: %4")
+                                  .arg(pool.strings)
+                                  .arg(MemoryAnalyzer::formatMemory(pool.bytes / 1024))
+                                  .arg(pool.hits + pool.misses ? 100.0 * pool.hits / (pool.hits + pool.misses) : 0.0, 0, 'f', 1)
+                                  .arg(MemoryAnalyzer::formatMemory(qint64(ScanArena::totalReserved() / 1024))));
+}
+
+// Switch to the per-process system-wide scan
+void MainWindow::onSystemDrillDown() {
+    int index = ui->analysisModeCombo->findData(MultiThreadMode);
+    if (index < 0) return;
+    ui->analysisModeCombo->setCurrentIndex(index);
+    onScanClicked();
 }
 
 // Update ui stats
@@ -348,8 +1906,36 @@ void MainWindow::updateUIWithStats(const ProcessMemorySummary& s) {
     updateChangeLabel(ui->imgChangeLabel, s.img, lastStats.img);
     updateChangeLabel(ui->mapChangeLabel, s.map, lastStats.map);
 
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
     memoryBar->setValues(s.pvt, s.stk, s.img, s.map);
+
+    // Keyed like the agent's series, so two processes of the same name stay apart
+    if (historyStore) {
+        const std::string series = (s.pid > 0 ? QString("%1[%2]").arg(s.processName).arg(s.pid)
+                                              : s.processName).toStdString();
+
+        // Fresh view of a target, start from its last hour on disk
+        if (memoryHistory->sampleCount() == 0) {
+            for (const HistoryPoint& p : historyStore->query(series, now - 60 * 60 * 1000, now)) {
+                memoryHistory->addSample(p.timestampMs, p.pvt, p.stk, p.img, p.map);
+            }
+        }
+        historyStore->append(series, { now, s.pvt, s.stk, s.img, s.map });
+    }
+
+    memoryHistory->addSample(now, s.pvt, s.stk, s.img, s.map);
     lastStats = {s.pvt, s.stk, s.img, s.map, s.total};
+
+    // Alert rules watch single processes and rule based groups (by their rule)
+    if (alertEngine.ruleCount() > 0) {
+        if (currentMode == SingleThreadMode) {
+            raiseAlerts(alertEngine.addSample(AlertSample::fromSummary(s, now)));
+        } else if (currentMode == RuleGroupMode) {
+            AlertSample sample = AlertSample::fromSummary(s, now, AlertTargetKind::Group);
+            sample.name = historyGroupRule;
+            raiseAlerts(alertEngine.addSample(sample));
+        }
+    }
 }
 void MainWindow::updateChangeLabel(QLabel* label, long current, long previous) {
     if (!label) return;
@@ -366,8 +1952,10 @@ void MainWindow::updateChangeLabel(QLabel* label, long current, long previous) {
 void MainWindow::setupPortTable() {
     if (!ui->portTableWidget) return;
 
-    ui->portTableWidget->setColumnCount(4);
-    ui->portTableWidget->setHorizontalHeaderLabels({"Port", "PID", "Process", "Proto"});
+    ui->portTableWidget->setColumnCount(10);
+    ui->portTableWidget->setHorizontalHeaderLabels({"Port", "PID", "Process", "Proto",
+                                                    "Recv-Q", "Send-Q", "Conns", "RTT (ms)", "Retrans",
+                                                    "Namespace"});
 
     // Distribute space proportionally
     QHeaderView* header = ui->portTableWidget->horizontalHeader();
@@ -375,11 +1963,17 @@ void MainWindow::setupPortTable() {
     header->setSectionResizeMode(1, QHeaderView::Interactive); // PID - user can resize
     header->setSectionResizeMode(2, QHeaderView::Stretch);     // Process - takes remaining space
     header->setSectionResizeMode(3, QHeaderView::Fixed);       // Proto - fixed size
+    for (int column = 4; column < 9; ++column) {
+        header->setSectionResizeMode(column, QHeaderView::Interactive);
+        ui->portTableWidget->setColumnWidth(column, 75);
+    }
 
     // Set initial widths
     ui->portTableWidget->setColumnWidth(0, 80);  // Port
     ui->portTableWidget->setColumnWidth(1, 80);  // PID
     ui->portTableWidget->setColumnWidth(3, 70);  // Proto (fixed)
+    header->setSectionResizeMode(9, QHeaderView::Interactive);
+    ui->portTableWidget->setColumnWidth(9, 160); // Namespace
     // Process column will autofill remaining
 
     ui->portTableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
@@ -395,7 +1989,31 @@ void MainWindow::setupPortTable() {
 void MainWindow::refreshPortList() {
     if (!portManager || !ui->portTableWidget) return;
 
-    auto ports = portManager->getOpenPorts();
+    // A request during a walk is served by another one right after it
+    if (portListWatcher->isRunning()) {
+        portListStale = true;
+        return;
+    }
+    portListStale = false;
+    portListClock.start();
+    portListWatcher->setFuture(portManager->getOpenPortsAsync());
+}
+
+void MainWindow::handlePortListResult() {
+    if (portListStale) {
+        refreshPortList();
+        return;
+    }
+
+    auto ports = portListWatcher->result();
+    if (alertEngine.ruleCount() > 0) {
+        for (const AlertSample& sample : AlertSample::fromPorts(ports, QDateTime::currentMSecsSinceEpoch())) {
+            raiseAlerts(alertEngine.addSample(sample));
+        }
+    }
+    if (aggregator) {
+        ports += aggregator->ports();
+    }
 
     // Disable sorting while updating to prevent issues
     ui->portTableWidget->setSortingEnabled(false);
@@ -414,13 +2032,53 @@ void MainWindow::refreshPortList() {
         QTableWidgetItem* pidItem = new QTableWidgetItem();
         pidItem->setData(Qt::DisplayRole, p.pid); // Store as number for proper sorting
 
-        QTableWidgetItem* processItem = new QTableWidgetItem(p.processName);
+        QTableWidgetItem* processItem = new QTableWidgetItem(
+            p.host.isEmpty() ? p.processName : QString("%1 @ %2").arg(p.processName, p.host));
+        processItem->setData(Qt::UserRole, p.host); // Remote rows can't be killed from here
         QTableWidgetItem* protoItem = new QTableWidgetItem(p.protocol);
 
         ui->portTableWidget->setItem(i, 0, portItem);
         ui->portTableWidget->setItem(i, 1, pidItem);
         ui->portTableWidget->setItem(i, 2, processItem);
         ui->portTableWidget->setItem(i, 3, protoItem);
+
+        // Socket load, for listeners Recv-Q is the accept queue
+        bool listener = p.protocol == "TCP" && p.state == "0A";
+
+        QTableWidgetItem* recvItem = new QTableWidgetItem();
+        recvItem->setData(Qt::DisplayRole, p.rxQueue);
+        if (listener && p.backlogLimit >= 0) {
+            recvItem->setToolTip(QString("Accept queue: %1 of %2").arg(p.rxQueue).arg(p.backlogLimit));
+            if (p.backlogLimit > 0 && p.rxQueue * 10 >= quint32(p.backlogLimit) * 9) {
+                recvItem->setForeground(QColor("#e81123")); // Close to dropping connections
+            }
+        }
+
+        QTableWidgetItem* sendItem = new QTableWidgetItem();
+        sendItem->setData(Qt::DisplayRole, p.txQueue);
+
+        QTableWidgetItem* connItem = new QTableWidgetItem();
+        if (listener) connItem->setData(Qt::DisplayRole, p.connections);
+
+        QTableWidgetItem* rttItem = new QTableWidgetItem();
+        QTableWidgetItem* retransItem = new QTableWidgetItem();
+        if (p.hasTcpInfo) {
+            rttItem->setData(Qt::DisplayRole, p.rttUs / 1000.0);
+            retransItem->setData(Qt::DisplayRole, p.retransmits);
+        }
+
+        ui->portTableWidget->setItem(i, 4, recvItem);
+        ui->portTableWidget->setItem(i, 5, sendItem);
+        ui->portTableWidget->setItem(i, 6, connItem);
+        ui->portTableWidget->setItem(i, 7, rttItem);
+        ui->portTableWidget->setItem(i, 8, retransItem);
+
+        // Same port numbers can be bound in several containers
+        QTableWidgetItem* namespaceItem = new QTableWidgetItem(
+            p.namespaceLabel.isEmpty() ? (p.host.isEmpty() ? QString("host") : QString()) : p.namespaceLabel);
+        namespaceItem->setData(Qt::UserRole, p.netns);
+        if (p.netns != 0) namespaceItem->setToolTip(QString("net:[%1]").arg(p.netns));
+        ui->portTableWidget->setItem(i, 9, namespaceItem);
     }
 
     // Set total ports
@@ -430,40 +2088,114 @@ void MainWindow::refreshPortList() {
     ui->portTableWidget->setSortingEnabled(true);
 }
 
-// Kill selected port process after displaying confirmation box
-void MainWindow::onKillPortProcess() {
+// Selected port row, refuses remote and PID-less rows with a message box
+bool MainWindow::selectedLocalPortRow(int& port, ProcessID& pid, QString& protocol) {
     auto selected = ui->portTableWidget->selectionModel()->selectedRows();
-    if (selected.isEmpty()) return;
+    if (selected.isEmpty()) return false;
 
     int row = selected.first().row();
     QTableWidgetItem* pidItem = ui->portTableWidget->item(row, 1);
     QTableWidgetItem* portItem = ui->portTableWidget->item(row, 0);
+    QTableWidgetItem* protoItem = ui->portTableWidget->item(row, 3);
+
+    if (!pidItem || !portItem) return false;
 
-    if (!pidItem || !portItem) return;
+    QTableWidgetItem* processItem = ui->portTableWidget->item(row, 2);
+    if (processItem && !processItem->data(Qt::UserRole).toString().isEmpty()) {
+        QMessageBox::warning(this, "Remote Process",
+                             QString("This port belongs to host %1, processes can only be killed locally.")
+                                 .arg(processItem->data(Qt::UserRole).toString()));
+        return false;
+    }
 
-    int pid = pidItem->text().toInt();
-    int port = portItem->text().toInt();
+    pid = pidItem->text().toInt();
+    port = portItem->text().toInt();
+    protocol = protoItem ? protoItem->text() : QString("TCP");
 
     if (pid <= 0) {
         QMessageBox::warning(this, "Invalid PID", "Cannot kill process with invalid PID.");
-        return;
+        return false;
     }
+    return true;
+}
+
+// Kill selected port process after displaying confirmation box
+void MainWindow::onKillPortProcess() {
+    int port;
+    ProcessID pid;
+    QString protocol;
+    if (!selectedLocalPortRow(port, pid, protocol)) return;
 
     auto reply = QMessageBox::question(this, "Kill Process",
                                        QString("Are you sure you want to kill process %1 on port %2?")
                                            .arg(pid).arg(port),
                                        QMessageBox::Yes | QMessageBox::No);
 
+    if (reply == QMessageBox::Yes && portManager->killProcess(pid)) {
+        ui->portStatusLabel->setText(QString("Terminating process %1...").arg(pid));
+    }
+}
+
+// Kill every process holding the selected port (e.g. pre-forked workers)
+void MainWindow::onKillAllOnPort() {
+    int port;
+    ProcessID pid;
+    QString protocol;
+    if (!selectedLocalPortRow(port, pid, protocol)) return;
+
+    // Only in the selected row's network namespace
+    QTableWidgetItem* namespaceItem = ui->portTableWidget->item(
+        ui->portTableWidget->selectionModel()->selectedRows().first().row(), 9);
+    quint64 netns = namespaceItem ? namespaceItem->data(Qt::UserRole).toULongLong() : 0;
+
+    auto reply = QMessageBox::question(this, "Kill All on Port",
+                                       QString("Are you sure you want to kill every process on %1 port %2?")
+                                           .arg(protocol).arg(port),
+                                       QMessageBox::Yes | QMessageBox::No);
+
     if (reply == QMessageBox::Yes) {
-        if (portManager->killProcess(pid)) {
-            QMessageBox::information(this, "Success",
-                                     QString("Process %1 terminated successfully.").arg(pid));
-            QTimer::singleShot(500, this, &MainWindow::refreshPortList);
-        } else {
-            QMessageBox::warning(this, "Failed",
-                                 QString("Failed to kill process %1. You may need root privileges.").arg(pid));
-        }
+        ui->portStatusLabel->setText(QString("Terminating processes on port %1...").arg(port));
+        portManager->killAllOnPort(port, protocol, netns);
+    }
+}
+
+// Kill the selected process and every process it started
+void MainWindow::onKillApplicationGroup() {
+    int port;
+    ProcessID pid;
+    QString protocol;
+    if (!selectedLocalPortRow(port, pid, protocol)) return;
+
+    auto reply = QMessageBox::question(this, "Kill App Group",
+                                       QString("Are you sure you want to kill process %1 and all of its "
+                                               "child processes?").arg(pid),
+                                       QMessageBox::Yes | QMessageBox::No);
+
+    if (reply == QMessageBox::Yes) {
+        ui->portStatusLabel->setText(QString("Terminating application group of %1...").arg(pid));
+        portManager->killApplicationGroup(pid);
+    }
+}
+
+void MainWindow::onProcessKilled(ProcessID pid, bool success) {
+    if (success) {
+        ui->portStatusLabel->setText(QString("Process %1 terminated.").arg(pid));
+    } else {
+        ui->portStatusLabel->setText(
+            QString("Failed to kill process %1. You may need root privileges.").arg(pid));
     }
+    killRefreshTimer->start();
+}
+
+void MainWindow::onBatchKillFinished(int succeeded, int failed) {
+    if (succeeded + failed == 0) {
+        ui->portStatusLabel->setText("No processes to terminate.");
+        return;
+    }
+
+    QString text = QString("Terminated %1 of %2 processes.").arg(succeeded).arg(succeeded + failed);
+    if (failed > 0) text += " Some could not be killed, you may need root privileges.";
+    ui->portStatusLabel->setText(text);
 }
 
 // UI update when port table's selection changes
@@ -472,4 +2204,6 @@ void MainWindow::onPortTableSelectionChanged() {
 
     bool hasSelection = !ui->portTableWidget->selectionModel()->selectedRows().isEmpty();
     ui->killPortButton->setEnabled(hasSelection);
+    ui->killAllOnPortButton->setEnabled(hasSelection);
+    ui->killGroupButton->setEnabled(hasSelection);
 }
@@ -8,10 +8,38 @@
 #include <QCompleter>
 #include <QFutureWatcher>
 #include <QTableWidget>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
 #include <QScopedPointer>
+#include <QSystemTrayIcon>
+#include <QElapsedTimer>
+#include <QMutex>
 #include "memoryanalyzer.h"
 #include "memorybar.h"
+#include "memoryhistory.h"
 #include "portmanager.h"
+#include "rollingscanner.h"
+#include "processsearchindex.h"
+#include "remoteaggregator.h"
+#include "historystore.h"
+#include "systemmemory.h"
+#include "hugepages.h"
+#include "numa.h"
+#include "workingset.h"
+#include "pagecache.h"
+#include "processgroup.h"
+#include "alertengine.h"
+#include "leaktracker.h"
+#include "faultmonitor.h"
+#include "scanexecutor.h"
+#include "addressmapview.h"
+#include "sharedmemory.h"
+#include "comparison.h"
+#include <functional>
+#include <memory>
+#include <optional>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -22,9 +50,24 @@ using ProcessID = int;
 enum AnalysisMode {
     SingleThreadMode = 0,
     ApplicationGroupMode,
-    MultiThreadMode
+    MultiThreadMode,
+    RollingScanMode,
+    RemoteAggregateMode,
+    SystemAccountingMode,
+    HugePageMode,
+    NumaMode,
+    WorkingSetMode,
+    PageCacheMode,
+    RuleGroupMode,
+    LeakMode,
+    LayoutMode,
+    SharedMemoryMode,
+    CompareMode
 };
 
+// Selected process (pid 0 when none) and system side of the huge page view
+using HugePageResult = QPair<ProcessHugePages, HugePageSystemReport>;
+
 struct LastStats {
     long pvt = 0;
     long stk = 0;
@@ -38,6 +81,17 @@ struct ProcessInfo {
     ProcessID pid;
 };
 
+// One process of a background process list walk
+struct ProcessListEntry {
+    ProcessID pid = 0;
+    quint64 startTime = 0;
+    QString name;
+    long rssKB = 0;
+    bool known = false;     // Already indexed, only the memory is refreshed
+    QString commandLine;    // Read for new processes only
+};
+using ProcessListBatch = QList<ProcessListEntry>;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -46,33 +100,96 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+    void setAggregator(RemoteAggregator* remoteAggregator);
+    void setHistoryStore(HistoryStore* store);
+    void loadAlertRules(const QString& path);
+
 private slots:
     // --- UI  ---
     void onScanClicked();
     void onAnalysisModeChanged(int index);
     void resolvePidFromInput();
+    void updateProcessSuggestions(const QString& text);
 
     // --- Port management ---
     void onKillPortProcess();
+    void onKillAllOnPort();
+    void onKillApplicationGroup();
     void onPortTableSelectionChanged();
+    void onProcessKilled(ProcessID pid, bool success);
+    void onBatchKillFinished(int succeeded, int failed);
 
     // --- Helpers ---
     void refreshProcessList();
     void refreshPortList();
+    void handleProcessListBatch(int index);
+    void handleProcessListFinished();
+    void handlePortListResult();
+    void setupTab(int index);
     void setupPortTable();
-    QString formatMemory(qint64 kb) const;
+    bool selectedLocalPortRow(int& port, ProcessID& pid, QString& protocol);
     void updateUIWithStats(const ProcessMemorySummary& s);
     void updateChangeLabel(QLabel* label, long current, long previous);
 
     // --- Async analysis result handlers ---
     void handleSingleAnalysisResult();
     void handleMultiAnalysisResult();
+    void handleRollingScanResult();
+    void handlePartialAnalysisResult(QFutureWatcher<ProcessMemorySummary>* watcher, int index);
+
+    // --- Rolling scan ---
+    void runRollingScanTick();
+
+    // --- Multi-host ---
+    void onAggregatorUpdated();
+
+    // --- History ---
+    void runHistoryMaintenance();
+
+    // --- System accounting ---
+    void handleSystemAccountingResult();
+    void onSystemDrillDown();
+
+    // --- Huge pages ---
+    void handleHugePageResult();
+
+    // --- NUMA ---
+    void handleNumaResult();
+
+    // --- Working set ---
+    void handleWorkingSetResult();
+
+    // --- Page cache ---
+    void handlePageCacheResult(int index);
+
+    // --- Leak suspects ---
+    void handleLeakSnapshot();
+
+    // --- Address space layout ---
+    void handleAddressMapResult();
+
+    // --- Shared memory ---
+    void showSharedMemory(const SharedMemoryReport& report);
+
+    // --- Comparison ---
+    void handleCompareResult();
+    void saveCapture(int side);
+
+    // --- Fault rates ---
+    void sampleFaults();
+    void handleFaultSample();
+
+    // --- Own overhead ---
+    void updateOverheadLabel();
 
 private:
     QScopedPointer<Ui::MainWindow> ui;
 
     // --- Process Selection ---
     QVector<ProcessInfo> processCache;
+    QVector<ProcessInfo> pendingProcessList;  // Filled by the running walk
+    bool processListLoaded = false;
+    ProcessSearchIndex processIndex;
     QStringListModel* processModel = nullptr;
     QCompleter* processCompleter = nullptr;
     ProcessID currentPID = 0;
@@ -80,21 +197,109 @@ private:
 
     // --- Memory Visualization ---
     MemoryBar* memoryBar = nullptr;
+    MemoryHistory* memoryHistory = nullptr;
+    ProcessID historyPID = 0; // Target the history belongs to (0 for system-wide)
+    QString historyGroupRule; // Same for rule based groups
     LastStats lastStats;
 
     // --- Timers ---
     QTimer* processRefreshTimer = nullptr;
     QTimer* portRefreshTimer = nullptr;
+    QTimer* rollingScanTimer = nullptr;
+    QTimer* killRefreshTimer = nullptr;     // Coalesces port refreshes after batch kills
 
     // --- Port Management ---
     PortManager* portManager = nullptr;
 
+    // --- Multi-host (not owned) ---
+    RemoteAggregator* aggregator = nullptr;
+
+    // --- Persistent history (not owned) ---
+    HistoryStore* historyStore = nullptr;
+    QTimer* historyMaintenanceTimer = nullptr;
+    QFuture<void> historyMaintenance;   // Retention and compaction on the scan pool
+
     // --- Future Watchers ---
     QFutureWatcher<ProcessMemorySummary>* singleAnalysisWatcher = nullptr;
     QFutureWatcher<ProcessMemorySummary>* multiAnalysisWatcher = nullptr;
+    QFutureWatcher<ShardSlice>* rollingScanWatcher = nullptr;
+    QFutureWatcher<SystemMemoryReport>* systemAccountingWatcher = nullptr;
+    QFutureWatcher<HugePageResult>* hugePageWatcher = nullptr;
+    QFutureWatcher<NumaReport>* numaWatcher = nullptr;
+    QFutureWatcher<WorkingSetReport>* workingSetWatcher = nullptr;
+    QFutureWatcher<QList<FileResidency>>* pageCacheWatcher = nullptr;
+    QFutureWatcher<void>* leakWatcher = nullptr;
+    QFutureWatcher<AddressMap>* addressMapWatcher = nullptr;
+    QFutureWatcher<TargetProfile>* compareWatcher = nullptr;
+    QFutureWatcher<FaultSample>* faultWatcher = nullptr;
+    QFutureWatcher<ProcessListBatch>* processListWatcher = nullptr;
+    QFutureWatcher<QList<PortInfo>>* portListWatcher = nullptr;
+    bool portListStale = false;
+    QElapsedTimer portListClock;            // Since the last port walk started
+
+    // --- System Accounting ---
+    QWidget* systemPanel = nullptr;
+    QTableWidget* systemTable = nullptr;
+    QPushButton* systemDrillDownButton = nullptr;
+    QWidget* workingSetOptions = nullptr;
+    QSpinBox* workingSetWindowSpin = nullptr;
+    QWidget* leakOptions = nullptr;
+    QSpinBox* leakIntervalSpin = nullptr;
+    QMutex leakSnapshotMutex;
+    std::optional<LeakSnapshot> pendingLeakSnapshot;   // Latest snapshot not shown yet
+
+    // --- Address Space Layout ---
+    QWidget* layoutPanel = nullptr;
+    AddressMapView* addressMapView = nullptr;
+    QCheckBox* compactGapsCheck = nullptr;
+
+    // --- Page Cache (rows of the running scan) ---
+    QList<FileResidency> pageCacheFiles;
+
+    // --- Shared Memory (filled by the running system-wide scan) ---
+    std::shared_ptr<SharedMemoryReport> sharedMemoryResult;
+
+    // --- Comparison ---
+    QWidget* compareOptions = nullptr;
+    QLineEdit* compareEdits[2] = {nullptr, nullptr};
+    QPushButton* saveCaptureButtons[2] = {nullptr, nullptr};
+    QList<TargetProfile> compareProfiles;   // Both sides of the last comparison
+    QElapsedTimer compareClock;
+
+    // --- Rolling Scan ---
+    RollingScanner rollingScanner;
+
+    // --- Alerts ---
+    AlertEngine alertEngine;
+    QSystemTrayIcon* trayIcon = nullptr;
+
+    // --- Fault rates (monitor only touched by the running sample) ---
+    FaultMonitor faultMonitor;
+    QTimer* faultTimer = nullptr;
+    QLabel* faultLabel = nullptr;
+    std::function<QList<ProcessID>()> faultTarget; // Resolves the PIDs of the scanned target
+    bool faultTargetChanged = false;
+    int faultTicks = 0;
+
+    // --- Own overhead ---
+    QLabel* overheadLabel = nullptr;
+    ScanExecutor::Stats lastOverhead;
+    QElapsedTimer overheadClock;
 
     // --- Helper methods ---
     void cleanupWatchers();
+    void startRollingScan();
+    void stopRollingScan();
+    void setupSystemPanel();
+    void showSystemPanel(bool visible);
+    void setupLayoutPanel();
+    void showLayoutPanel(bool visible);
+    void resetPanel(const QStringList& headers);
+    void addPanelRow(const QStringList& cells, bool header = false);
+    void showPageCacheRow(int row);
+    ProcessID selectedPid();
+    void raiseAlerts(const QList<AlertEvent>& events);
+    void setFaultTarget(std::function<QList<ProcessID>()> target);
 };
 
 #endif // MAINWINDOW_H
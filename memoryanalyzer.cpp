@@ -1,13 +1,21 @@
 #include "memoryanalyzer.h"
+#include "procfsreader.h"
+#include "stringpool.h"
+#include "scanexecutor.h"
+#include "sharedmemory.h"
 
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
 #include <fstream>
 #include <sstream>
 #include <unistd.h>
 #include <limits.h>
+#include <cstdlib>
+#include <vector>
 
 // Memory Analyzer to well... analyze memory
 // Static functions only.
@@ -38,7 +46,7 @@ QString MemoryAnalyzer::getProcessName(ProcessID pid)
 
     if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QTextStream in(&file);
-        QString name = in.readLine().trimmed();
+        QString name = StringPool::intern(in.readLine().trimmed());
         file.close();
         return name;
     }
@@ -46,92 +54,143 @@ QString MemoryAnalyzer::getProcessName(ProcessID pid)
     return QString();
 }
 
-// Analyze ONLY the PID
-ProcessMemorySummary MemoryAnalyzer::analyzeSinglePid(ProcessID pid, bool usePSS)
+// Categorize a mapping based on its path (as printed in smaps)
+MemoryCategory MemoryAnalyzer::categorize(std::string_view path)
 {
-    ProcessMemorySummary s;
-    s.pid = pid;
-    s.processName = getProcessName(pid);
-
-    if (pid <= 0) {
-        qWarning() << "Invalid PID:" << pid;
-        return s;
+    auto contains = [path](std::string_view part) { return path.find(part) != std::string_view::npos; };
+    auto startsWith = [path](std::string_view prefix) { return path.substr(0, prefix.size()) == prefix; };
+    auto endsWith = [path](std::string_view suffix) {
+        return path.size() >= suffix.size() && path.substr(path.size() - suffix.size()) == suffix;
+    };
+
+    if (contains("[stack")) {
+        return MemoryCategory::Stack;
+    } else if (endsWith(".so") || contains("/lib") || contains(".so.")) {
+        return MemoryCategory::Image;
+    } else if (path.empty() || path == "[heap]" || path == "[anon]") {
+        return MemoryCategory::Private;
+    } else if (!startsWith("[")) {
+        return MemoryCategory::Mapped;
     }
+    return MemoryCategory::Private;
+}
 
-    // Parse smaps for detailed breakdown
-    std::string smapsPath = "/proc/" + std::to_string(pid) + "/smaps";
-    std::ifstream smaps(smapsPath);
-
-    if (smaps.is_open()) {
-        std::string line;
-        std::string currentPath;
-        std::string currentPerms;
+// KB as KB, MB or GB, whichever reads best
+QString MemoryAnalyzer::formatMemory(qint64 kb)
+{
+    if (kb >= 1024LL * 1024LL)
+        return QString::number(kb / 1024.0 / 1024.0, 'f', 2) + " GB";
+    if (kb >= 1024)
+        return QString::number(kb / 1024.0, 'f', 1) + " MB";
+    return QString::number(kb) + " KB";
+}
 
-        while (std::getline(smaps, line)) {
-            if (line.empty()) continue;
+namespace {
+// Shared memory mapping being parsed, handed to the scan at the next header
+struct SharedMapping {
+    bool active = false;
+    std::string dev;
+    unsigned long inode = 0;
+    std::string path;
+    uint64_t extentKB = 0;
+    uint64_t pssKB = 0;
+    uint64_t swapPssKB = 0;
+};
+
+// "Pss:                 12 kB"
+uint64_t fieldKB(const std::string& line)
+{
+    const size_t colon = line.find(':');
+    return colon == std::string::npos ? 0 : std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+}
 
-            // Check if this is a memory region header (has address range)
-            if (line.find('-') != std::string::npos) {
-                // Parse the header line:
-                // address range perms offset dev inode pathname
-                std::istringstream iss(line);
-                std::string range, perms, offset, dev, inode;
-                iss >> range >> perms >> offset >> dev >> inode;
-
-                currentPerms = perms;
-                currentPath.clear();
-
-                // Get the rest of the line as the path
-                std::string remaining;
-                if (std::getline(iss, remaining)) {
-                    currentPath = remaining;
-                    size_t start = currentPath.find_first_not_of(" \t"); // Trim leading whitespace
-                    if (start != std::string::npos) {
-                        currentPath = currentPath.substr(start);
-                    } else {
-                        currentPath.clear();
-                    }
-                }
-            }
-            // Use PSS for multiple processes to avoid double-counting, RSS for single process
-            else if ((usePSS && line.find("Pss:") == 0) || (!usePSS && line.find("Rss:") == 0)) {
-                std::istringstream iss(line);
-                std::string label;
-                long memKB;
-                std::string unit;
-                iss >> label >> memKB >> unit;
-
-                if (memKB <= 0) continue;
-
-                QString qpath = QString::fromStdString(currentPath).trimmed();
-
-                // Categorize based on the path and permissions
-                if (qpath.contains("[stack")) {
-                    s.stk += memKB;
-                } else if (qpath.endsWith(".so") || qpath.contains("/lib") ||
-                           qpath.contains(".so.") || qpath.startsWith("/usr/lib") ||
-                           qpath.startsWith("/lib")) {
-                    s.img += memKB;
-                } else if (qpath.isEmpty() || qpath == "[heap]" || qpath == "[anon]") {
-                    s.pvt += memKB;
-                } else if (!qpath.isEmpty() && !qpath.startsWith("[")) {
-                    // Files that are memory mapped
-                    s.map += memKB;
+// Sum the Rss (or Pss) of every region of an smaps file into the four categories,
+// shared memory mappings also go to the shared scan when there is one
+void accumulateSmaps(std::istream& smaps, bool usePSS, ProcessMemorySummary& s, SharedMemoryScan* shared = nullptr)
+{
+    std::string line;
+    std::string currentPath;
+    std::string currentPerms;
+    SharedMapping mapping;
+
+    auto flushShared = [&]() {
+        if (!mapping.active) return;
+        shared->add(s.pid, s.processName, mapping.dev, mapping.inode, mapping.path,
+                    mapping.extentKB, mapping.pssKB, mapping.swapPssKB);
+        mapping = SharedMapping();
+    };
+
+    while (std::getline(smaps, line)) {
+        if (line.empty()) continue;
+
+        // Check if this is a memory region header (has address range)
+        if (line.find('-') != std::string::npos) {
+            flushShared();
+
+            // Parse the header line:
+            // address range perms offset dev inode pathname
+            std::istringstream iss(line);
+            std::string range, perms, offset, dev, inode;
+            iss >> range >> perms >> offset >> dev >> inode;
+
+            currentPerms = perms;
+            currentPath.clear();
+
+            // Get the rest of the line as the path
+            std::string remaining;
+            if (std::getline(iss, remaining)) {
+                currentPath = remaining;
+                size_t start = currentPath.find_first_not_of(" \t"); // Trim leading whitespace
+                if (start != std::string::npos) {
+                    currentPath = currentPath.substr(start);
                 } else {
-                    // Other anonymous mappings
-                    s.pvt += memKB;
+                    currentPath.clear();
                 }
             }
+
+            if (shared && SharedMemoryScan::isShared(currentPath)) {
+                const size_t dash = range.find('-');
+                const uint64_t start = std::strtoull(range.c_str(), nullptr, 16);
+                const uint64_t end = std::strtoull(range.c_str() + dash + 1, nullptr, 16);
+                mapping.active = true;
+                mapping.dev = dev;
+                mapping.inode = std::strtoul(inode.c_str(), nullptr, 10);
+                mapping.path = currentPath;
+                mapping.extentKB = (std::strtoull(offset.c_str(), nullptr, 16) + end - start) / 1024;
+            }
+            continue;
         }
-        smaps.close();
-        s.total = s.pvt + s.stk + s.img + s.map;
 
-        if (s.total > 0) {
-            return s;
+        if (mapping.active) {
+            if (line.compare(0, 4, "Pss:") == 0) mapping.pssKB = fieldKB(line);
+            else if (line.compare(0, 8, "SwapPss:") == 0) mapping.swapPssKB = fieldKB(line);
+        }
+        // Use PSS for multiple processes to avoid double-counting, RSS for single process
+        if ((usePSS && line.find("Pss:") == 0) || (!usePSS && line.find("Rss:") == 0)) {
+            std::istringstream iss(line);
+            std::string label;
+            long memKB;
+            std::string unit;
+            iss >> label >> memKB >> unit;
+
+            if (memKB <= 0) continue;
+
+            // Paths were trimmed of leading whitespace, smaps has no trailing one
+            switch (MemoryAnalyzer::categorize(std::string_view(currentPath))) {
+            case MemoryCategory::Stack:   s.stk += memKB; break;
+            case MemoryCategory::Image:   s.img += memKB; break;
+            case MemoryCategory::Mapped:  s.map += memKB; break;
+            case MemoryCategory::Private: s.pvt += memKB; break;
+            }
         }
     }
+    flushShared();
+    s.total = s.pvt + s.stk + s.img + s.map;
+}
 
-    // Fallback to /proc/[pid]/status if smaps failed
+// Fallback to /proc/[pid]/status if smaps failed
+void readStatusRss(ProcessID pid, ProcessMemorySummary& s)
+{
     std::string statusPath = "/proc/" + std::to_string(pid) + "/status";
     std::ifstream status(statusPath);
 
@@ -150,10 +209,84 @@ ProcessMemorySummary MemoryAnalyzer::analyzeSinglePid(ProcessID pid, bool usePSS
         }
         status.close();
     }
+}
+}
+
+// Analyze ONLY the PID
+ProcessMemorySummary MemoryAnalyzer::analyzeSinglePid(ProcessID pid, bool usePSS)
+{
+    ProcessMemorySummary s;
+    s.pid = pid;
+    s.processName = getProcessName(pid);
+
+    if (pid <= 0) {
+        qWarning() << "Invalid PID:" << pid;
+        return s;
+    }
 
+    // Parse smaps for detailed breakdown
+    std::string smapsPath = "/proc/" + std::to_string(pid) + "/smaps";
+    std::ifstream smaps(smapsPath);
+
+    if (smaps.is_open()) {
+        accumulateSmaps(smaps, usePSS, s);
+        smaps.close();
+
+        if (s.total > 0) {
+            return s;
+        }
+    }
+
+    readStatusRss(pid, s);
     return s;
 }
 
+// Analyze a batch of PIDs, comm and smaps of the whole batch are read through
+// the thread's ProcfsReader (io_uring when available) before parsing
+QList<ProcessMemorySummary> MemoryAnalyzer::analyzePidBatch(const QList<ProcessID>& pids, bool usePSS,
+                                                            SharedMemoryScan* shared)
+{
+    ScanExecutor::checkpoint();
+
+    std::vector<std::string> paths;
+    paths.reserve(size_t(pids.size()) * 2);
+    for (ProcessID pid : pids) {
+        std::string base = "/proc/" + std::to_string(pid);
+        paths.push_back(base + "/comm");
+        paths.push_back(base + "/smaps");
+    }
+
+    std::vector<std::string> contents;
+    ProcfsReader::forCurrentThread().readFiles(paths, contents);
+
+    QList<ProcessMemorySummary> result;
+    result.reserve(pids.size());
+
+    for (int i = 0; i < pids.size(); ++i) {
+        // Callers passing every process at once are throttled too
+        if (i > 0 && i % ProcfsReader::BatchSize == 0) ScanExecutor::checkpoint();
+
+        ProcessMemorySummary s;
+        s.pid = pids[i];
+        // comm ends with a newline
+        std::string_view comm = contents[size_t(i) * 2];
+        while (!comm.empty() && (comm.back() == '\n' || comm.back() == ' ')) comm.remove_suffix(1);
+        s.processName = StringPool::internUtf8(comm);
+
+        if (s.pid > 0) {
+            std::istringstream smaps(contents[size_t(i) * 2 + 1]);
+            accumulateSmaps(smaps, usePSS, s, shared);
+            if (s.total <= 0) {
+                readStatusRss(s.pid, s);
+            }
+        }
+
+        result.append(s);
+    }
+
+    return result;
+}
+
 // Analyze entire application
 ProcessMemorySummary MemoryAnalyzer::analyzeApplication(ProcessID rootPid, bool usePSS)
 {
@@ -184,6 +317,66 @@ ProcessMemorySummary MemoryAnalyzer::analyzeApplication(ProcessID rootPid, bool
     return total;
 }
 
+// Cancellable analysis of a list of PIDs
+// Summing is done incrementally so the aggregate so far can be streamed to the UI
+void MemoryAnalyzer::analyzePids(QPromise<ProcessMemorySummary>& promise, const QList<ProcessID>& pids,
+                                 const QString& name, bool usePSS, SharedMemoryScan* shared)
+{
+    ProcessMemorySummary total;
+    total.processName = name;
+
+    promise.setProgressRange(0, pids.size());
+
+    QElapsedTimer sinceLastResult;
+    sinceLastResult.start();
+
+    // PIDs are read in batches so procfs reads can be submitted together
+    int done = 0;
+    for (int start = 0; start < pids.size(); start += ProcfsReader::BatchSize) {
+        // Cooperative cancellation, a cancelled scan stops after the current batch
+        ScanExecutor::checkpoint([&promise]() { return promise.isCanceled(); });
+        if (promise.isCanceled()) return;
+
+        const QList<ProcessMemorySummary> batch = analyzePidBatch(pids.mid(start, ProcfsReader::BatchSize), usePSS, shared);
+        for (const ProcessMemorySummary& s : batch) {
+            total.pvt += s.pvt;
+            total.stk += s.stk;
+            total.img += s.img;
+            total.map += s.map;
+        }
+        done += batch.size();
+        promise.setProgressValue(done);
+
+        // Stream the partial aggregate every few hundred ms
+        if (sinceLastResult.elapsed() >= PartialResultIntervalMs) {
+            total.total = total.pvt + total.stk + total.img + total.map;
+            promise.addResult(total);
+            sinceLastResult.restart();
+        }
+    }
+
+    total.total = total.pvt + total.stk + total.img + total.map;
+    promise.addResult(total);
+}
+
+// Cancellable version of analyzeApplication
+void MemoryAnalyzer::analyzeApplication(QPromise<ProcessMemorySummary>& promise, ProcessID rootPid, bool usePSS)
+{
+    if (rootPid <= 0) {
+        qWarning() << "Invalid root PID:" << rootPid;
+        promise.addResult(ProcessMemorySummary());
+        return;
+    }
+
+    QList<ProcessID> pids = findRelatedPids(rootPid);
+    if (promise.isCanceled()) return;
+
+    QString rootName = getProcessName(rootPid);
+    analyzePids(promise, pids,
+                rootName.isEmpty() ? QString("PID %1").arg(rootPid) : QString("%1 (Group)").arg(rootName),
+                usePSS);
+}
+
 // Get all the PIDs related to the selected process
 // We check the source file and then see all the processes originating from thier
 QList<ProcessID> MemoryAnalyzer::findRelatedPids(ProcessID pid)
@@ -226,3 +419,126 @@ QList<ProcessID> MemoryAnalyzer::findRelatedPids(ProcessID pid)
 
     return result;
 }
+
+// The process and its descendants, parents before their children
+QList<ProcessID> MemoryAnalyzer::findProcessTree(ProcessID pid)
+{
+    if (pid <= 0) return QList<ProcessID>();
+
+    QMultiHash<ProcessID, ProcessID> children;
+    for (ProcessID other : listPids()) {
+        ProcessStat stat;
+        if (readStat(other, stat) && stat.ppid > 0) children.insert(stat.ppid, other);
+    }
+
+    QList<ProcessID> result = { pid };
+    for (qsizetype i = 0; i < result.size(); ++i) {
+        for (auto it = children.constFind(result[i]); it != children.cend() && it.key() == result[i]; ++it) {
+            result.append(it.value());
+        }
+    }
+    return result;
+}
+
+
+// List every numeric entry in /proc
+QList<ProcessID> MemoryAnalyzer::listPids()
+{
+    QList<ProcessID> result;
+    QDir procDir("/proc");
+
+    if (!procDir.exists()) {
+        qWarning() << "Cannot access /proc directory";
+        return result;
+    }
+
+    QStringList entries = procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    result.reserve(entries.size());
+
+    for (const QString &entry : std::as_const(entries)) {
+        bool ok;
+        int pid = entry.toInt(&ok);
+        if (ok && pid > 0) {
+            result.append(pid);
+        }
+    }
+
+    return result;
+}
+
+// Read and parse /proc/[pid]/stat
+bool MemoryAnalyzer::readStat(ProcessID pid, ProcessStat& out)
+{
+    if (pid <= 0) return false;
+
+    std::string statPath = "/proc/" + std::to_string(pid) + "/stat";
+    std::ifstream stat(statPath);
+    if (!stat.is_open()) return false;
+
+    std::string line;
+    std::getline(stat, line);
+    return parseStat(pid, line, out);
+}
+
+// Parse the contents of /proc/[pid]/stat, for callers reading it in batches
+// comm can contain spaces and brackets, so fields are counted from the last ')'
+bool MemoryAnalyzer::parseStat(ProcessID pid, const std::string& line, ProcessStat& out)
+{
+    size_t open = line.find('(');
+    size_t close = line.rfind(')');
+    if (open == std::string::npos || close == std::string::npos || close < open) return false;
+
+    out.pid = pid;
+    out.name = StringPool::internUtf8(std::string_view(line).substr(open + 1, close - open - 1));
+
+    // Fields after comm start at index 3 (state)
+    std::istringstream iss(line.substr(close + 1));
+    std::vector<std::string> fields;
+    fields.reserve(40);
+    std::string field;
+    while (iss >> field) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 22) return false;
+
+    auto num = [&fields](int index) -> quint64 {
+        size_t i = size_t(index - 3);
+        return i < fields.size() ? std::strtoull(fields[i].c_str(), nullptr, 10) : 0;
+    };
+
+    static const long pageKB = sysconf(_SC_PAGESIZE) / 1024;
+
+    out.state = fields[0].empty() ? '?' : fields[0][0];
+    out.ppid = ProcessID(num(4));
+    out.minorFaults = num(10);
+    out.majorFaults = num(12);
+    out.utime = num(14);
+    out.stime = num(15);
+    out.startTime = num(22);
+    out.rssKB = long(num(24)) * pageKB;
+    out.processor = fields.size() > 36 ? int(num(39)) : -1;
+    return true;
+}
+
+// Get the start time of the process (in clock ticks since boot)
+// Together with the PID this identifies a process even after the PID has been reused
+quint64 MemoryAnalyzer::getStartTime(ProcessID pid)
+{
+    ProcessStat stat;
+    return readStat(pid, stat) ? stat.startTime : 0;
+}
+
+// Get the command line of the process, arguments separated by spaces
+QString MemoryAnalyzer::getCommandLine(ProcessID pid)
+{
+    if (pid <= 0) return QString();
+
+    QFile file(QString("/proc/%1/cmdline").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    QByteArray data = file.readAll();
+    file.close();
+
+    data.replace('\0', ' ');
+    return QString::fromLocal8Bit(data).trimmed();
+}
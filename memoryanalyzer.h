@@ -5,9 +5,14 @@
 #include <QList>
 #include <QMap>
 #include <QMetaType>
+#include <QPromise>
+#include <string>
+#include <string_view>
 
 typedef int ProcessID;
 
+class SharedMemoryScan;
+
 // Holds all memory of a single process (in KB)
 struct ProcessMemorySummary {
     ProcessID pid = 0;
@@ -19,6 +24,29 @@ struct ProcessMemorySummary {
     long total = 0; // Total
 };
 
+// The four categories every breakdown uses
+enum class MemoryCategory {
+    Private,    // Heap and other anonymous memory
+    Stack,
+    Image,      // Executables and shared libraries
+    Mapped      // Other memory mapped files
+};
+
+// Fields of /proc/[pid]/stat used across the tool
+struct ProcessStat {
+    ProcessID pid = 0;
+    QString name;
+    char state = '?';
+    ProcessID ppid = 0;
+    quint64 minorFaults = 0;
+    quint64 majorFaults = 0;
+    quint64 utime = 0;     // Clock ticks
+    quint64 stime = 0;     // Clock ticks
+    quint64 startTime = 0; // Clock ticks since boot
+    long rssKB = 0;
+    int processor = -1;    // CPU the process last ran on
+};
+
 // Static only, only utility class no instances
 class MemoryAnalyzer
 {
@@ -26,11 +54,32 @@ public:
     // Main Analysis
     static ProcessMemorySummary analyzeSinglePid(ProcessID pid, bool usePSS = false);
     static ProcessMemorySummary analyzeApplication(ProcessID rootPid, bool usePSS = true);
+    static QList<ProcessMemorySummary> analyzePidBatch(const QList<ProcessID>& pids, bool usePSS = true,
+                                                       SharedMemoryScan* shared = nullptr);
+
+    // Cancellable analysis of many PIDs, checks for cancellation between processes,
+    // reports progress and streams partial aggregates as intermediate results.
+    // The last result added to the promise is the final aggregate.
+    // Shared memory mappings met on the way are handed to shared when given.
+    static void analyzePids(QPromise<ProcessMemorySummary>& promise, const QList<ProcessID>& pids,
+                            const QString& name, bool usePSS = true, SharedMemoryScan* shared = nullptr);
+    static void analyzeApplication(QPromise<ProcessMemorySummary>& promise, ProcessID rootPid, bool usePSS = true);
 
     // Helper Functions
     static QString getExePath(ProcessID pid);
     static QString getProcessName(ProcessID pid);
     static QList<ProcessID> findRelatedPids(ProcessID pid);
+    static QList<ProcessID> findProcessTree(ProcessID pid);
+    static QList<ProcessID> listPids();
+    static quint64 getStartTime(ProcessID pid);
+    static bool readStat(ProcessID pid, ProcessStat& out);
+    static bool parseStat(ProcessID pid, const std::string& line, ProcessStat& out);
+    static QString getCommandLine(ProcessID pid);
+    static MemoryCategory categorize(std::string_view path);
+    static QString formatMemory(qint64 kb);
+
+    // Interval between partial results streamed by analyzePids
+    static constexpr int PartialResultIntervalMs = 250;
 
 private:
     MemoryAnalyzer() = delete;
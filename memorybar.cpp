@@ -1,6 +1,8 @@
 #include "memorybar.h"
+#include "memoryanalyzer.h"
 #include <QPainter>
 #include <QFontMetrics>
+#include <QEvent>
 
 // Constructor to set the min height to 300 and size policy accordingly
 MemoryBar::MemoryBar(QWidget *parent)
@@ -8,6 +10,24 @@ MemoryBar::MemoryBar(QWidget *parent)
 {
     setMinimumHeight(230);
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    updateFonts();
+}
+
+// Rebuild the cached fonts when the widget font changes
+void MemoryBar::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::FontChange) {
+        updateFonts();
+    }
+}
+
+void MemoryBar::updateFonts()
+{
+    m_labelFont = font();
+    m_labelFont.setPointSizeF(9);
+    m_footerFont = font();
+    m_footerFont.setBold(true);
 }
 
 // Setter (this is called whenever we have new memory data from memory analyzer)
@@ -20,16 +40,6 @@ void MemoryBar::setValues(int privateKB, int stackKB, int imageKB, int mappedKB)
     update();
 }
 
-// Convert KB to MB if large enough and MB to GB if large enough
-QString MemoryBar::formatMemory(qint64 kb) const
-{
-    if (kb >= 1024LL * 1024LL)
-        return QString::number(kb / 1024.0 / 1024.0, 'f', 2) + " GB";
-    if (kb >= 1024)
-        return QString::number(kb / 1024.0, 'f', 1) + " MB";
-    return QString::number(kb) + " KB";
-}
-
 // Main paint event
 void MemoryBar::paintEvent(QPaintEvent *)
 {
@@ -51,13 +61,14 @@ void MemoryBar::paintEvent(QPaintEvent *)
     qint64 total = m_privateKB + m_stackKB + m_imageKB + m_mappedKB;
     if (total <= 0) return;
 
-    // Define the data for easier looping
-    struct MemType { QString name; int value; QColor color; };
-    QList<MemType> types = {
-        {"Image",   m_imageKB,   QColor(colorGreen)},
-        {"Private", m_privateKB, QColor(colorBlue)},
-        {"Stack",   m_stackKB,   QColor(colorYellow)},
-        {"Mapped",  m_mappedKB,  QColor(colorPurple)}
+    // Define the data for easier looping (names are built once, nothing is allocated per repaint)
+    static const QString names[] = { "Image", "Private", "Stack", "Mapped" };
+    struct MemType { const QString &name; int value; QColor color; };
+    const MemType types[] = {
+        {names[0], m_imageKB,   QColor(colorGreen)},
+        {names[1], m_privateKB, QColor(colorBlue)},
+        {names[2], m_stackKB,   QColor(colorYellow)},
+        {names[3], m_mappedKB,  QColor(colorPurple)}
     };
 
     int currentY = margin;
@@ -83,14 +94,11 @@ void MemoryBar::paintEvent(QPaintEvent *)
     currentY += barHeight + 25; // Gap bw total and individual bars
 
     // ### INDIVIDUAL TYPE BARS ###
-    QFont labelFont = font();
-    labelFont.setPointSizeF(9);
-
     for (const auto &type : types) {
         double percent = (qreal(type.value) / total) * 100.0;
 
         // Label
-        p.setFont(labelFont);
+        p.setFont(m_labelFont);
         p.setPen(QColor(200, 200, 200));
         p.drawText(margin, currentY, textWidth, rowHeight, Qt::AlignVCenter, type.name);
 
@@ -108,7 +116,7 @@ void MemoryBar::paintEvent(QPaintEvent *)
         p.drawRoundedRect(QRectF(indTrack.left(), indTrack.top(), fillW, indTrack.height()), 2, 2);
 
         // Put value and percentage
-        QString valStr = formatMemory(type.value) + QString(" (%1%)").arg(percent, 0, 'f', 1);
+        QString valStr = MemoryAnalyzer::formatMemory(type.value) + QString(" (%1%)").arg(percent, 0, 'f', 1);
         p.setPen(Qt::white);
         p.drawText(indTrack.right() + 10, currentY, valueWidth, rowHeight, Qt::AlignVCenter | Qt::AlignLeft, valStr);
 
@@ -118,8 +126,6 @@ void MemoryBar::paintEvent(QPaintEvent *)
     // ### TOTAL'S FOOTER ###
     currentY += 10;
     p.setPen(Qt::gray);
-    QFont footerFont = font();
-    footerFont.setBold(true);
-    p.setFont(footerFont);
-    p.drawText(margin, currentY, width() - (margin * 2), rowHeight, Qt::AlignCenter, "TOTAL USAGE: " + formatMemory(total));
+    p.setFont(m_footerFont);
+    p.drawText(margin, currentY, width() - (margin * 2), rowHeight, Qt::AlignCenter, "TOTAL USAGE: " + MemoryAnalyzer::formatMemory(total));
 }
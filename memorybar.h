@@ -2,6 +2,7 @@
 #define MEMORYBAR_H
 
 #include <QWidget>
+#include <QFont>
 
 class MemoryBar : public QWidget
 {
@@ -14,6 +15,7 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 private:
     int m_privateKB = 0;
@@ -21,7 +23,11 @@ private:
     int m_imageKB = 0;
     int m_mappedKB = 0;
 
-    QString formatMemory(qint64 kb) const;
+    // Fonts are derived from the widget font once, not on every repaint
+    QFont m_labelFont;
+    QFont m_footerFont;
+
+    void updateFonts();
 };
 
 #endif // MEMORYBAR_H
@@ -0,0 +1,327 @@
+#include "memoryhistory.h"
+#include "memoryanalyzer.h"
+#include <QPainter>
+#include <QEvent>
+#include <QResizeEvent>
+
+namespace {
+// Same palette as MemoryBar, in stacking order (Image, Private, Stack, Mapped)
+const QRgb seriesColors[] = { 0x66BB6A, 0x42A5F5, 0xFFCA28, 0xAB47BC };
+const char* const seriesNames[] = { "Image", "Private", "Stack", "Mapped" };
+
+const int margin = 10;
+const int legendHeight = 20;
+const int axisWidth = 70; // Space for the peak / zero labels
+}
+
+// Constructor, allocates the ring buffer once
+MemoryHistory::MemoryHistory(QWidget *parent, int capacity)
+    : QWidget(parent)
+    , m_capacity(qMax(2, capacity))
+{
+    setMinimumHeight(140);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    m_time.resize(m_capacity);
+    for (auto &series : m_values) {
+        series.resize(m_capacity);
+    }
+    updateFonts();
+}
+
+// Append a sample, the oldest one is overwritten when the buffer is full
+void MemoryHistory::addSample(qint64 timestampMs, long privateKB, long stackKB, long imageKB, long mappedKB)
+{
+    m_time[m_head] = timestampMs;
+    m_values[0][m_head] = imageKB;
+    m_values[1][m_head] = privateKB;
+    m_values[2][m_head] = stackKB;
+    m_values[3][m_head] = mappedKB;
+
+    m_head = (m_head + 1) % m_capacity;
+    if (m_count < m_capacity) m_count++;
+    m_added++;
+
+    m_dataDirty = true;
+    update();
+}
+
+void MemoryHistory::clear()
+{
+    m_head = 0;
+    m_count = 0;
+    m_added = 0;
+    m_folded = 0;
+    m_bucketMs = 0;
+    m_dataDirty = true;
+    update();
+}
+
+// Fonts of the legend and the axis labels, derived from the widget font
+void MemoryHistory::updateFonts()
+{
+    m_legendFont = font();
+    m_legendFont.setPointSizeF(9);
+    m_axisFont = font();
+    m_axisFont.setPointSizeF(8);
+}
+
+QRect MemoryHistory::plotRect() const
+{
+    return QRect(margin + axisWidth, margin + legendHeight,
+                 width() - axisWidth - margin * 2, height() - legendHeight - margin * 2);
+}
+
+// Layers only need rebuilding when the size or the palette/font changes
+void MemoryHistory::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_staticDirty = true;
+    m_dataDirty = true;
+}
+
+void MemoryHistory::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::PaletteChange) {
+        updateFonts();
+        m_staticDirty = true;
+        m_dataDirty = true;
+    }
+}
+
+// Min/max decimation, one bucket per pixel column
+// Only the samples added since the last frame are folded in, the buckets are
+// laid out again when the width changes or the buffer was cleared or overrun
+void MemoryHistory::decimate(int columns)
+{
+    if (m_count == 0 || columns <= 0) {
+        m_bucketMs = 0;
+        m_folded = m_added;
+        return;
+    }
+
+    int first = m_count - int(m_added - m_folded);
+    if (m_bucketMs <= 0 || m_colUsed.size() != columns || first < 0) {
+        layoutBuckets(columns);
+        first = 0;
+    } else {
+        dropEvicted();
+    }
+
+    for (int i = first; i < m_count; ++i) fold(at(i));
+    m_folded = m_added;
+}
+
+// Buckets over the samples in the buffer, sized once per width
+void MemoryHistory::layoutBuckets(int columns)
+{
+    for (int s = 0; s < SeriesCount; ++s) {
+        m_colMin[s].resize(columns);
+        m_colMax[s].resize(columns);
+    }
+    m_colUsed.resize(columns);
+    m_colUsed.fill(false);
+
+    m_originMs = m_time[at(0)];
+    m_bucketMs = qMax<qint64>(1, m_time[at(m_count - 1)] - m_originMs) / qMax(1, columns - 1) + 1;
+}
+
+// Twice as wide buckets, column c takes columns 2c and 2c + 1
+void MemoryHistory::halveResolution()
+{
+    const int columns = int(m_colUsed.size());
+    for (int c = 0; c < columns; ++c) {
+        const int a = 2 * c;
+        const int b = a + 1;
+        const bool usedA = a < columns && m_colUsed[a];
+        const bool usedB = b < columns && m_colUsed[b];
+        for (int s = 0; s < SeriesCount; ++s) {
+            if (usedA && usedB) {
+                m_colMin[s][c] = qMin(m_colMin[s][a], m_colMin[s][b]);
+                m_colMax[s][c] = qMax(m_colMax[s][a], m_colMax[s][b]);
+            } else if (usedA || usedB) {
+                m_colMin[s][c] = m_colMin[s][usedA ? a : b];
+                m_colMax[s][c] = m_colMax[s][usedA ? a : b];
+            }
+        }
+        m_colUsed[c] = usedA || usedB;
+    }
+    m_bucketMs *= 2;
+}
+
+// Buckets whose samples were all overwritten are dropped from the front
+// (the first remaining one can still hold some of them until it goes too)
+void MemoryHistory::dropEvicted()
+{
+    const qint64 dropped = (m_time[at(0)] - m_originMs) / m_bucketMs;
+    if (dropped <= 0) return;
+
+    const int columns = int(m_colUsed.size());
+    const int shift = int(qMin<qint64>(dropped, columns));
+    for (int c = 0; c < columns; ++c) {
+        const int from = c + shift;
+        m_colUsed[c] = from < columns && m_colUsed[from];
+        if (!m_colUsed[c]) continue;
+        for (int s = 0; s < SeriesCount; ++s) {
+            m_colMin[s][c] = m_colMin[s][from];
+            m_colMax[s][c] = m_colMax[s][from];
+        }
+    }
+    m_originMs += dropped * m_bucketMs;
+}
+
+// Stack one sample into the bucket its timestamp falls in
+void MemoryHistory::fold(int idx)
+{
+    const int columns = int(m_colUsed.size());
+    const qint64 t = qMax(m_time[idx], m_originMs);
+    while ((t - m_originMs) / m_bucketMs >= columns) halveResolution();
+
+    const int col = int((t - m_originMs) / m_bucketMs);
+    const bool first = !m_colUsed[col];
+    m_colUsed[col] = true;
+
+    qint64 stacked = 0;
+    for (int s = 0; s < SeriesCount; ++s) {
+        stacked += m_values[s][idx];
+        if (first) {
+            m_colMin[s][col] = stacked;
+            m_colMax[s][col] = stacked;
+        } else {
+            m_colMin[s][col] = qMin(m_colMin[s][col], stacked);
+            m_colMax[s][col] = qMax(m_colMax[s][col], stacked);
+        }
+    }
+}
+
+// Background track, grid and legend
+void MemoryHistory::renderStaticLayer()
+{
+    const qreal dpr = devicePixelRatioF();
+    if (m_staticLayer.size() != size() * dpr) {
+        m_staticLayer = QPixmap(size() * dpr);
+        m_staticLayer.setDevicePixelRatio(dpr);
+    }
+    m_staticLayer.fill(Qt::transparent);
+
+    QPainter p(&m_staticLayer);
+    QRect plot = plotRect();
+
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(45, 45, 45));
+    p.drawRoundedRect(plot, 4, 4);
+
+    // Horizontal grid at quarters
+    p.setPen(QPen(QColor(70, 70, 70), 1, Qt::DotLine));
+    for (int i = 1; i < 4; ++i) {
+        int y = plot.top() + plot.height() * i / 4;
+        p.drawLine(plot.left(), y, plot.right(), y);
+    }
+
+    // Legend
+    p.setFont(m_legendFont);
+
+    int x = plot.left();
+    for (int s = 0; s < SeriesCount; ++s) {
+        p.setPen(Qt::NoPen);
+        p.setBrush(QColor(seriesColors[s]));
+        p.drawRect(x, margin + 5, 10, 10);
+        p.setPen(QColor(200, 200, 200));
+        QRect textRect(x + 14, margin, 70, legendHeight);
+        p.drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft, QString::fromLatin1(seriesNames[s]));
+        x += 84;
+    }
+
+    m_staticDirty = false;
+}
+
+// Stacked areas from the decimated buckets
+// Series are drawn top of the stack first so lower ones overdraw them, the
+// min/max spread of every bucket is drawn as a vertical line to keep spikes visible
+void MemoryHistory::renderDataLayer()
+{
+    const qreal dpr = devicePixelRatioF();
+    if (m_dataLayer.size() != size() * dpr) {
+        m_dataLayer = QPixmap(size() * dpr);
+        m_dataLayer.setDevicePixelRatio(dpr);
+    }
+    m_dataLayer.fill(Qt::transparent);
+    m_dataDirty = false;
+
+    QRect plot = plotRect();
+    int columns = plot.width();
+    if (columns <= 1 || plot.height() <= 0) return;
+
+    decimate(columns);
+
+    // Peak of the stack, and the last bucket stretched to the right edge
+    qint64 peak = 0;
+    int lastUsed = 0;
+    for (int c = 0; c < m_colUsed.size(); ++c) {
+        if (!m_colUsed[c]) continue;
+        peak = qMax(peak, m_colMax[SeriesCount - 1][c]);
+        lastUsed = c;
+    }
+    if (peak <= 0) return;
+    const qreal step = qreal(columns - 1) / qMax(1, lastUsed);
+
+    QPainter p(&m_dataLayer);
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    const qreal bottom = plot.bottom();
+    const qreal scale = qreal(plot.height()) / peak;
+
+    for (int s = SeriesCount - 1; s >= 0; --s) {
+        QVector<QPointF> &poly = m_polygons[s];
+        if (poly.capacity() < columns + 2) poly.reserve(columns + 2);
+        poly.resize(0);
+
+        int firstCol = -1;
+        int lastCol = -1;
+        for (int c = 0; c < columns; ++c) {
+            if (!m_colUsed[c]) continue;
+            if (firstCol < 0) firstCol = c;
+            lastCol = c;
+            poly.append(QPointF(plot.left() + c * step, bottom - m_colMax[s][c] * scale));
+        }
+        if (firstCol < 0) return;
+
+        poly.append(QPointF(plot.left() + lastCol * step, bottom));
+        poly.append(QPointF(plot.left() + firstCol * step, bottom));
+
+        QColor color(seriesColors[s]);
+        p.setPen(Qt::NoPen);
+        p.setBrush(color);
+        p.drawPolygon(poly.constData(), poly.size());
+
+        // Min/max spread inside each bucket
+        p.setPen(color.lighter(140));
+        for (int c = firstCol; c <= lastCol; ++c) {
+            if (!m_colUsed[c] || m_colMin[s][c] == m_colMax[s][c]) continue;
+            qreal x = plot.left() + c * step;
+            p.drawLine(QPointF(x, bottom - m_colMin[s][c] * scale), QPointF(x, bottom - m_colMax[s][c] * scale));
+        }
+    }
+
+    // Axis labels, the peak label is only formatted again when the peak changes
+    if (peak != m_peakLabelKB) {
+        m_peakLabelKB = peak;
+        m_peakLabel = MemoryAnalyzer::formatMemory(peak);
+    }
+    p.setFont(m_axisFont);
+    p.setPen(Qt::gray);
+    p.drawText(QRect(margin, plot.top() - 8, axisWidth - 6, 16), Qt::AlignRight | Qt::AlignVCenter, m_peakLabel);
+    p.drawText(QRect(margin, plot.bottom() - 8, axisWidth - 6, 16), Qt::AlignRight | Qt::AlignVCenter, "0");
+}
+
+// Paint only blits the cached layers
+void MemoryHistory::paintEvent(QPaintEvent *)
+{
+    if (m_staticDirty) renderStaticLayer();
+    if (m_dataDirty) renderDataLayer();
+
+    QPainter p(this);
+    p.drawPixmap(0, 0, m_staticLayer);
+    p.drawPixmap(0, 0, m_dataLayer);
+}
@@ -0,0 +1,74 @@
+#ifndef MEMORYHISTORY_H
+#define MEMORYHISTORY_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QVector>
+#include <QPointF>
+#include <array>
+
+// Stacked time-series of the Private/Stack/Image/Mapped breakdown
+// Samples live in a fixed-size ring buffer and are decimated to one min/max
+// bucket per pixel column. Buckets have a fixed width in time, so a new sample
+// only touches the last one; when they run out the width doubles and pairs
+// are merged. The static layer (background, grid, legend) and the plotted
+// data are cached in pixmaps, so repaints only blit.
+class MemoryHistory : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryHistory(QWidget *parent = nullptr, int capacity = 100000);
+
+    void addSample(qint64 timestampMs, long privateKB, long stackKB, long imageKB, long mappedKB);
+    void clear();
+    int sampleCount() const { return m_count; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private:
+    static constexpr int SeriesCount = 4; // Stacking order: Image, Private, Stack, Mapped
+
+    // Ring buffer (structure of arrays, allocated once)
+    QVector<qint64> m_time;
+    std::array<QVector<qint64>, SeriesCount> m_values;
+    int m_capacity;
+    int m_head = 0;  // Next write position
+    int m_count = 0;
+
+    // Per column min/max of the stacked top of every series, reused across frames
+    std::array<QVector<qint64>, SeriesCount> m_colMin;
+    std::array<QVector<qint64>, SeriesCount> m_colMax;
+    QVector<bool> m_colUsed;
+    std::array<QVector<QPointF>, SeriesCount> m_polygons;
+    qint64 m_originMs = 0;   // Start of the first bucket
+    qint64 m_bucketMs = 0;   // 0 until the buckets are laid out
+    qint64 m_added = 0;      // Samples added since clear()
+    qint64 m_folded = 0;     // Of which already in the buckets
+
+    QFont m_legendFont;
+    QFont m_axisFont;
+    qint64 m_peakLabelKB = -1;
+    QString m_peakLabel;
+
+    QPixmap m_staticLayer;
+    QPixmap m_dataLayer;
+    bool m_staticDirty = true;
+    bool m_dataDirty = true;
+
+    QRect plotRect() const;
+    int at(int i) const { return (m_head - m_count + i + m_capacity) % m_capacity; }
+    void decimate(int columns);
+    void layoutBuckets(int columns);
+    void halveResolution();
+    void dropEvicted();
+    void fold(int idx);
+    void updateFonts();
+    void renderStaticLayer();
+    void renderDataLayer();
+};
+
+#endif // MEMORYHISTORY_H
@@ -0,0 +1,221 @@
+#include "numa.h"
+#include "procfsreader.h"
+#include "scanexecutor.h"
+
+#include <QDir>
+#include <QFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+const int NumaBatchSize = ProcfsReader::BatchSize;
+}
+
+void NumaCategoryKB::add(MemoryCategory category, qint64 kb)
+{
+    switch (category) {
+    case MemoryCategory::Private: pvt += kb; break;
+    case MemoryCategory::Stack:   stk += kb; break;
+    case MemoryCategory::Image:   img += kb; break;
+    case MemoryCategory::Mapped:  map += kb; break;
+    }
+}
+
+qint64 ProcessNuma::totalKB() const
+{
+    qint64 total = 0;
+    for (const NumaCategoryKB& node : nodes) total += node.total();
+    return total;
+}
+
+double ProcessNuma::remoteFraction() const
+{
+    qint64 total = totalKB();
+    return total > 0 ? double(total - localKB()) / total : 0.0;
+}
+
+// /sys/devices/system/node/node<N>/{meminfo,cpulist}
+// meminfo lines look like "Node 0 MemTotal:       16318412 kB"
+QList<NumaNode> Numa::readNodes()
+{
+    QList<NumaNode> nodes;
+    QDir dir("/sys/devices/system/node");
+
+    const QStringList entries = dir.entryList({"node*"}, QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& entry : entries) {
+        bool ok;
+        NumaNode node;
+        node.id = entry.mid(4).toInt(&ok);
+        if (!ok) continue;
+
+        QFile meminfo(dir.absoluteFilePath(entry + "/meminfo"));
+        if (meminfo.open(QIODevice::ReadOnly)) {
+            for (const QByteArray& line : meminfo.readAll().split('\n')) {
+                QList<QByteArray> parts = line.simplified().split(' ');
+                if (parts.size() < 4) continue;
+                const QByteArray& key = parts[2];
+                qint64 kb = parts[3].toLongLong();
+                if (key == "MemTotal:") node.totalKB = kb;
+                else if (key == "MemFree:") node.freeKB = kb;
+                else if (key == "FilePages:") node.filePagesKB = kb;
+                else if (key == "AnonPages:") node.anonPagesKB = kb;
+            }
+        }
+
+        QFile cpulist(dir.absoluteFilePath(entry + "/cpulist"));
+        if (cpulist.open(QIODevice::ReadOnly)) {
+            ScanExecutor::parseCpuList(QString::fromLatin1(cpulist.readAll()), node.cpus);
+        }
+        nodes.append(node);
+    }
+
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    return nodes;
+}
+
+QVector<int> Numa::cpuToNode(const QList<NumaNode>& nodes)
+{
+    QVector<int> map;
+    for (const NumaNode& node : nodes) {
+        for (int cpu : node.cpus) {
+            if (cpu >= map.size()) map.resize(cpu + 1, -1);
+            map[cpu] = node.id;
+        }
+    }
+    return map;
+}
+
+// One line per mapping:
+// 7f3c2a000000 default file=/usr/lib/libc.so.6 mapped=100 mapmax=40 N0=60 N1=40 kernelpagesize_kB=4
+// Anonymous mappings have anon=, heap and stack are tagged as such
+void Numa::parseNumaMaps(const std::string& content, ProcessNuma& out)
+{
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t lineEnd = content.find('\n', pos);
+        if (lineEnd == std::string::npos) lineEnd = content.size();
+
+        MemoryCategory category = MemoryCategory::Private;
+        qint64 pageKB = 4;
+        int nodeIds[64];
+        qint64 nodePages[64];
+        int nodeCount = 0;
+
+        // Tokens are space separated, a path with spaces only loses its tail (the category
+        // comes from its start)
+        size_t token = content.find(' ', pos);
+        while (token != std::string::npos && token < lineEnd) {
+            ++token;
+            size_t tokenEnd = content.find(' ', token);
+            if (tokenEnd == std::string::npos || tokenEnd > lineEnd) tokenEnd = lineEnd;
+            const char* t = content.c_str() + token;
+            size_t length = tokenEnd - token;
+
+            if (length > 1 && t[0] == 'N' && t[1] >= '0' && t[1] <= '9') {
+                const char* eq = static_cast<const char*>(memchr(t, '=', length));
+                if (eq && nodeCount < 64) {
+                    nodeIds[nodeCount] = atoi(t + 1);
+                    nodePages[nodeCount] = atoll(eq + 1);
+                    ++nodeCount;
+                }
+            } else if (length > 5 && memcmp(t, "file=", 5) == 0) {
+                category = MemoryAnalyzer::categorize(std::string_view(t + 5, length - 5));
+            } else if (length == 5 && memcmp(t, "stack", 5) == 0) {
+                category = MemoryCategory::Stack;
+            } else if (length > 18 && memcmp(t, "kernelpagesize_kB=", 18) == 0) {
+                pageKB = atoll(t + 18);
+            }
+            token = tokenEnd;
+        }
+
+        for (int i = 0; i < nodeCount; ++i) {
+            out.nodes[nodeIds[i]].add(category, nodePages[i] * pageKB);
+        }
+        pos = lineEnd + 1;
+    }
+}
+
+QList<ProcessNuma> Numa::readBatch(const QList<ProcessID>& pids, const QVector<int>& cpuToNode)
+{
+    std::vector<std::string> paths;
+    paths.reserve(size_t(pids.size()) * 2);
+    for (ProcessID pid : pids) {
+        std::string base = "/proc/" + std::to_string(pid);
+        paths.push_back(base + "/stat");
+        paths.push_back(base + "/numa_maps");
+    }
+
+    std::vector<std::string> contents;
+    ProcfsReader::forCurrentThread().readFiles(paths, contents);
+
+    QList<ProcessNuma> result;
+    for (int i = 0; i < pids.size(); ++i) {
+        const std::string& stat = contents[size_t(i) * 2];
+        const std::string& maps = contents[size_t(i) * 2 + 1];
+        ProcessStat parsed;
+        if (maps.empty() || !MemoryAnalyzer::parseStat(pids[i], stat, parsed)) continue;
+
+        ProcessNuma p;
+        p.pid = pids[i];
+        p.ok = true;
+        p.name = parsed.name;
+        p.cpu = parsed.processor;
+        p.runningNode = (p.cpu >= 0 && p.cpu < cpuToNode.size()) ? cpuToNode[p.cpu] : -1;
+
+        parseNumaMaps(maps, p);
+        result.append(p);
+    }
+    return result;
+}
+
+ProcessNuma Numa::readProcess(ProcessID pid, const QVector<int>& cpuToNode)
+{
+    QList<ProcessNuma> result = readBatch({ pid }, cpuToNode);
+    if (!result.isEmpty()) return result.first();
+
+    ProcessNuma p;
+    p.pid = pid;
+    return p;
+}
+
+NumaReport Numa::read(ProcessID selectedPid, bool scanSystem, double offNodeThreshold, qint64 minKB)
+{
+    NumaReport r;
+    r.nodes = readNodes();
+    const QVector<int> nodeOf = cpuToNode(r.nodes);
+
+    if (selectedPid > 0) {
+        r.selected = readProcess(selectedPid, nodeOf);
+    }
+
+    // A single node has nothing to be off of
+    if (!scanSystem || r.nodes.size() < 2) return r;
+
+    const QList<ProcessID> pids = MemoryAnalyzer::listPids();
+    QList<QList<ProcessID>> batches;
+    for (int i = 0; i < pids.size(); i += NumaBatchSize) {
+        batches.append(pids.mid(i, NumaBatchSize));
+    }
+
+    const QList<QList<ProcessNuma>> results = QtConcurrent::blockingMapped(ScanExecutor::pool(), batches,
+        [&nodeOf](const QList<ProcessID>& batch) {
+            ScanExecutor::checkpoint();
+            return readBatch(batch, nodeOf);
+        });
+
+    for (const QList<ProcessNuma>& batch : results) {
+        r.scannedProcesses += batch.size();
+        for (const ProcessNuma& p : batch) {
+            if (p.runningNode >= 0 && p.totalKB() >= minKB && p.remoteFraction() > offNodeThreshold) {
+                r.offNode.append(p);
+            }
+        }
+    }
+
+    std::sort(r.offNode.begin(), r.offNode.end(), [](const ProcessNuma& a, const ProcessNuma& b) {
+        return a.totalKB() - a.localKB() > b.totalKB() - b.localKB();
+    });
+    return r;
+}
@@ -0,0 +1,79 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QVector>
+#include <QMetaType>
+#include "memoryanalyzer.h"
+
+// One NUMA node from /sys/devices/system/node (in KB)
+struct NumaNode {
+    int id = 0;
+    qint64 totalKB = 0;
+    qint64 freeKB = 0;
+    qint64 filePagesKB = 0;
+    qint64 anonPagesKB = 0;
+    QList<int> cpus;
+
+    qint64 usedKB() const { return totalKB - freeKB; }
+};
+
+// Memory of a process on one node by category (in KB)
+struct NumaCategoryKB {
+    qint64 pvt = 0;
+    qint64 stk = 0;
+    qint64 img = 0;
+    qint64 map = 0;
+
+    qint64 total() const { return pvt + stk + img + map; }
+    void add(MemoryCategory category, qint64 kb);
+};
+
+// Placement of one process from /proc/<pid>/numa_maps
+struct ProcessNuma {
+    ProcessID pid = 0;
+    QString name;
+    bool ok = false;
+    int cpu = -1;               // CPU the process last ran on
+    int runningNode = -1;       // Node of that CPU
+    QMap<int, NumaCategoryKB> nodes;
+
+    qint64 totalKB() const;
+    qint64 localKB() const { return nodes.value(runningNode).total(); }
+    double remoteFraction() const;
+};
+
+struct NumaReport {
+    QList<NumaNode> nodes;
+    ProcessNuma selected;        // Selected process, pid 0 when none
+    QList<ProcessNuma> offNode;  // Processes mostly off their running node, most remote memory first
+    int scannedProcesses = 0;
+};
+
+// NUMA placement analysis
+// numa_maps walks page tables like smaps, so the system-wide scan reads it
+// (and stat, for the running CPU) in procfs batches spread over the thread pool.
+class Numa
+{
+public:
+    static QList<NumaNode> readNodes();
+    static ProcessNuma readProcess(ProcessID pid, const QVector<int>& cpuToNode);
+
+    // selectedPid may be 0; processes with less than minKB are not flagged
+    static NumaReport read(ProcessID selectedPid, bool scanSystem,
+                           double offNodeThreshold = 0.5, qint64 minKB = 16 * 1024);
+
+    static QVector<int> cpuToNode(const QList<NumaNode>& nodes);
+    static void parseNumaMaps(const std::string& content, ProcessNuma& out);
+
+private:
+    Numa() = delete;
+
+    static QList<ProcessNuma> readBatch(const QList<ProcessID>& pids, const QVector<int>& cpuToNode);
+};
+
+Q_DECLARE_METATYPE(NumaReport)
+
+#endif // NUMA_H
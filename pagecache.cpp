@@ -0,0 +1,204 @@
+#include "pagecache.h"
+#include "smaps.h"
+#include "scanarena.h"
+#include "stringpool.h"
+#include "scanexecutor.h"
+
+#include <QHash>
+#include <QThread>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+
+namespace {
+// Bytes mapped per mincore() call, bounds our own address space use
+const quint64 WindowBytes = 64ULL * 1024 * 1024;
+
+qint64 threadCpuUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+quint64 pageSize()
+{
+    static const quint64 size = quint64(sysconf(_SC_PAGESIZE));
+    return size;
+}
+}
+
+PageCacheScanner::~PageCacheScanner()
+{
+    if (m_progress.fd >= 0) close(m_progress.fd);
+}
+
+bool PageCacheScanner::reset(ProcessID pid)
+{
+    if (m_progress.fd >= 0) close(m_progress.fd);
+    m_progress = Progress();
+    m_files.clear();
+    m_current = 0;
+
+    ScanArena::Scope scope;
+    std::vector<Vma> vmas;
+    if (!Smaps::read(pid, vmas)) return false;
+
+    // A file is often mapped several times (text, data, relro...)
+    QHash<QString, int> index;
+    for (const Vma& vma : vmas) {
+        if (vma.inode == 0 || vma.path.empty() || vma.path[0] != '/') continue;
+
+        QString path = StringPool::internUtf8(vma.path);
+        if (path.endsWith(" (deleted)")) continue; // Only reachable through map_files, needs root
+
+        auto it = index.find(path);
+        if (it == index.end()) {
+            it = index.insert(path, m_files.size());
+            FileResidency file;
+            file.path = path;
+            m_files.append(file);
+        }
+        m_files[*it].mappedRssKB += qint64(vma.rssKB);
+    }
+
+    std::sort(m_files.begin(), m_files.end(), [](const FileResidency& a, const FileResidency& b) {
+        return a.mappedRssKB > b.mappedRssKB;
+    });
+    for (int i = 0; i < m_files.size(); ++i) m_files[i].row = i;
+    return true;
+}
+
+void PageCacheScanner::finishFile(FileResidency& file, bool error)
+{
+    if (m_progress.fd >= 0) close(m_progress.fd);
+    m_progress = Progress();
+    file.done = true;
+    file.error = error;
+    ++m_current;
+}
+
+// Map the next window of the current file and ask which pages are cached
+// PROT_READ and no access means no page is faulted in
+bool PageCacheScanner::scanWindow(FileResidency& file)
+{
+    Progress& p = m_progress;
+
+    if (p.fd < 0) {
+        p.fd = open(file.path.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+        if (p.fd < 0) p.fd = open(file.path.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+
+        struct stat st;
+        if (p.fd < 0 || fstat(p.fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            finishFile(file, true);
+            return false;
+        }
+        p.size = quint64(st.st_size);
+        p.residentPages.fill(0, HeatmapBuckets);
+        p.totalPages.fill(0, HeatmapBuckets);
+        file.sizeKB = qint64(p.size / 1024);
+        file.heatmap.fill(0, HeatmapBuckets);
+    }
+
+    if (p.offset >= p.size) {
+        finishFile(file, false);
+        return false;
+    }
+
+    const quint64 length = qMin(WindowBytes, p.size - p.offset);
+    const quint64 pages = (length + pageSize() - 1) / pageSize();
+    const quint64 filePages = (p.size + pageSize() - 1) / pageSize();
+
+    void* addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, p.fd, off_t(p.offset));
+    if (addr == MAP_FAILED) {
+        finishFile(file, true);
+        return false;
+    }
+
+    std::vector<unsigned char> vec(pages);
+    bool ok = mincore(addr, length, vec.data()) == 0;
+    munmap(addr, length);
+    if (!ok) {
+        finishFile(file, true);
+        return false;
+    }
+
+    const quint64 firstPage = p.offset / pageSize();
+    for (quint64 i = 0; i < pages; ++i) {
+        int bucket = int((firstPage + i) * HeatmapBuckets / filePages);
+        p.totalPages[bucket]++;
+        if (vec[i] & 1) {
+            p.residentPages[bucket]++;
+            file.residentKB += qint64(pageSize() / 1024);
+        }
+    }
+
+    // Buckets touched by this window get their final or partial value
+    int firstBucket = int(firstPage * HeatmapBuckets / filePages);
+    int lastBucket = int((firstPage + pages - 1) * HeatmapBuckets / filePages);
+    for (int b = firstBucket; b <= lastBucket; ++b) {
+        file.heatmap[b] = quint8(p.totalPages[b] ? 255 * quint64(p.residentPages[b]) / p.totalPages[b] : 0);
+    }
+
+    p.offset += length;
+    if (p.offset >= p.size) finishFile(file, false);
+    return true;
+}
+
+bool PageCacheScanner::step(qint64 budgetUs)
+{
+    const qint64 started = threadCpuUs();
+
+    while (m_current < m_files.size()) {
+        scanWindow(m_files[m_current]);
+        if (threadCpuUs() - started >= budgetUs) break;
+    }
+    return m_current >= m_files.size();
+}
+
+void PageCacheScanner::scan(QPromise<QList<FileResidency>>& promise, ProcessID pid, qint64 budgetUs, int cpuPercent)
+{
+    PageCacheScanner scanner;
+    if (!scanner.reset(pid)) {
+        promise.addResult(QList<FileResidency>());
+        return;
+    }
+
+    const int fileCount = int(scanner.files().size());
+    promise.setProgressRange(0, fileCount);
+    promise.addResult(scanner.files());
+    cpuPercent = qBound(1, cpuPercent, 100);
+
+    // Files before this one haven't changed since the last result
+    int reported = 0;
+
+    QElapsedTimer sinceLastResult;
+    sinceLastResult.start();
+
+    while (true) {
+        ScanExecutor::checkpoint([&promise]() { return promise.isCanceled(); });
+        if (promise.isCanceled()) return;
+
+        const qint64 started = threadCpuUs();
+        const bool done = scanner.step(budgetUs);
+        const qint64 used = threadCpuUs() - started;
+
+        promise.setProgressValue(scanner.filesDone());
+        if (done || sinceLastResult.elapsed() >= MemoryAnalyzer::PartialResultIntervalMs) {
+            // Finished files and the one in progress
+            const int end = qMin(scanner.filesDone() + 1, fileCount);
+            promise.addResult(scanner.files().mid(reported, end - reported));
+            reported = scanner.filesDone();
+            sinceLastResult.restart();
+        }
+        if (done) return;
+
+        // Idle long enough to keep the average at cpuPercent
+        ScanExecutor::Idle idle;
+        QThread::usleep(quint64(used * (100 - cpuPercent) / cpuPercent));
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QPromise>
+#include <QMetaType>
+#include "memoryanalyzer.h"
+
+// Page cache residency of one mapped file
+struct FileResidency {
+    QString path;
+    int row = 0;                 // Position in the scan's file list
+    qint64 sizeKB = 0;
+    qint64 residentKB = 0;
+    qint64 mappedRssKB = 0;      // Rss of the process's mappings of the file
+    bool done = false;
+    bool error = false;
+
+    // Fraction of resident pages per equal slice of the file (0..255)
+    QVector<quint8> heatmap;
+};
+
+// Page cache residency of the files mapped by a process
+// Every file is mapped again in our address space in windows and queried with
+// mincore(), which reports residency without faulting anything in. Work is
+// done in steps bounded by thread CPU time so a process mapping many large
+// files is covered progressively instead of in one long burst.
+class PageCacheScanner
+{
+public:
+    static constexpr int HeatmapBuckets = 64;
+
+    PageCacheScanner() = default;
+    ~PageCacheScanner();
+    PageCacheScanner(const PageCacheScanner&) = delete;
+    PageCacheScanner& operator=(const PageCacheScanner&) = delete;
+
+    // Collects the process's mapped files, largest mapped Rss first
+    bool reset(ProcessID pid);
+
+    // Scan until budgetUs of thread CPU time is used, true once every file is done
+    bool step(qint64 budgetUs);
+
+    const QList<FileResidency>& files() const { return m_files; }
+    int filesDone() const { return m_current; }
+
+    // reset, then steps of budgetUs separated by sleeps keeping the scan at
+    // cpuPercent of one core. The first result is the whole file list, later
+    // ones (every MemoryAnalyzer::PartialResultIntervalMs and at the end) only
+    // hold the files scanned since the previous result
+    static void scan(QPromise<QList<FileResidency>>& promise, ProcessID pid,
+                     qint64 budgetUs = 20000, int cpuPercent = 20);
+
+private:
+    struct Progress {
+        int fd = -1;
+        quint64 size = 0;
+        quint64 offset = 0;
+        QVector<quint32> residentPages;
+        QVector<quint32> totalPages;
+    };
+
+    QList<FileResidency> m_files;
+    int m_current = 0;
+    Progress m_progress;
+
+    bool scanWindow(FileResidency& file);
+    void finishFile(FileResidency& file, bool error);
+};
+
+Q_DECLARE_METATYPE(FileResidency)
+
+#endif // PAGECACHE_H
@@ -1,88 +1,329 @@
 #include "portmanager.h"
+#include "processterminator.h"
+#include "memoryanalyzer.h"
+#include "sockdiag.h"
+#include "stringpool.h"
+#include "scanexecutor.h"
 #include <QDebug>
 #include <QtConcurrent>
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
 #include <QRegularExpression>
+#include <QSet>
 #include <fstream>
 #include <sstream>
 #include <signal.h>
 #include <unistd.h>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 
 PortManager::PortManager(QObject *parent) : QObject(parent)
 {
+    m_terminator = new ProcessTerminator(this);
+
+    connect(m_terminator, &ProcessTerminator::processTerminated, this,
+            [this](ProcessID pid, bool success, bool, const QString& error) {
+        if (!error.isEmpty()) emit errorOccurred(error);
+        emit processKilled(pid, success);
+    });
+    connect(m_terminator, &ProcessTerminator::batchFinished, this, &PortManager::batchKillFinished);
+}
+
+PortManager::~PortManager()
+{
+    // A lookup still walking /proc must not outlive the object it calls into
+    for (auto* watcher : std::as_const(m_killLookups)) {
+        watcher->disconnect(this);
+        watcher->cancel();
+        watcher->waitForFinished();
+    }
 }
 
 // Get all the ports
 QList<PortInfo> PortManager::getOpenPorts() {
-    QList<PortInfo> result;
+    QHash<quint64, ProcessID> namespaces;
+    QMultiMap<unsigned long, ProcessID> inodeMap = getInodeToPidMap(&namespaces);
+    QList<PortInfo> result = readAllNamespaces(inodeMap, namespaces);
+
+    emit portScanCompleted(result.size());
+    return result;
+}
 
-    // Build inode to PID mapping
-    QMap<unsigned long, ProcessID> inodeMap = getInodeToPidMap();
+// Inode of the network namespace of a /proc entry ("self" or a PID), 0 if unreadable
+quint64 PortManager::networkNamespaceOf(const QString& procEntry) {
+    char link[64];
+    ssize_t len = readlink(QString("/proc/%1/ns/net").arg(procEntry).toLocal8Bit().constData(),
+                           link, sizeof(link) - 1);
+    if (len <= 0) return 0;
+    link[len] = '\0';
+
+    // Format: net:[4026531840]
+    const char* start = strchr(link, '[');
+    return start ? strtoull(start + 1, nullptr, 10) : 0;
+}
+
+// Name a foreign namespace after the container owning it, found through the
+// representative's cgroup, or after the representative process itself
+QString PortManager::namespaceLabel(quint64 netns, ProcessID representative) {
+    static const QRegularExpression containerPattern(
+        "(docker|libpod|cri-containerd|crio|containerd)[-/]([0-9a-f]{12})[0-9a-f]*");
+
+    QFile cgroup(QString("/proc/%1/cgroup").arg(representative));
+    if (cgroup.open(QIODevice::ReadOnly)) {
+        const QString content = QString::fromLatin1(cgroup.readAll());
+        QRegularExpressionMatch match = containerPattern.match(content);
+        if (match.hasMatch()) {
+            QString runtime = match.captured(1) == "libpod" ? QString("podman") : match.captured(1);
+            return QString("%1 %2").arg(runtime, match.captured(2));
+        }
+    }
+
+    return QString("netns %1 (%2)").arg(netns).arg(getProcessNameByPID(representative));
+}
+
+// Socket tables are per network namespace: read our own once through
+// /proc/net, and every other namespace once through one of its processes
+QList<PortInfo> PortManager::readAllNamespaces(const QMultiMap<unsigned long, ProcessID>& inodeMap,
+                                               const QHash<quint64, ProcessID>& namespaces) {
+    const quint64 ownNamespace = networkNamespaceOf("self");
+
+    // sock_diag answers for the namespace of its socket, i.e. ours
+    std::unordered_map<unsigned long, SockDiag::Entry> diag;
+    bool haveDiag = m_collectTcpInfo && SockDiag::dumpTcp(diag, true);
+
+    QList<PortInfo> result = readSocketTables(inodeMap, "/proc/net", haveDiag ? &diag : nullptr);
+    for (PortInfo& info : result) info.netns = ownNamespace;
+
+    for (auto it = namespaces.cbegin(); it != namespaces.cend(); ++it) {
+        if (it.key() == ownNamespace) continue;
+
+        QList<PortInfo> ports = readSocketTables(inodeMap, QString("/proc/%1/net").arg(it.value()), nullptr);
+        if (ports.isEmpty()) continue;
+
+        QString label = StringPool::intern(namespaceLabel(it.key(), it.value()));
+        for (PortInfo& info : ports) {
+            info.netns = it.key();
+            info.namespaceLabel = label;
+        }
+        result += ports;
+    }
+
+    return result;
+}
+
+namespace {
+// TCP states as printed in /proc/net/tcp
+const int TcpEstablished = 0x01;
+const int TcpListen = 0x0A;
+
+// Next whitespace separated field of a socket table line
+bool nextField(const char*& p, const char* end, const char*& field, int& len) {
+    while (p < end && *p == ' ') ++p;
+    field = p;
+    while (p < end && *p != ' ') ++p;
+    len = int(p - field);
+    return len > 0;
+}
+
+unsigned long parseHex(const char* p, int len) {
+    unsigned long value = 0;
+    for (int i = 0; i < len; ++i) {
+        char c = p[i];
+        int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (digit < 0) break;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+unsigned long parseDec(const char* p, int len) {
+    unsigned long value = 0;
+    for (int i = 0; i < len && p[i] >= '0' && p[i] <= '9'; ++i) value = value * 10 + (p[i] - '0');
+    return value;
+}
+
+// Per listening port totals over its established connections
+struct ListenerLoad {
+    int connections = 0;
+    quint64 rttSumUs = 0;
+    int rttSamples = 0;
+    quint32 retransmits = 0;
+};
+
+// Address family, local address and port, as listeners and their connections share them
+struct ListenerKey {
+    bool v6 = false;
+    QByteArray address;     // Hex as printed in the table
+    int port = 0;
+
+    bool operator==(const ListenerKey& other) const {
+        return v6 == other.v6 && port == other.port && address == other.address;
+    }
+};
+
+size_t qHash(const ListenerKey& key, size_t seed = 0) {
+    return qHashMulti(seed, key.v6, key.address, key.port);
+}
+}
+
+// Parse the socket tables, inodeMap resolves the owning process
+// The tables can hold 100k+ connections, so lines are parsed in place instead
+// of going through QTextStream and a regex split, and names are resolved once per PID.
+QList<PortInfo> PortManager::readSocketTables(const QMultiMap<unsigned long, ProcessID>& inodeMap,
+                                              const QString& netDirectory,
+                                              const std::unordered_map<unsigned long, SockDiag::Entry>* diag) {
+    QList<PortInfo> result;
+    QHash<ProcessID, QString> names;
+    QHash<ListenerKey, ListenerLoad> connectionLoad;  // By the local end of the connections
+    QList<QPair<qsizetype, ListenerKey>> listeners;     // Rows of the TCP listeners
 
     // Files to scan for networking info
-    QStringList files = {"/proc/net/tcp", "/proc/net/udp", "/proc/net/tcp6", "/proc/net/udp6"};
+    const QStringList files = {"tcp", "udp", "tcp6", "udp6"};
 
-    for (const QString& filePath : files) {
+    for (const QString& fileName : files) {
+        QString filePath = netDirectory + '/' + fileName;
         QFile file(filePath);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (!file.open(QIODevice::ReadOnly)) {
             qWarning() << "Cannot open" << filePath;
             continue;
         }
 
-        QTextStream stream(&file);
-        QString headerLine = stream.readLine(); // Skip header line
+        const QByteArray data = file.readAll();
+        file.close();
 
-        while (!stream.atEnd()) {
-            QString line = stream.readLine();
-            if (line.trimmed().isEmpty()) continue;
+        const bool tcp = fileName.startsWith("tcp");
+        const bool v6 = fileName.endsWith('6');
+        const QString protocolName = StringPool::internLatin1(tcp ? "TCP" : "UDP");
+        const char* p = data.constData();
+        const char* const end = p + data.size();
 
-            QStringList parts = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        // Skip header line
+        p = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!p) continue;
+        ++p;
+
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
 
             // Expected format:
             // sl local_address rem_address st tx_queue:rx_queue tr:tm->when retrnsmt uid timeout inode
-            if (parts.size() < 10) continue;
-
-            QString localAddr = parts.value(1);
-            QString state = parts.value(3);
-            QString inodeStr = parts.value(9);
+            const char* fields[10];
+            int lens[10];
+            int count = 0;
+            while (count < 10 && nextField(p, lineEnd, fields[count], lens[count])) ++count;
+            p = lineEnd + 1;
+            if (count < 10) continue;
+
+            const char* portSep = static_cast<const char*>(memchr(fields[1], ':', lens[1]));
+            const char* queueSep = static_cast<const char*>(memchr(fields[4], ':', lens[4]));
+            if (!portSep || !queueSep) continue;
+
+            int port = int(parseHex(portSep + 1, int(fields[1] + lens[1] - portSep - 1)));
+            int state = int(parseHex(fields[3], lens[3]));
+            unsigned long inode = parseDec(fields[9], lens[9]);
+
+            const SockDiag::Entry* entry = nullptr;
+            if (diag && tcp && inode != 0) {
+                auto it = diag->find(inode);
+                if (it != diag->end()) entry = &it->second;
+            }
 
-            bool ok;
-            unsigned long inode = inodeStr.toULong(&ok);
-            if (!ok || inode == 0) continue;
+            ListenerKey key;
+            if (tcp && (state == TcpEstablished || state == TcpListen)) {
+                key.v6 = v6;
+                key.address = QByteArray(fields[1], int(portSep - fields[1]));
+                key.port = port;
+            }
 
-            // Parse hex port from local address (format: ADDRESS:PORT in hex)
-            int colonPos = localAddr.indexOf(':');
-            if (colonPos == -1) continue;
+            // Accepted connections share the listener's local address and port
+            if (tcp && state == TcpEstablished) {
+                ListenerLoad& load = connectionLoad[key];
+                load.connections++;
+                if (entry && entry->hasInfo) {
+                    load.rttSumUs += entry->rttUs;
+                    load.rttSamples++;
+                    load.retransmits += entry->totalRetrans;
+                }
+            }
 
-            QString portHex = localAddr.mid(colonPos + 1);
-            int port = portHex.toInt(&ok, 16);
-            if (!ok) continue;
+            if (inode == 0) continue;
 
             PortInfo info;
             info.port = port;
-            info.protocol = filePath.contains("tcp") ? "TCP" : "UDP";
+            info.protocol = protocolName;
             info.pid = inodeMap.value(inode, 0);
-            info.processName = (info.pid > 0) ? getProcessNameByPID(info.pid) : "Unknown";
-            info.state = state;
-            info.localAddress = localAddr;
+            if (info.pid > 0) {
+                auto name = names.find(info.pid);
+                if (name == names.end()) name = names.insert(info.pid, getProcessNameByPID(info.pid));
+                info.processName = *name;
+            } else {
+                info.processName = StringPool::internLatin1("Unknown");
+            }
+            info.state = StringPool::internLatin1(std::string_view(fields[3], size_t(lens[3])));
+            info.localAddress = QString::fromLatin1(fields[1], lens[1]);
+            info.remoteAddress = QString::fromLatin1(fields[2], lens[2]);
+            info.inode = inode;
+            info.txQueue = quint32(parseHex(fields[4], int(queueSep - fields[4])));
+            info.rxQueue = quint32(parseHex(queueSep + 1, int(fields[4] + lens[4] - queueSep - 1)));
+
+            if (entry) {
+                if (state == TcpListen) info.backlogLimit = int(entry->wqueue);
+                if (entry->hasInfo && state != TcpListen) {
+                    info.hasTcpInfo = true;
+                    info.rttUs = entry->rttUs;
+                    info.retransmits = entry->totalRetrans;
+                }
+            }
 
+            if (tcp && state == TcpListen) listeners.append({result.size(), key});
             result.append(info);
         }
+    }
 
-        file.close();
+    // Connections belong to the listener on their exact address, or else to the
+    // wildcard listener of their family and port
+    QSet<ListenerKey> listening;
+    for (const auto& listener : std::as_const(listeners)) listening.insert(listener.second);
+
+    QHash<ListenerKey, ListenerLoad> listenerLoad;
+    for (auto it = connectionLoad.cbegin(); it != connectionLoad.cend(); ++it) {
+        ListenerKey owner = it.key();
+        if (!listening.contains(owner)) {
+            owner.address.fill('0');
+            if (!listening.contains(owner)) continue;
+        }
+        ListenerLoad& load = listenerLoad[owner];
+        load.connections += it->connections;
+        load.rttSumUs += it->rttSumUs;
+        load.rttSamples += it->rttSamples;
+        load.retransmits += it->retransmits;
+    }
+
+    // Listeners report the load of the connections they accepted
+    for (const auto& [row, key] : std::as_const(listeners)) {
+        auto load = listenerLoad.constFind(key);
+        if (load == listenerLoad.cend()) continue;
+
+        PortInfo& info = result[row];
+        info.connections = load->connections;
+        if (load->rttSamples > 0) {
+            info.hasTcpInfo = true;
+            info.rttUs = quint32(load->rttSumUs / load->rttSamples);
+            info.retransmits = load->retransmits;
+        }
     }
 
-    emit portScanCompleted(result.size());
     return result;
 }
 
 // Get PID to inode (metadata) mapping
-QMap<unsigned long, ProcessID> PortManager::getInodeToPidMap() {
-    QMap<unsigned long, ProcessID> map;
+// A socket inherited across fork() shows up in every holder's fd table
+// namespaces, if given, receives one representative PID per network namespace
+QMultiMap<unsigned long, ProcessID> PortManager::getInodeToPidMap(QHash<quint64, ProcessID>* namespaces) {
+    QMultiMap<unsigned long, ProcessID> map;
     QDir procDir("/proc");
 
     if (!procDir.exists()) {
@@ -97,6 +338,11 @@ QMap<unsigned long, ProcessID> PortManager::getInodeToPidMap() {
         ProcessID pid = pidStr.toLong(&ok);
         if (!ok || pid <= 0) continue;
 
+        if (namespaces) {
+            quint64 netns = networkNamespaceOf(pidStr);
+            if (netns != 0 && !namespaces->contains(netns)) namespaces->insert(netns, pid);
+        }
+
         QString fdPath = QString("/proc/%1/fd").arg(pidStr);
         QDir fdDir(fdPath);
 
@@ -151,49 +397,73 @@ QString PortManager::getProcessNameByPID(ProcessID pid) {
         commFile.close();
 
         if (!name.isEmpty()) {
-            return name;
+            return StringPool::intern(name);
         }
     }
 
     return QString("PID_%1").arg(pid);
 }
 
+void PortManager::setKillGracePeriod(int ms) {
+    m_terminator->setGracePeriod(ms);
+}
+
+void PortManager::setCollectTcpInfo(bool enabled) {
+    m_collectTcpInfo = enabled;
+}
+
+int PortManager::killGracePeriod() const {
+    return m_terminator->gracePeriod();
+}
+
 // Kill process through its PID
+// SIGTERM first, SIGKILL once the grace period is over, see ProcessTerminator
 bool PortManager::killProcess(ProcessID pid) {
     if (pid <= 0) {
         emit errorOccurred("Invalid PID");
         return false;
     }
 
-    // First try graceful termination with SIGTERM
-    if (kill(pid, SIGTERM) == 0) {
-        qDebug() << "Sent SIGTERM to process" << pid;
+    m_terminator->terminate(pid);
+    return true;
+}
 
-        // Give it a moment to terminate gracefully
-        usleep(100000); // 0.1s
+// Kill several processes in parallel, they share one grace period
+void PortManager::killProcesses(const QList<ProcessID>& pids) {
+    m_terminator->terminateAll(pids);
+}
 
-        if (kill(pid, 0) != 0) {
-            emit processKilled(pid, true);
-            return true;
+// Collect the PIDs off the GUI thread (both lookups walk /proc), then kill them
+void PortManager::killCollected(std::function<QList<ProcessID>()> collect, const QString& emptyError) {
+    auto* watcher = new QFutureWatcher<QList<ProcessID>>(this);
+    m_killLookups.append(watcher);
+
+    connect(watcher, &QFutureWatcher<QList<ProcessID>>::finished, this, [this, watcher, emptyError]() {
+        m_killLookups.removeOne(watcher);
+        QList<ProcessID> pids = watcher->result();
+        watcher->deleteLater();
+
+        if (pids.isEmpty()) {
+            qWarning() << emptyError;
+            emit errorOccurred(emptyError);
+            emit batchKillFinished(0, 0);
+            return;
         }
-    } else {
-        // SIGTERM failed, log the reason
-        qWarning() << "SIGTERM failed for PID" << pid << ":" << strerror(errno);
-    }
+        killProcesses(pids);
+    });
 
-    // If still running, try SIGKILL
-    if (kill(pid, SIGKILL) == 0) {
-        qDebug() << "Sent SIGKILL to process" << pid;
-        emit processKilled(pid, true);
-        return true;
-    }
+    watcher->setFuture(ScanExecutor::run(std::move(collect)));
+}
 
-    // Both attempts failed
-    QString error = QString("Failed to kill process %1: %2").arg(pid).arg(strerror(errno));
-    qWarning() << error;
-    emit errorOccurred(error);
-    emit processKilled(pid, false);
-    return false;
+void PortManager::killAllOnPort(int port, const QString& protocol, quint64 netns) {
+    killCollected([this, port, protocol, netns]() { return findProcessesByPort(port, protocol, netns); },
+                  QString("No process found on port %1 (%2)").arg(port).arg(protocol));
+}
+
+void PortManager::killApplicationGroup(ProcessID pid) {
+    // Only the process tree, other instances of the same executable are left alone
+    killCollected([pid]() { return MemoryAnalyzer::findProcessTree(pid); },
+                  QString("No processes found for application group of %1").arg(pid));
 }
 
 // find process through its port
@@ -215,23 +485,49 @@ PortInfo PortManager::findProcessByPort(int port, const QString& protocol) {
     return PortInfo();
 }
 
+// Every PID holding a socket on the port
+// netns restricts the search to one network namespace, 0 searches all of them
+QList<ProcessID> PortManager::findProcessesByPort(int port, const QString& protocol, quint64 netns) {
+    QList<ProcessID> result;
+    if (port <= 0 || port > 65535) {
+        qWarning() << "Invalid port number:" << port;
+        return result;
+    }
+
+    QHash<quint64, ProcessID> namespaces;
+    QMultiMap<unsigned long, ProcessID> inodeMap = getInodeToPidMap(&namespaces);
+    QList<PortInfo> ports = readAllNamespaces(inodeMap, namespaces);
+
+    for (const auto& info : std::as_const(ports)) {
+        if (info.port != port || info.protocol.compare(protocol, Qt::CaseInsensitive) != 0) continue;
+        if (netns != 0 && info.netns != netns) continue;
+
+        for (auto it = inodeMap.constFind(info.inode); it != inodeMap.cend() && it.key() == info.inode; ++it) {
+            if (!result.contains(it.value())) result.append(it.value());
+        }
+    }
+
+    return result;
+}
+
 // Kill the process on a specific port
+// The lookup walks every fd table, so it runs on the scan pool like the port list
 bool PortManager::killProcessOnPort(int port, const QString& protocol) {
-    PortInfo info = findProcessByPort(port, protocol);
-
-    if (info.pid <= 0) {
-        QString error = QString("No process found on port %1 (%2)").arg(port).arg(protocol);
-        qWarning() << error;
-        emit errorOccurred(error);
+    if (port <= 0 || port > 65535) {
+        emit errorOccurred(QString("Invalid port number: %1").arg(port));
         return false;
     }
 
-    return killProcess(info.pid);
+    killCollected([this, port, protocol]() {
+        const PortInfo info = findProcessByPort(port, protocol);
+        return info.pid > 0 ? QList<ProcessID>{info.pid} : QList<ProcessID>();
+    }, QString("No process found on port %1 (%2)").arg(port).arg(protocol));
+    return true;
 }
 
-// Run get ports asynchronously
+// Run get ports asynchronously, the fd walk is a scan like any other
 QFuture<QList<PortInfo>> PortManager::getOpenPortsAsync() {
-    return QtConcurrent::run([this]() {
+    return ScanExecutor::run([this]() {
         return getOpenPorts();
     });
 }
@@ -5,8 +5,13 @@
 #include <QString>
 #include <QList>
 #include <QMap>
+#include <QHash>
 #include <QFuture>
+#include <QFutureWatcher>
+#include <functional>
+#include <unordered_map>
 #include <sys/types.h>
+#include "sockdiag.h"
 
 typedef pid_t ProcessID;
 
@@ -18,30 +23,80 @@ struct PortInfo {
     QString state;
     ProcessID pid = 0;
     QString processName;
+    QString host;   // Empty for local ports, agent host name in aggregator mode
+    unsigned long inode = 0;
+
+    // Network namespace the socket lives in, the label names its container
+    // and is empty for our own namespace
+    quint64 netns = 0;
+    QString namespaceLabel;
+
+    // Socket queues from tx_queue:rx_queue, for listeners rxQueue is the accept queue depth
+    quint32 txQueue = 0;
+    quint32 rxQueue = 0;
+    int backlogLimit = -1;      // Accept queue limit of listeners, -1 when unknown
+    int connections = 0;        // Established connections on a listening port
+
+    // tcp_info, only with collectTcpInfo; listeners carry the average RTT
+    // and summed retransmits of their connections
+    bool hasTcpInfo = false;
+    quint32 rttUs = 0;
+    quint32 retransmits = 0;
 };
 
+class ProcessTerminator;
+
 class PortManager : public QObject {
     Q_OBJECT
 
 public:
     explicit PortManager(QObject *parent = nullptr);
-    ~PortManager() override = default;
+    ~PortManager() override;
 
     QList<PortInfo> getOpenPorts();
 
+    // Blocking lookups walking every fd table, call them off the GUI thread
     PortInfo findProcessByPort(int port, const QString& protocol = "TCP");
+    // Every process holding a socket on the port (forked workers share listeners)
+    QList<ProcessID> findProcessesByPort(int port, const QString& protocol = "TCP", quint64 netns = 0);
+    QFuture<QList<PortInfo>> getOpenPortsAsync();
+
+    // Also dump tcp_info and accept queue limits through sock_diag
+    void setCollectTcpInfo(bool enabled);
+    bool collectTcpInfo() const { return m_collectTcpInfo; }
+
+    // Termination never blocks: these return whether it was started and report
+    // through processKilled (per PID) and batchKillFinished (batches)
+    void setKillGracePeriod(int ms);
+    int killGracePeriod() const;
     bool killProcess(ProcessID pid);
+    void killProcesses(const QList<ProcessID>& pids);
     bool killProcessOnPort(int port, const QString& protocol = "TCP");
-    QFuture<QList<PortInfo>> getOpenPortsAsync();
+    void killAllOnPort(int port, const QString& protocol = "TCP", quint64 netns = 0);
+    void killApplicationGroup(ProcessID pid);
 
 signals:
     void portScanCompleted(int totalPorts);
     void processKilled(ProcessID pid, bool success);
+    void batchKillFinished(int succeeded, int failed);
     void errorOccurred(const QString& error);
 
 private:
+    ProcessTerminator* m_terminator = nullptr;
+    bool m_collectTcpInfo = false;
+    // PID lookups of pending kills, they run on the scan pool and call into this object
+    QList<QFutureWatcher<QList<ProcessID>>*> m_killLookups;
+
     QString getProcessNameByPID(ProcessID pid);
-    QMap<unsigned long, ProcessID> getInodeToPidMap();
+    QMultiMap<unsigned long, ProcessID> getInodeToPidMap(QHash<quint64, ProcessID>* namespaces = nullptr);
+    QList<PortInfo> readAllNamespaces(const QMultiMap<unsigned long, ProcessID>& inodeMap,
+                                      const QHash<quint64, ProcessID>& namespaces);
+    QList<PortInfo> readSocketTables(const QMultiMap<unsigned long, ProcessID>& inodeMap,
+                                     const QString& netDirectory,
+                                     const std::unordered_map<unsigned long, SockDiag::Entry>* diag);
+    QString namespaceLabel(quint64 netns, ProcessID representative);
+    static quint64 networkNamespaceOf(const QString& procEntry);
+    void killCollected(std::function<QList<ProcessID>()> collect, const QString& emptyError);
 };
 
 #endif // PORTMANAGER_H
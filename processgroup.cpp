@@ -0,0 +1,373 @@
+#include "processgroup.h"
+#include "procfsreader.h"
+#include "stringpool.h"
+#include "scanexecutor.h"
+
+#include <QHash>
+#include <algorithm>
+#include <cstdlib>
+#include <pwd.h>
+
+namespace {
+// Process still being matched
+struct Candidate {
+    ProcessID pid = 0;
+    quint64 alive = 0;   // Alternatives that can still match
+};
+
+// Fields read for one process at one stage
+struct Values {
+    QString comm;
+    QString parent;
+    QString cgroup;
+    QString unit;
+    QString cmdline;
+    QString exe;
+    long ppid = -1;
+    long uid = -1;
+};
+
+// * and ? wildcards, everything else literal
+QString globToPattern(const QString& glob)
+{
+    QString pattern;
+    for (QChar c : glob) {
+        if (c == '*') pattern += ".*";
+        else if (c == '?') pattern += '.';
+        else pattern += QRegularExpression::escape(QString(c));
+    }
+    return QRegularExpression::anchoredPattern(pattern);
+}
+
+// "1234 (comm) S 1 ..."
+void parseStat(std::string_view stat, Values& v)
+{
+    size_t open = stat.find('(');
+    size_t close = stat.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) return;
+
+    v.comm = StringPool::internUtf8(stat.substr(open + 1, close - open - 1));
+    // ") S ppid"
+    if (close + 4 < stat.size()) {
+        v.ppid = strtol(stat.data() + close + 4, nullptr, 10);
+    }
+}
+
+// Effective uid, the second value of the Uid line
+void parseStatus(std::string_view status, Values& v)
+{
+    size_t pos = status.find("\nUid:");
+    if (pos == std::string_view::npos) return;
+
+    char* end = nullptr;
+    strtol(status.data() + pos + 5, &end, 10);
+    v.uid = strtol(end, nullptr, 10);
+}
+
+// Path in the unified hierarchy ("0::/path"), else of the first controller
+void parseCgroup(std::string_view content, Values& v)
+{
+    std::string_view path;
+    while (!content.empty()) {
+        size_t eol = content.find('\n');
+        std::string_view line = content.substr(0, eol);
+        content.remove_prefix(eol == std::string_view::npos ? content.size() : eol + 1);
+
+        size_t colon = line.find(':', line.find(':') + 1);
+        if (colon == std::string_view::npos) continue;
+        if (path.empty() || line.substr(0, 3) == "0::") path = line.substr(colon + 1);
+        if (line.substr(0, 3) == "0::") break;
+    }
+    v.cgroup = StringPool::internUtf8(path);
+
+    // The systemd unit is the deepest service or scope in the path
+    const QStringList parts = v.cgroup.split('/', Qt::SkipEmptyParts);
+    for (auto it = parts.crbegin(); it != parts.crend(); ++it) {
+        if (it->endsWith(".service") || it->endsWith(".scope")) {
+            v.unit = *it;
+            break;
+        }
+    }
+}
+
+// Arguments are NUL separated
+void parseCmdline(const std::string& content, Values& v)
+{
+    QByteArray data(content.data(), qsizetype(content.size()));
+    data.replace('\0', ' ');
+    v.cmdline = QString::fromUtf8(data).trimmed();
+}
+}
+
+ProcessGroupRule ProcessGroupRule::compile(const QString& text, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return ProcessGroupRule();
+    };
+
+    static const QHash<QString, Field> fieldNames = {
+        { "comm", Field::Comm }, { "parent", Field::Parent }, { "ppid", Field::Ppid },
+        { "uid", Field::Uid }, { "user", Field::Uid }, { "cgroup", Field::Cgroup },
+        { "unit", Field::Unit }, { "cmdline", Field::Cmdline }, { "exe", Field::Exe }
+    };
+
+    ProcessGroupRule rule;
+    rule.m_text = text.trimmed();
+    QList<Predicate> terms;
+
+    const qsizetype n = text.size();
+    qsizetype i = 0;
+    while (true) {
+        while (i < n && text[i].isSpace()) ++i;
+        if (i >= n) break;
+
+        qsizetype start = i;
+        while (i < n && text[i].isLetter()) ++i;
+        const QString name = text.mid(start, i - start).toLower();
+
+        if (name == "or" && (i >= n || text[i].isSpace())) {
+            if (terms.isEmpty()) return fail("\"or\" needs terms on both sides");
+            rule.m_alternatives.append(terms);
+            terms.clear();
+            continue;
+        }
+        if (!fieldNames.contains(name)) {
+            return fail(name.isEmpty() ? QString("Expected a field at position %1").arg(start + 1)
+                                       : QString("Unknown field \"%1\"").arg(name));
+        }
+
+        Predicate p;
+        p.field = fieldNames.value(name);
+        if (i < n && text[i] == '!') {
+            p.negate = true;
+            ++i;
+        }
+        if (i >= n || (text[i] != '=' && text[i] != '~')) {
+            return fail(QString("Expected = or ~ after \"%1\"").arg(name));
+        }
+        const bool regex = text[i] == '~';
+        ++i;
+
+        QString value;
+        if (i < n && text[i] == '"') {
+            bool closed = false;
+            for (++i; i < n; ++i) {
+                if (text[i] == '\\' && i + 1 < n && text[i + 1] == '"') {
+                    value += '"';
+                    ++i;
+                } else if (text[i] == '"') {
+                    closed = true;
+                    ++i;
+                    break;
+                } else {
+                    value += text[i];
+                }
+            }
+            if (!closed) return fail(QString("Unterminated quote in \"%1\"").arg(name));
+        } else {
+            while (i < n && !text[i].isSpace()) value += text[i++];
+        }
+        if (value.isEmpty()) return fail(QString("Missing value for \"%1\"").arg(name));
+
+        switch (p.field) {
+        case Field::Comm:
+        case Field::Parent:
+        case Field::Ppid:    p.stage = Stage::Stat; break;
+        case Field::Uid:     p.stage = Stage::Status; break;
+        case Field::Cgroup:
+        case Field::Unit:    p.stage = Stage::Cgroup; break;
+        case Field::Cmdline: p.stage = Stage::Cmdline; break;
+        case Field::Exe:     p.stage = Stage::Exe; break;
+        }
+
+        if (p.field == Field::Uid || p.field == Field::Ppid) {
+            if (regex) return fail(QString("\"%1\" takes a list, not a pattern").arg(name));
+            for (const QString& item : value.split(',', Qt::SkipEmptyParts)) {
+                bool ok = false;
+                uint number = item.toUInt(&ok);
+                if (!ok && name == "user") {
+                    // Resolved once here, not per process
+                    const struct passwd* pw = getpwnam(item.toLocal8Bit().constData());
+                    if (!pw) return fail(QString("Unknown user \"%1\"").arg(item));
+                    number = pw->pw_uid;
+                    ok = true;
+                }
+                if (!ok) return fail(QString("\"%1\" is not a number").arg(item));
+                p.numbers.append(number);
+            }
+            if (p.numbers.isEmpty()) return fail(QString("Missing value for \"%1\"").arg(name));
+        } else {
+            p.pattern.setPattern(regex ? value : globToPattern(value));
+            if (!p.pattern.isValid()) {
+                return fail(QString("Invalid pattern for \"%1\": %2").arg(name, p.pattern.errorString()));
+            }
+            p.pattern.optimize();
+        }
+        terms.append(p);
+    }
+
+    if (terms.isEmpty()) {
+        return fail(rule.m_alternatives.isEmpty() ? "Empty rule" : "\"or\" needs terms on both sides");
+    }
+    rule.m_alternatives.append(terms);
+    if (rule.m_alternatives.size() > MaxAlternatives) {
+        return fail(QString("At most %1 alternatives").arg(MaxAlternatives));
+    }
+
+    if (error) error->clear();
+    return rule;
+}
+
+// Stage by stage over the surviving candidates
+// Before a stage, processes with an alternative that has nothing left to check
+// are matches; the others only read the stage's file if one of their remaining
+// alternatives tests it.
+ProcessGroupMatch ProcessGroupRule::match(const QList<ProcessID>& pids,
+                                          const std::function<bool()>& isCanceled) const
+{
+    ProcessGroupMatch result;
+    result.candidates = pids.size();
+    if (!isValid()) return result;
+
+    constexpr int StageCount = int(Stage::Count);
+
+    // Alternatives with predicates in a stage, and in that stage or a later one
+    quint64 needs[StageCount] = {};
+    quint64 remaining[StageCount + 1] = {};
+    bool needParent = false;
+    for (int a = 0; a < m_alternatives.size(); ++a) {
+        for (const Predicate& p : m_alternatives[a]) {
+            needs[int(p.stage)] |= quint64(1) << a;
+            needParent |= p.field == Field::Parent;
+        }
+    }
+    for (int s = StageCount - 1; s >= 0; --s) {
+        remaining[s] = remaining[s + 1] | needs[s];
+    }
+
+    const quint64 all = m_alternatives.size() == 64 ? ~quint64(0) : (quint64(1) << m_alternatives.size()) - 1;
+    QList<Candidate> candidates;
+    candidates.reserve(pids.size());
+    for (ProcessID pid : pids) {
+        candidates.append({ pid, all });
+    }
+
+    // Comm of every process whose stat was read, parents are looked up here first
+    QHash<ProcessID, QString> names;
+
+    auto passes = [](const Predicate& p, const Values& v) {
+        bool hit = false;
+        switch (p.field) {
+        case Field::Comm:    hit = p.pattern.match(v.comm).hasMatch(); break;
+        case Field::Parent:  hit = p.pattern.match(v.parent).hasMatch(); break;
+        case Field::Ppid:    hit = v.ppid >= 0 && p.numbers.contains(uint(v.ppid)); break;
+        case Field::Uid:     hit = v.uid >= 0 && p.numbers.contains(uint(v.uid)); break;
+        case Field::Cgroup:  hit = p.pattern.match(v.cgroup).hasMatch(); break;
+        case Field::Unit:    hit = p.pattern.match(v.unit).hasMatch(); break;
+        case Field::Cmdline: hit = p.pattern.match(v.cmdline).hasMatch(); break;
+        case Field::Exe:     hit = p.pattern.match(v.exe).hasMatch(); break;
+        }
+        return hit != p.negate;
+    };
+
+    ProcfsReader& reader = ProcfsReader::forCurrentThread();
+    static const char* const stageFiles[] = { "/stat", "/status", "/cgroup", "/cmdline" };
+
+    for (int s = 0; s < StageCount && !candidates.isEmpty(); ++s) {
+        const Stage stage = Stage(s);
+
+        QList<Candidate> pending;
+        QList<int> toRead;
+        for (const Candidate& c : std::as_const(candidates)) {
+            if (c.alive & ~remaining[s]) {
+                result.pids.append(c.pid);
+                continue;
+            }
+            if (c.alive & needs[s]) toRead.append(pending.size());
+            pending.append(c);
+        }
+        candidates.swap(pending);
+
+        for (int start = 0; start < toRead.size(); start += ProcfsReader::BatchSize) {
+            ScanExecutor::checkpoint(isCanceled);
+            if (isCanceled && isCanceled()) return ProcessGroupMatch();
+
+            const int count = qMin(int(ProcfsReader::BatchSize), int(toRead.size() - start));
+            std::vector<std::string> contents;
+            if (stage != Stage::Exe) {
+                std::vector<std::string> paths;
+                paths.reserve(size_t(count));
+                for (int k = 0; k < count; ++k) {
+                    paths.push_back("/proc/" + std::to_string(candidates[toRead[start + k]].pid) + stageFiles[s]);
+                }
+                reader.readFiles(paths, contents);
+            }
+
+            for (int k = 0; k < count; ++k) {
+                Candidate& c = candidates[toRead[start + k]];
+                Values v;
+                switch (stage) {
+                case Stage::Stat:
+                    parseStat(contents[size_t(k)], v);
+                    names.insert(c.pid, v.comm);
+                    if (needParent && v.ppid > 0) {
+                        auto it = names.constFind(ProcessID(v.ppid));
+                        v.parent = it != names.constEnd() ? *it : MemoryAnalyzer::getProcessName(ProcessID(v.ppid));
+                    }
+                    ++result.statReads;
+                    break;
+                case Stage::Status:
+                    parseStatus(contents[size_t(k)], v);
+                    ++result.statusReads;
+                    break;
+                case Stage::Cgroup:
+                    parseCgroup(contents[size_t(k)], v);
+                    ++result.cgroupReads;
+                    break;
+                case Stage::Cmdline:
+                    parseCmdline(contents[size_t(k)], v);
+                    ++result.cmdlineReads;
+                    break;
+                case Stage::Exe:
+                    v.exe = MemoryAnalyzer::getExePath(c.pid);
+                    ++result.exeReads;
+                    break;
+                case Stage::Count:
+                    break;
+                }
+
+                const quint64 check = c.alive & needs[s];
+                for (int a = 0; a < m_alternatives.size(); ++a) {
+                    if (!(check & (quint64(1) << a))) continue;
+                    for (const Predicate& p : m_alternatives[a]) {
+                        if (p.stage == stage && !passes(p, v)) {
+                            c.alive &= ~(quint64(1) << a);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        candidates.removeIf([](const Candidate& c) { return c.alive == 0; });
+    }
+
+    // Whatever survived the last stage has an alternative fully checked
+    for (const Candidate& c : std::as_const(candidates)) {
+        result.pids.append(c.pid);
+    }
+    std::sort(result.pids.begin(), result.pids.end());
+    return result;
+}
+
+void ProcessGroupRule::analyze(QPromise<ProcessMemorySummary>& promise, const ProcessGroupRule& rule,
+                               const QString& name, bool usePSS)
+{
+    const ProcessGroupMatch matched = rule.match(MemoryAnalyzer::listPids(), [&promise]() {
+        return promise.isCanceled();
+    });
+    if (promise.isCanceled()) return;
+
+    MemoryAnalyzer::analyzePids(promise, matched.pids, name, usePSS);
+}
@@ -0,0 +1,80 @@
+#ifndef PROCESSGROUP_H
+#define PROCESSGROUP_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QRegularExpression>
+#include <QPromise>
+#include <functional>
+#include "memoryanalyzer.h"
+
+// Files read while matching, to show how much the predicates saved
+struct ProcessGroupMatch {
+    QList<ProcessID> pids;
+    int candidates = 0;
+    int statReads = 0;
+    int statusReads = 0;
+    int cgroupReads = 0;
+    int cmdlineReads = 0;
+    int exeReads = 0;
+};
+
+// User defined process group
+//
+//   rule := term+ ( "or" term+ )*
+//   term := field ( "=" | "!=" | "~" | "!~" ) value
+//
+// Terms are ANDed, "or" separates alternatives. "=" compares exactly with
+// * and ? wildcards, "~" searches a regular expression. Values with spaces
+// are quoted. Fields:
+//   comm, parent (comm of the parent), ppid, uid, user, cgroup,
+//   unit (systemd service or scope from the cgroup), cmdline, exe
+// uid and ppid take a comma separated list of numbers.
+//
+//   comm=python* uid=1001 cmdline~"worker|celery"
+//
+// Matching reads only what the predicates need, cheapest file first
+// (stat, status, cgroup, cmdline, then the exe link), and a file is only read
+// for processes that still can match. Smaps is read by the analysis of the
+// matching processes alone.
+class ProcessGroupRule
+{
+public:
+    ProcessGroupRule() = default;
+
+    static ProcessGroupRule compile(const QString& text, QString* error = nullptr);
+
+    bool isValid() const { return !m_alternatives.isEmpty(); }
+    QString text() const { return m_text; }
+
+    // isCanceled is checked between batches
+    ProcessGroupMatch match(const QList<ProcessID>& pids,
+                            const std::function<bool()>& isCanceled = {}) const;
+
+    // Match every process, then analyze the matching ones like a group scan
+    static void analyze(QPromise<ProcessMemorySummary>& promise, const ProcessGroupRule& rule,
+                        const QString& name, bool usePSS = true);
+
+private:
+    // In the order the fields are read
+    enum class Stage { Stat, Status, Cgroup, Cmdline, Exe, Count };
+
+    enum class Field { Comm, Parent, Ppid, Uid, Cgroup, Unit, Cmdline, Exe };
+
+    struct Predicate {
+        Field field = Field::Comm;
+        Stage stage = Stage::Stat;
+        bool negate = false;
+        QRegularExpression pattern;  // String fields
+        QVector<uint> numbers;       // uid and ppid
+    };
+
+    // Alternatives are tracked in a 64 bit mask per process
+    static constexpr int MaxAlternatives = 64;
+
+    QString m_text;
+    QList<QList<Predicate>> m_alternatives;
+};
+
+#endif // PROCESSGROUP_H
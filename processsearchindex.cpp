@@ -0,0 +1,197 @@
+#include "processsearchindex.h"
+
+#include <algorithm>
+
+// Distinct trigrams of a (lowercased) string, packed 16 bits per character
+void ProcessSearchIndex::trigramsOf(const QString& text, QVector<quint64>& out)
+{
+    out.resize(0);
+    const QChar* c = text.constData();
+    for (int i = 0; i + 2 < text.size(); ++i) {
+        out.append((quint64(c[i].unicode()) << 32) | (quint64(c[i + 1].unicode()) << 16) | c[i + 2].unicode());
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void ProcessSearchIndex::indexSlot(int slot)
+{
+    QVector<quint64> grams;
+    trigramsOf(m_entries[slot].textLower, grams);
+    for (quint64 gram : std::as_const(grams)) {
+        m_postings[gram].append(slot);
+    }
+}
+
+void ProcessSearchIndex::upsert(ProcessID pid, quint64 startTime, const QString& name, const QString& cmdline, long rssKB)
+{
+    auto it = m_slotByPid.constFind(pid);
+    if (it != m_slotByPid.constEnd()) {
+        Entry& existing = m_entries[*it];
+        // Same process, only the memory can have changed
+        if (existing.startTime == startTime && existing.name == name) {
+            existing.rssKB = rssKB;
+            return;
+        }
+        remove(pid);
+    }
+
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+    } else {
+        slot = m_entries.size();
+        m_entries.append(Entry());
+    }
+
+    Entry& e = m_entries[slot];
+    e.pid = pid;
+    e.startTime = startTime;
+    e.name = name;
+    e.nameLower = name.toLower();
+    e.textLower = QString("%1 %2 %3").arg(e.nameLower).arg(pid).arg(cmdline.left(MaxIndexedCmdline).toLower());
+    e.rssKB = rssKB;
+    e.live = true;
+
+    m_slotByPid.insert(pid, slot);
+    indexSlot(slot);
+}
+
+// Lazy removal, postings are only cleaned up by compact()
+void ProcessSearchIndex::remove(ProcessID pid)
+{
+    auto it = m_slotByPid.find(pid);
+    if (it == m_slotByPid.end()) return;
+
+    int slot = *it;
+    m_slotByPid.erase(it);
+    m_entries[slot] = Entry();
+    m_freeSlots.append(slot);
+
+    // Rebuild once stale postings would make up a good part of the index
+    if (++m_stalePostings > 1024 && m_stalePostings > m_slotByPid.size() / 2) {
+        compact();
+    }
+}
+
+void ProcessSearchIndex::setMemory(ProcessID pid, long rssKB)
+{
+    auto it = m_slotByPid.constFind(pid);
+    if (it != m_slotByPid.constEnd()) {
+        m_entries[*it].rssKB = rssKB;
+    }
+}
+
+quint64 ProcessSearchIndex::startTimeOf(ProcessID pid) const
+{
+    auto it = m_slotByPid.constFind(pid);
+    return it != m_slotByPid.constEnd() ? m_entries[*it].startTime : 0;
+}
+
+void ProcessSearchIndex::compact()
+{
+    m_postings.clear();
+    for (int slot = 0; slot < m_entries.size(); ++slot) {
+        if (m_entries[slot].live) indexSlot(slot);
+    }
+    m_stalePostings = 0;
+}
+
+// Match quality: exact name, name prefix, name substring, PID, command line
+int ProcessSearchIndex::qualityOf(const Entry& e, const QString& q) const
+{
+    if (e.nameLower == q) return 0;
+    if (e.nameLower.startsWith(q)) return 1;
+    if (e.nameLower.contains(q)) return 2;
+
+    bool isNumber;
+    int pid = q.toInt(&isNumber);
+    if (isNumber && (pid == e.pid || QString::number(e.pid).startsWith(q))) return 3;
+
+    if (e.textLower.contains(q)) return 4;
+    return -1;
+}
+
+QVector<ProcessSearchIndex::Match> ProcessSearchIndex::query(const QString& text, int limit) const
+{
+    QVector<Match> result;
+    const QString q = text.trimmed().toLower();
+    if (q.isEmpty() || limit <= 0) return result;
+
+    if (m_seen.size() < m_entries.size()) m_seen.resize(m_entries.size());
+    if (++m_stamp == 0) {
+        m_seen.fill(0);
+        m_stamp = 1;
+    }
+
+    auto consider = [&](int slot, int quality) {
+        if (slot >= m_entries.size() || m_seen[slot] == m_stamp) return;
+        const Entry& e = m_entries[slot];
+        if (!e.live) return;
+        int qual = quality >= 0 ? quality : qualityOf(e, q);
+        if (qual < 0) return;
+        m_seen[slot] = m_stamp;
+        result.append({ e.pid, e.name, e.rssKB, qual });
+    };
+
+    QVector<quint64> grams;
+    trigramsOf(q, grams);
+
+    if (grams.isEmpty()) {
+        // One or two characters, too short for trigrams, scan the names only
+        for (int slot = 0; slot < m_entries.size(); ++slot) {
+            const Entry& e = m_entries[slot];
+            if (e.live && (e.nameLower.contains(q) || QString::number(e.pid).startsWith(q))) {
+                consider(slot, -1);
+            }
+        }
+    } else {
+        // Verify the shortest posting list, every real match is in it
+        const QVector<int>* shortest = nullptr;
+        for (quint64 gram : std::as_const(grams)) {
+            auto it = m_postings.constFind(gram);
+            if (it == m_postings.constEnd()) {
+                shortest = nullptr;
+                break;
+            }
+            if (!shortest || it->size() < shortest->size()) shortest = &*it;
+        }
+        if (shortest) {
+            for (int slot : *shortest) consider(slot, -1);
+        }
+
+        // Nothing contains the query, rank by the share of query trigrams found (fuzzy)
+        if (result.isEmpty() && grams.size() >= 2) {
+            if (m_hits.size() < m_entries.size()) m_hits.resize(m_entries.size());
+            std::fill(m_hits.begin(), m_hits.end(), quint16(0));
+
+            for (quint64 gram : std::as_const(grams)) {
+                auto it = m_postings.constFind(gram);
+                if (it == m_postings.constEnd()) continue;
+                for (int slot : *it) {
+                    if (slot < m_hits.size()) m_hits[slot]++;
+                }
+            }
+
+            const int needed = (grams.size() * 6 + 9) / 10; // At least 60% of the trigrams
+            for (int slot = 0; slot < m_hits.size(); ++slot) {
+                if (m_hits[slot] >= needed) {
+                    consider(slot, 5 + (grams.size() - qMin<int>(m_hits[slot], grams.size())));
+                }
+            }
+        }
+    }
+
+    auto better = [](const Match& a, const Match& b) {
+        if (a.quality != b.quality) return a.quality < b.quality;
+        return a.rssKB > b.rssKB;
+    };
+
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), better);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), better);
+    }
+    return result;
+}
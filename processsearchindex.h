@@ -0,0 +1,69 @@
+#ifndef PROCESSSEARCHINDEX_H
+#define PROCESSSEARCHINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include "memoryanalyzer.h"
+
+// Search index over process name, PID and command line for the process picker
+// Every process is indexed by the trigrams of its lowercased search text.
+// Processes are added and removed incrementally, removed ones leave stale
+// postings behind that are dropped by a periodic compaction. Candidates from the
+// posting lists are always verified against the real text, so stale postings
+// never produce wrong matches.
+class ProcessSearchIndex
+{
+public:
+    struct Match {
+        ProcessID pid = 0;
+        QString name;
+        long rssKB = 0;
+        int quality = 0; // Lower is better
+    };
+
+    // Add or replace a process, startTime detects PID reuse
+    void upsert(ProcessID pid, quint64 startTime, const QString& name, const QString& cmdline, long rssKB);
+    void remove(ProcessID pid);
+    void setMemory(ProcessID pid, long rssKB);
+
+    bool contains(ProcessID pid) const { return m_slotByPid.contains(pid); }
+    quint64 startTimeOf(ProcessID pid) const;
+    QList<ProcessID> pids() const { return m_slotByPid.keys(); }
+    int size() const { return m_slotByPid.size(); }
+
+    // Ranked by match quality, then by memory use
+    // Falls back to trigram similarity when nothing contains the query
+    QVector<Match> query(const QString& text, int limit = 50) const;
+
+private:
+    struct Entry {
+        ProcessID pid = 0;
+        quint64 startTime = 0;
+        QString name;
+        QString nameLower;
+        QString textLower; // "name pid cmdline", cmdline truncated
+        long rssKB = 0;
+        bool live = false;
+    };
+
+    QVector<Entry> m_entries;
+    QVector<int> m_freeSlots;
+    QHash<ProcessID, int> m_slotByPid;
+    QHash<quint64, QVector<int>> m_postings;
+    int m_stalePostings = 0; // Entries removed since the last compaction
+
+    // Query scratch space, reused so queries don't allocate per slot
+    mutable QVector<quint32> m_seen;
+    mutable quint32 m_stamp = 0;
+    mutable QVector<quint16> m_hits;
+
+    static constexpr int MaxIndexedCmdline = 256;
+
+    static void trigramsOf(const QString& text, QVector<quint64>& out);
+    void indexSlot(int slot);
+    void compact();
+    int qualityOf(const Entry& e, const QString& q) const;
+};
+
+#endif // PROCESSSEARCHINDEX_H
@@ -0,0 +1,197 @@
+#include "processterminator.h"
+
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+int pidfdOpen(ProcessID pid)
+{
+#ifdef SYS_pidfd_open
+    return int(syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int pidfdSendSignal(int pidfd, int sig)
+{
+#ifdef SYS_pidfd_send_signal
+    return int(syscall(SYS_pidfd_send_signal, pidfd, sig, nullptr, 0));
+#else
+    Q_UNUSED(pidfd);
+    Q_UNUSED(sig);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Polling interval of the kill() fallback
+const int FallbackPollMs = 50;
+}
+
+ProcessTerminator::ProcessTerminator(QObject *parent) : QObject(parent)
+{
+}
+
+ProcessTerminator::~ProcessTerminator()
+{
+    for (const Pending& p : std::as_const(m_pending)) {
+        if (p.pidfd >= 0) close(p.pidfd);
+    }
+}
+
+void ProcessTerminator::terminate(ProcessID pid)
+{
+    start(pid, 0);
+}
+
+void ProcessTerminator::terminateAll(const QList<ProcessID>& pids)
+{
+    if (pids.isEmpty()) {
+        emit batchFinished(0, 0);
+        return;
+    }
+
+    int batch = m_nextBatch++;
+    m_batches.insert(batch, Batch{ int(pids.size()), 0, 0 });
+    for (ProcessID pid : pids) {
+        start(pid, batch);
+    }
+}
+
+// Zombies still answer kill(pid, 0), so check the state too
+bool ProcessTerminator::isAlive(ProcessID pid)
+{
+    if (kill(pid, 0) != 0 && errno == ESRCH) return false;
+
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) return false;
+    QByteArray line = stat.readLine();
+    int paren = line.lastIndexOf(')');
+    return paren < 0 || paren + 2 >= line.size() || line[paren + 2] != 'Z';
+}
+
+bool ProcessTerminator::sendSignal(ProcessID pid, const Pending& p, int sig)
+{
+    return p.pidfd >= 0 ? pidfdSendSignal(p.pidfd, sig) == 0 : kill(pid, sig) == 0;
+}
+
+void ProcessTerminator::start(ProcessID pid, int batch)
+{
+    Pending p;
+    p.batch = batch;
+
+    if (pid <= 0 || m_pending.contains(pid)) {
+        report(pid, batch, false, false, pid <= 0 ? "Invalid PID" : "Termination already in progress");
+        return;
+    }
+
+    p.pidfd = pidfdOpen(pid);
+    if (p.pidfd < 0 && errno == ESRCH) {
+        report(pid, batch, true, false, QString()); // Already gone
+        return;
+    }
+
+    m_pending.insert(pid, p);
+
+    if (!sendSignal(pid, p, SIGTERM)) {
+        const int error = errno;
+        finish(pid, error == ESRCH,
+               error == ESRCH ? QString() : QString("Failed to signal process %1: %2").arg(pid).arg(strerror(error)));
+        return;
+    }
+    qDebug() << "Sent SIGTERM to process" << pid << (p.pidfd >= 0 ? "(pidfd)" : "(kill)");
+
+    Pending& pending = m_pending[pid];
+    pending.deadlineMs = QDateTime::currentMSecsSinceEpoch() + m_gracePeriodMs;
+
+    if (pending.pidfd >= 0) {
+        pending.notifier = new QSocketNotifier(pending.pidfd, QSocketNotifier::Read, this);
+        connect(pending.notifier, &QSocketNotifier::activated, this, [this, pid]() { onExited(pid); });
+    }
+
+    // With a pidfd the timer only fires once at the deadline, without one it polls
+    pending.timer = new QTimer(this);
+    pending.timer->setSingleShot(pending.pidfd >= 0);
+    connect(pending.timer, &QTimer::timeout, this, [this, pid]() { onTimer(pid); });
+    pending.timer->start(pending.pidfd >= 0 ? m_gracePeriodMs : FallbackPollMs);
+}
+
+void ProcessTerminator::onExited(ProcessID pid)
+{
+    finish(pid, true, QString());
+}
+
+void ProcessTerminator::onTimer(ProcessID pid)
+{
+    auto it = m_pending.find(pid);
+    if (it == m_pending.end()) return;
+
+    // Fallback mode: poll until the process is gone
+    if (it->pidfd < 0 && !isAlive(pid)) {
+        finish(pid, true, QString());
+        return;
+    }
+    if (it->pidfd < 0 && QDateTime::currentMSecsSinceEpoch() < it->deadlineMs) return;
+
+    if (it->forced) {
+        // SIGKILL did not take effect within another grace period (D state, ...)
+        finish(pid, false, QString("Process %1 did not exit after SIGKILL").arg(pid));
+        return;
+    }
+
+    // Grace period over, escalate
+    it->forced = true;
+    if (!sendSignal(pid, *it, SIGKILL)) {
+        const int error = errno;
+        const bool gone = error == ESRCH;
+        finish(pid, gone, gone ? QString() : QString("Failed to kill process %1: %2").arg(pid).arg(strerror(error)));
+        return;
+    }
+    qDebug() << "Sent SIGKILL to process" << pid;
+
+    it->deadlineMs = QDateTime::currentMSecsSinceEpoch() + m_gracePeriodMs;
+    it->timer->start(it->pidfd >= 0 ? m_gracePeriodMs : FallbackPollMs);
+}
+
+void ProcessTerminator::finish(ProcessID pid, bool success, const QString& error)
+{
+    Pending p = m_pending.take(pid);
+    if (p.notifier) {
+        p.notifier->setEnabled(false);
+        p.notifier->deleteLater();
+    }
+    if (p.timer) {
+        p.timer->stop();
+        p.timer->deleteLater();
+    }
+    if (p.pidfd >= 0) close(p.pidfd);
+
+    report(pid, p.batch, success, p.forced, error);
+}
+
+void ProcessTerminator::report(ProcessID pid, int batch, bool success, bool forced, const QString& error)
+{
+    if (!error.isEmpty()) qWarning() << error;
+    emit processTerminated(pid, success, forced, error);
+
+    if (batch == 0) return;
+    auto it = m_batches.find(batch);
+    if (it == m_batches.end()) return;
+
+    (success ? it->succeeded : it->failed)++;
+    if (--it->remaining == 0) {
+        Batch b = m_batches.take(batch);
+        emit batchFinished(b.succeeded, b.failed);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef PROCESSTERMINATOR_H
+#define PROCESSTERMINATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <sys/types.h>
+
+class QSocketNotifier;
+class QTimer;
+
+typedef pid_t ProcessID;
+
+// Non-blocking process termination
+// Sends SIGTERM through a pidfd, waits for the pidfd to become readable (the
+// process exited) with a QSocketNotifier, and escalates to SIGKILL when the
+// grace period runs out. A pidfd keeps referring to the original process, so
+// a reused PID is never signalled. Kernels without pidfd_open (< 5.3) fall back
+// to kill() and polling from a timer, which still never blocks the event loop.
+class ProcessTerminator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessTerminator(QObject *parent = nullptr);
+    ~ProcessTerminator() override;
+
+    void setGracePeriod(int ms) { m_gracePeriodMs = qMax(0, ms); }
+    int gracePeriod() const { return m_gracePeriodMs; }
+
+    // Both return immediately, results come through the signals
+    void terminate(ProcessID pid);
+    void terminateAll(const QList<ProcessID>& pids);
+
+    bool isBusy() const { return !m_pending.isEmpty(); }
+
+signals:
+    void processTerminated(ProcessID pid, bool success, bool forced, const QString& error);
+    void batchFinished(int succeeded, int failed);
+
+private:
+    struct Pending {
+        int pidfd = -1;                      // -1 in fallback mode
+        QSocketNotifier* notifier = nullptr; // pidfd readable = process exited
+        QTimer* timer = nullptr;             // Grace period (and polling in fallback mode)
+        qint64 deadlineMs = 0;
+        bool forced = false;
+        int batch = 0;                       // 0 for single terminations
+    };
+
+    struct Batch {
+        int remaining = 0;
+        int succeeded = 0;
+        int failed = 0;
+    };
+
+    QHash<ProcessID, Pending> m_pending;
+    QHash<int, Batch> m_batches;
+    int m_nextBatch = 1;
+    int m_gracePeriodMs = 3000;
+
+    void start(ProcessID pid, int batch);
+    void onExited(ProcessID pid);
+    void onTimer(ProcessID pid);
+    void finish(ProcessID pid, bool success, const QString& error);
+    void report(ProcessID pid, int batch, bool success, bool forced, const QString& error);
+    bool sendSignal(ProcessID pid, const Pending& p, int sig);
+    static bool isAlive(ProcessID pid);
+};
+
+#endif // PROCESSTERMINATOR_H
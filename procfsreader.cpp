@@ -0,0 +1,374 @@
+#include "procfsreader.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef MEMYZE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace {
+// Size of each registered read buffer, one per file of a batch
+const size_t BufferSize = 32 * 1024;
+}
+
+#ifdef MEMYZE_HAVE_IO_URING
+
+// Minimal io_uring wrapper on raw syscalls (no liburing dependency)
+struct ProcfsReader::Ring
+{
+    int fd = -1;
+    unsigned entries = 0;
+
+    void* sqPtr = MAP_FAILED;
+    size_t sqSize = 0;
+    void* cqPtr = MAP_FAILED;
+    size_t cqSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned pending = 0; // SQEs queued but not submitted yet
+
+    // Registered buffers, allocated and pinned once for the lifetime of the ring
+    std::vector<char> buffers;
+    bool fixedBuffers = false;
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr) munmap(cqPtr, cqSize);
+        if (sqPtr != MAP_FAILED) munmap(sqPtr, sqSize);
+        if (fd >= 0) close(fd);
+    }
+
+    static std::unique_ptr<Ring> create(unsigned depth)
+    {
+        std::unique_ptr<Ring> ring(new Ring);
+
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring->fd = int(syscall(__NR_io_uring_setup, depth, &params));
+        if (ring->fd < 0) return nullptr; // ENOSYS, EPERM under seccomp...
+
+        // OPENAT, READ and CLOSE need 5.6+, ask the kernel rather than guess from
+        // the feature flags (backports, opcodes disabled by policy...)
+        if (!ring->supports({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_READ_FIXED, IORING_OP_CLOSE})) {
+            return nullptr;
+        }
+
+        ring->entries = params.sq_entries;
+        ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            ring->sqSize = ring->cqSize = std::max(ring->sqSize, ring->cqSize);
+        }
+
+        ring->sqPtr = mmap(nullptr, ring->sqSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+        if (ring->sqPtr == MAP_FAILED) return nullptr;
+
+        if (singleMmap) {
+            ring->cqPtr = ring->sqPtr;
+        } else {
+            ring->cqPtr = mmap(nullptr, ring->cqSize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+            if (ring->cqPtr == MAP_FAILED) return nullptr;
+        }
+
+        ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                                                     MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) return nullptr;
+
+        char* sq = static_cast<char*>(ring->sqPtr);
+        ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        char* cq = static_cast<char*>(ring->cqPtr);
+        ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Register the read buffers, if RLIMIT_MEMLOCK says no we still use them unregistered
+        ring->buffers.resize(size_t(ProcfsReader::BatchSize) * BufferSize);
+        std::vector<iovec> iovecs(ProcfsReader::BatchSize);
+        for (int i = 0; i < ProcfsReader::BatchSize; ++i) {
+            iovecs[i].iov_base = ring->buffers.data() + size_t(i) * BufferSize;
+            iovecs[i].iov_len = BufferSize;
+        }
+        ring->fixedBuffers = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS,
+                                     iovecs.data(), unsigned(iovecs.size())) == 0;
+
+        return ring;
+    }
+
+    // The probe itself is 5.6+, older kernels reject it, so a failure means no
+    bool supports(std::initializer_list<int> opcodes) const
+    {
+        const unsigned maxOps = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, maxOps) != 0) return false;
+
+        for (int opcode : opcodes) {
+            if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    char* buffer(int index) { return buffers.data() + size_t(index) * BufferSize; }
+
+    // Next free SQE, zeroed, the caller fills it in
+    io_uring_sqe* nextSqe()
+    {
+        unsigned tail = *sqTail + pending;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        pending++;
+        return sqe;
+    }
+
+    // Publish the queued SQEs and wait for at least waitFor completions
+    int submit(unsigned waitFor)
+    {
+        __atomic_store_n(sqTail, *sqTail + pending, __ATOMIC_RELEASE);
+        unsigned toSubmit = pending;
+        pending = 0;
+
+        int ret;
+        do {
+            ret = int(syscall(__NR_io_uring_enter, fd, toSubmit, waitFor,
+                              waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    bool popCqe(io_uring_cqe& out)
+    {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        out = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+#else
+
+struct ProcfsReader::Ring {};
+
+#endif // MEMYZE_HAVE_IO_URING
+
+ProcfsReader::ProcfsReader(bool allowIoUring)
+{
+#ifdef MEMYZE_HAVE_IO_URING
+    // MEMYZE_NO_IO_URING forces the synchronous path (useful for comparisons)
+    if (allowIoUring && !getenv("MEMYZE_NO_IO_URING")) {
+        // Every file of a batch can have one request in flight
+        m_ring = Ring::create(BatchSize);
+    }
+#else
+    (void)allowIoUring;
+#endif
+}
+
+ProcfsReader::~ProcfsReader() = default;
+
+ProcfsReader& ProcfsReader::forCurrentThread()
+{
+    thread_local ProcfsReader reader;
+    return reader;
+}
+
+void ProcfsReader::readFiles(const std::vector<std::string>& paths, std::vector<std::string>& contents)
+{
+    contents.resize(paths.size());
+    m_stats.files += paths.size();
+
+    if (!m_ring) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            readSync(paths[i], contents[i]);
+        }
+        return;
+    }
+
+    for (size_t start = 0; start < paths.size(); start += BatchSize) {
+        int count = int(std::min<size_t>(BatchSize, paths.size() - start));
+        if (m_ring) {
+            readBatchIoUring(&paths[start], &contents[start], count);
+        } else {
+            // The ring failed in an earlier batch
+            for (int i = 0; i < count; ++i) readSync(paths[start + i], contents[start + i]);
+        }
+    }
+}
+
+// Plain open/read/close fallback
+void ProcfsReader::readSync(const std::string& path, std::string& out)
+{
+    out.clear();
+
+    m_stats.syscalls++;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    char buf[BufferSize];
+    while (true) {
+        m_stats.syscalls++;
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out.append(buf, size_t(n));
+        m_stats.bytes += uint64_t(n);
+    }
+
+    m_stats.syscalls++;
+    close(fd);
+}
+
+#ifdef MEMYZE_HAVE_IO_URING
+
+// Open, read and close up to BatchSize files with three rounds of submissions
+void ProcfsReader::readBatchIoUring(const std::string* paths, std::string* contents, int count)
+{
+    Ring& ring = *m_ring;
+    int fds[BatchSize];
+    uint64_t offsets[BatchSize];
+    bool active[BatchSize];
+    std::fill(fds, fds + count, -1);
+    std::fill(active, active + count, false);
+
+    // Submit a round, false unless the kernel took all of it
+    auto submit = [&](int queued) {
+        m_stats.syscalls++;
+        return ring.submit(unsigned(queued)) == queued;
+    };
+
+    // Drain all completions of a round, callback receives (index, result)
+    // False when waiting failed with completions still outstanding
+    auto reap = [&](int expected, auto&& onCompletion) {
+        io_uring_cqe cqe;
+        while (expected > 0) {
+            if (!ring.popCqe(cqe)) {
+                m_stats.syscalls++;
+                if (ring.submit(1) < 0) return false;
+                continue;
+            }
+            onCompletion(int(cqe.user_data), cqe.res);
+            expected--;
+        }
+        return true;
+    };
+
+    // Late completions would land on the next batch's indices and fds, so the
+    // ring is retired and the whole batch read again synchronously
+    auto fail = [&]() {
+        for (int i = 0; i < count; ++i) {
+            if (fds[i] >= 0) close(fds[i]);
+        }
+        m_failedRing = std::move(m_ring);
+        for (int i = 0; i < count; ++i) readSync(paths[i], contents[i]);
+    };
+
+    // Round 1: open every file
+    for (int i = 0; i < count; ++i) {
+        contents[i].clear();
+        io_uring_sqe* sqe = ring.nextSqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(paths[i].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = uint64_t(i);
+    }
+    const bool opened = submit(count) && reap(count, [&](int i, int res) {
+        fds[i] = res;
+        offsets[i] = 0;
+        active[i] = res >= 0;
+    });
+    if (!opened) {
+        fail();
+        return;
+    }
+
+    // Round 2..n: read all open files in parallel until each hits EOF
+    // seq_file backed procfs files return about a page per read, so a short
+    // read does not mean EOF, only a zero length read does
+    while (true) {
+        int submitted = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!active[i]) continue;
+            io_uring_sqe* sqe = ring.nextSqe();
+            sqe->opcode = ring.fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            sqe->fd = fds[i];
+            sqe->addr = reinterpret_cast<uint64_t>(ring.buffer(i));
+            sqe->len = unsigned(BufferSize);
+            sqe->off = offsets[i];
+            sqe->buf_index = uint16_t(i);
+            sqe->user_data = uint64_t(i);
+            submitted++;
+        }
+        if (submitted == 0) break;
+
+        const bool readAll = submit(submitted) && reap(submitted, [&](int i, int res) {
+            if (res > 0) {
+                contents[i].append(ring.buffer(i), size_t(res));
+                offsets[i] += uint64_t(res);
+                m_stats.bytes += uint64_t(res);
+            } else if (res < 0) {
+                contents[i].clear();
+            }
+            active[i] = res > 0;
+        });
+        if (!readAll) {
+            fail();
+            return;
+        }
+    }
+
+    // Last round: close everything that was opened
+    int toClose = 0;
+    for (int i = 0; i < count; ++i) {
+        if (fds[i] < 0) continue;
+        io_uring_sqe* sqe = ring.nextSqe();
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fds[i];
+        sqe->user_data = uint64_t(i);
+        toClose++;
+    }
+    if (toClose > 0 && !(submit(toClose) && reap(toClose, [](int, int) {}))) {
+        // The contents are complete; the closes may still run, so closing the
+        // descriptors here could hit one another thread reopened
+        m_failedRing = std::move(m_ring);
+    }
+}
+
+#else
+
+void ProcfsReader::readBatchIoUring(const std::string* paths, std::string* contents, int count)
+{
+    for (int i = 0; i < count; ++i) readSync(paths[i], contents[i]);
+}
+
+#endif // MEMYZE_HAVE_IO_URING
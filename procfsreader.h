@@ -0,0 +1,55 @@
+#ifndef PROCFSREADER_H
+#define PROCFSREADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Batched reader for procfs files (smaps, comm, status...)
+// With io_uring available the opens, reads and closes of a whole batch are
+// submitted together and read into buffers registered once per reader, so a
+// batch costs a handful of syscalls instead of three or more per file.
+// Otherwise (no kernel support, blocked by seccomp, or built without it)
+// every file is read with plain open/read/close.
+class ProcfsReader
+{
+public:
+    struct Stats {
+        uint64_t files = 0;    // Files requested
+        uint64_t bytes = 0;    // Bytes read
+        uint64_t syscalls = 0; // Syscalls issued for the reads
+    };
+
+    explicit ProcfsReader(bool allowIoUring = true);
+    ~ProcfsReader();
+
+    ProcfsReader(const ProcfsReader&) = delete;
+    ProcfsReader& operator=(const ProcfsReader&) = delete;
+
+    // Read every path, contents[i] is left empty when path i could not be read
+    void readFiles(const std::vector<std::string>& paths, std::vector<std::string>& contents);
+
+    bool usingIoUring() const { return m_ring != nullptr; }
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    // One reader per worker thread, rings and buffers are reused across scans
+    static ProcfsReader& forCurrentThread();
+
+    // Batch size used by callers and by the ring internally
+    static constexpr int BatchSize = 32;
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> m_ring;
+    // A ring that failed mid-batch, kept alive (never used again) because the
+    // kernel may still complete requests into its buffers
+    std::unique_ptr<Ring> m_failedRing;
+    Stats m_stats;
+
+    void readSync(const std::string& path, std::string& out);
+    void readBatchIoUring(const std::string* paths, std::string* contents, int count);
+};
+
+#endif // PROCFSREADER_H
@@ -0,0 +1,187 @@
+#include "remoteagent.h"
+#include "historystore.h"
+#include "alertengine.h"
+#include "scanexecutor.h"
+#include "procfsreader.h"
+
+#include <QTcpSocket>
+#include <QDebug>
+#include <QDateTime>
+#include <cstdio>
+
+RemoteAgent::RemoteAgent(const QString& aggregatorHost, quint16 aggregatorPort,
+                         const QString& hostName, int intervalMs, QObject *parent)
+    : QObject(parent)
+    , m_aggregatorHost(aggregatorHost)
+    , m_aggregatorPort(aggregatorPort)
+    , m_hostName(hostName)
+    , m_socket(new QTcpSocket(this))
+{
+    m_sampleTimer.setInterval(intervalMs);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &RemoteAgent::sample);
+
+    m_reconnectTimer.setInterval(3000);
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &RemoteAgent::connectToAggregator);
+
+    connect(m_socket, &QTcpSocket::connected, this, &RemoteAgent::onConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &RemoteAgent::onDisconnected);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        qWarning() << "Agent connection error:" << m_socket->errorString();
+        if (m_socket->state() == QAbstractSocket::UnconnectedState) {
+            m_reconnectTimer.start();
+        }
+    });
+
+    connect(&m_watcher, &QFutureWatcher<AgentSample>::finished, this, &RemoteAgent::onSampleReady);
+
+    // Recorded samples are sealed every minute, an agent that is killed loses at most that
+    m_flushTimer.setInterval(60 * 1000);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() {
+        if (m_history) m_history->flush();
+    });
+}
+
+void RemoteAgent::start()
+{
+    m_statsClock.start();
+    connectToAggregator();
+    m_sampleTimer.start();
+    if (m_history) m_flushTimer.start();
+}
+
+void RemoteAgent::connectToAggregator()
+{
+    qDebug() << "Agent connecting to" << m_aggregatorHost << m_aggregatorPort;
+    m_socket->connectToHost(m_aggregatorHost, m_aggregatorPort);
+}
+
+void RemoteAgent::setAlertEngine(AlertEngine* engine)
+{
+    m_alerts = engine;
+    m_groupRules.clear();
+    if (!m_alerts) return;
+
+    for (const QString& target : m_alerts->targets(AlertTargetKind::Group)) {
+        QString error;
+        ProcessGroupRule rule = ProcessGroupRule::compile(target, &error);
+        if (rule.isValid()) {
+            m_groupRules.append({target, rule});
+        } else {
+            qWarning().noquote() << "Alert rule group:" << target << ":" << error;
+        }
+    }
+}
+
+// New connection, the aggregator knows nothing yet, so everything is resent
+void RemoteAgent::onConnected()
+{
+    m_encoder.reset();
+    send(m_encoder.hello(m_hostName));
+    sample();
+}
+
+void RemoteAgent::onDisconnected()
+{
+    qWarning() << "Agent lost connection to the aggregator, retrying";
+    m_reconnectTimer.start();
+}
+
+// Take a sample in the background, skipped while the previous one is still running
+void RemoteAgent::sample()
+{
+    if (m_watcher.isRunning()) return;
+    if (!m_history && !m_alerts && m_socket->state() != QAbstractSocket::ConnectedState) return;
+
+    m_watcher.setFuture(ScanExecutor::run([groupRules = m_groupRules]() {
+        AgentSample s;
+        // PSS so the per-process values of one host add up without double counting,
+        // a batch at a time so only one batch of smaps is held in memory
+        const QList<ProcessID> pids = MemoryAnalyzer::listPids();
+        s.processes.reserve(pids.size());
+        for (int start = 0; start < pids.size(); start += ProcfsReader::BatchSize) {
+            s.processes += MemoryAnalyzer::analyzePidBatch(pids.mid(start, ProcfsReader::BatchSize), true);
+        }
+        PortManager ports;
+        s.ports = ports.getOpenPorts();
+
+        // Groups are summed from the processes just sampled, like the group scans (Pss)
+        if (!groupRules.isEmpty()) {
+            QHash<ProcessID, int> indexOf;
+            for (int i = 0; i < s.processes.size(); ++i) indexOf.insert(s.processes[i].pid, i);
+
+            for (const auto& [target, rule] : groupRules) {
+                ProcessMemorySummary group;
+                group.processName = target;
+                for (ProcessID pid : rule.match(pids).pids) {
+                    const auto it = indexOf.constFind(pid);
+                    if (it == indexOf.cend()) continue;
+                    const ProcessMemorySummary& p = s.processes[*it];
+                    group.pvt += p.pvt;
+                    group.stk += p.stk;
+                    group.img += p.img;
+                    group.map += p.map;
+                }
+                group.total = group.pvt + group.stk + group.img + group.map;
+                s.groups.append(group);
+            }
+        }
+        return s;
+    }));
+}
+
+void RemoteAgent::onSampleReady()
+{
+    const AgentSample s = m_watcher.result();
+
+    // Keep the local history even while the aggregator is unreachable
+    if (m_history) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (const ProcessMemorySummary& p : s.processes) {
+            m_history->append(QString("%1[%2]").arg(p.processName).arg(p.pid).toStdString(),
+                              { now, p.pvt, p.stk, p.img, p.map });
+        }
+    }
+
+    // Alerts work without an aggregator too
+    if (m_alerts) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QList<AlertEvent> events;
+        for (const ProcessMemorySummary& p : s.processes) {
+            events += m_alerts->addSample(AlertSample::fromSummary(p, now));
+        }
+        for (const ProcessMemorySummary& g : s.groups) {
+            events += m_alerts->addSample(AlertSample::fromSummary(g, now, AlertTargetKind::Group));
+        }
+        for (const AlertSample& port : AlertSample::fromPorts(s.ports, now)) {
+            events += m_alerts->addSample(port);
+        }
+        // Processes that exited, or ports no longer open
+        events += m_alerts->prune(now - 3 * qint64(m_sampleTimer.interval()));
+
+        for (const AlertEvent& e : std::as_const(events)) {
+            printf("%s\n", e.toJson().constData());
+        }
+        if (!events.isEmpty()) fflush(stdout);
+    }
+
+    if (m_socket->state() != QAbstractSocket::ConnectedState) return;
+
+    send(m_encoder.encodeProcesses(s.processes));
+    send(m_encoder.encodePorts(s.ports));
+
+    // Report bandwidth every minute
+    if (m_statsClock.elapsed() >= 60000) {
+        qInfo() << "Agent sent" << m_bytesSent / (m_statsClock.elapsed() / 1000.0) / 1024.0
+                << "KB/s for" << s.processes.size() << "processes";
+        m_bytesSent = 0;
+        m_statsClock.restart();
+    }
+}
+
+void RemoteAgent::send(const QByteArray& frame)
+{
+    if (frame.isEmpty()) return;
+    m_socket->write(frame);
+    m_bytesSent += frame.size();
+}
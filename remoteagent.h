@@ -0,0 +1,68 @@
+#ifndef REMOTEAGENT_H
+#define REMOTEAGENT_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include "deltaprotocol.h"
+#include "processgroup.h"
+
+class QTcpSocket;
+class HistoryStore;
+class AlertEngine;
+
+// One sample of the local host, taken off the event loop
+struct AgentSample {
+    QList<ProcessMemorySummary> processes;
+    QList<PortInfo> ports;
+    QList<ProcessMemorySummary> groups; // One per group alert rule, named by the rule
+};
+
+// Headless agent of the multi-host mode
+// Samples every process and port on an interval and streams the changes to an
+// aggregator as delta frames, reconnecting (with a full resend) when the link drops
+class RemoteAgent : public QObject
+{
+    Q_OBJECT
+
+public:
+    RemoteAgent(const QString& aggregatorHost, quint16 aggregatorPort,
+                const QString& hostName, int intervalMs = 1000, QObject *parent = nullptr);
+
+    void start();
+    void setHistoryStore(HistoryStore* store) { m_history = store; } // Not owned
+    // Alert events are printed to stdout as JSON lines, group rules are
+    // evaluated on the processes of every sample
+    void setAlertEngine(AlertEngine* engine);                         // Not owned
+
+private slots:
+    void sample();
+    void onSampleReady();
+    void onConnected();
+    void onDisconnected();
+
+private:
+    QString m_aggregatorHost;
+    quint16 m_aggregatorPort;
+    QString m_hostName;
+
+    QTcpSocket* m_socket = nullptr;
+    QTimer m_sampleTimer;
+    QTimer m_reconnectTimer;
+    QTimer m_flushTimer;
+    QFutureWatcher<AgentSample> m_watcher;
+    DeltaEncoder m_encoder;
+    HistoryStore* m_history = nullptr;
+    AlertEngine* m_alerts = nullptr;
+    QList<QPair<QString, ProcessGroupRule>> m_groupRules; // By alert target
+
+    // Bandwidth accounting, logged periodically
+    QElapsedTimer m_statsClock;
+    qint64 m_bytesSent = 0;
+
+    void connectToAggregator();
+    void send(const QByteArray& frame);
+};
+
+#endif // REMOTEAGENT_H
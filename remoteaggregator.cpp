@@ -0,0 +1,116 @@
+#include "remoteaggregator.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+
+RemoteAggregator::RemoteAggregator(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &RemoteAggregator::onNewConnection);
+
+    // Agents send a frame per sample each, coalesce them into one UI update
+    m_notifyTimer.setInterval(1000);
+    connect(&m_notifyTimer, &QTimer::timeout, this, [this]() {
+        if (m_dirty) {
+            m_dirty = false;
+            emit updated();
+        }
+    });
+}
+
+RemoteAggregator::~RemoteAggregator() = default;
+
+bool RemoteAggregator::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::Any, port)) {
+        qWarning() << "Aggregator cannot listen on port" << port << ":" << m_server->errorString();
+        return false;
+    }
+    m_notifyTimer.start();
+    return true;
+}
+
+quint16 RemoteAggregator::port() const
+{
+    return m_server->serverPort();
+}
+
+void RemoteAggregator::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        m_agents.insert(socket, DeltaDecoder());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { onDisconnected(socket); });
+        qDebug() << "Agent connected from" << socket->peerAddress().toString();
+    }
+}
+
+void RemoteAggregator::onReadyRead(QTcpSocket* socket)
+{
+    auto it = m_agents.find(socket);
+    if (it == m_agents.end()) return;
+
+    if (!it->feed(socket->readAll())) {
+        qWarning() << "Malformed stream from agent" << it->host() << ", dropping connection";
+        socket->abort();
+        return;
+    }
+    m_dirty = true;
+}
+
+void RemoteAggregator::onDisconnected(QTcpSocket* socket)
+{
+    qDebug() << "Agent disconnected:" << m_agents.value(socket).host();
+    m_agents.remove(socket);
+    socket->deleteLater();
+    m_dirty = true;
+}
+
+QStringList RemoteAggregator::hosts() const
+{
+    QStringList result;
+    for (const DeltaDecoder& agent : m_agents) {
+        result << (agent.host().isEmpty() ? QString("unknown") : agent.host());
+    }
+    return result;
+}
+
+int RemoteAggregator::processCount() const
+{
+    int count = 0;
+    for (const DeltaDecoder& agent : m_agents) {
+        count += agent.processes().size();
+    }
+    return count;
+}
+
+ProcessMemorySummary RemoteAggregator::aggregate() const
+{
+    ProcessMemorySummary total;
+    total.processName = "Remote Aggregate";
+
+    for (const DeltaDecoder& agent : m_agents) {
+        for (const ProcessMemorySummary& s : agent.processes()) {
+            total.pvt += s.pvt;
+            total.stk += s.stk;
+            total.img += s.img;
+            total.map += s.map;
+        }
+    }
+
+    total.total = total.pvt + total.stk + total.img + total.map;
+    return total;
+}
+
+QList<PortInfo> RemoteAggregator::ports() const
+{
+    QList<PortInfo> result;
+    for (const DeltaDecoder& agent : m_agents) {
+        for (const PortInfo& info : agent.ports()) {
+            result.append(info);
+        }
+    }
+    return result;
+}
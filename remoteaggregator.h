@@ -0,0 +1,47 @@
+#ifndef REMOTEAGGREGATOR_H
+#define REMOTEAGGREGATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include "deltaprotocol.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+// Aggregator side of the multi-host mode
+// Accepts any number of agents, rebuilds each agent's process and port tables
+// from its delta stream, and exposes the merged view to MainWindow
+class RemoteAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RemoteAggregator(QObject *parent = nullptr);
+    ~RemoteAggregator() override;
+
+    bool listen(quint16 port);
+    quint16 port() const;
+
+    QStringList hosts() const;
+    int processCount() const;
+    ProcessMemorySummary aggregate() const; // Sum over every process of every agent
+    QList<PortInfo> ports() const;          // PortInfo::host tells the agent apart
+
+signals:
+    void updated(); // Throttled to once per second at most
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer* m_server = nullptr;
+    QHash<QTcpSocket*, DeltaDecoder> m_agents;
+    QTimer m_notifyTimer;
+    bool m_dirty = false;
+
+    void onReadyRead(QTcpSocket* socket);
+    void onDisconnected(QTcpSocket* socket);
+};
+
+#endif // REMOTEAGGREGATOR_H
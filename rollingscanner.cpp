@@ -0,0 +1,173 @@
+#include "rollingscanner.h"
+
+#include <QtAlgorithms>
+#include <algorithm>
+
+RollingScanner::RollingScanner(int shardCount, int maxPidsPerTick)
+    : m_maxPidsPerTick(qMax(1, maxPidsPerTick))
+{
+    m_clock.start();
+    setShardCount(shardCount);
+}
+
+void RollingScanner::setShardCount(int count)
+{
+    m_shards = QVector<Shard>(qMax(1, count));
+    m_current = 0;
+    m_plan.clear();
+}
+
+void RollingScanner::setMaxPidsPerTick(int count)
+{
+    m_maxPidsPerTick = qMax(1, count);
+}
+
+void RollingScanner::reset()
+{
+    setShardCount(m_shards.size());
+}
+
+// Stable shard assignment for a process
+int RollingScanner::shardOf(ProcessID pid, int shardCount)
+{
+    if (shardCount <= 1) return 0;
+
+    // splitmix64 finalizer, cheap and spreads consecutive PIDs well
+    quint64 h = quint64(quint32(pid));
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    return int(h % quint64(shardCount));
+}
+
+// PIDs of every shard, in ascending order
+// Only the /proc listing, no per-process read, so the first tick of a rotation
+// costs about as much as any other
+QVector<QList<ProcessID>> RollingScanner::partition(int shardCount)
+{
+    QVector<QList<ProcessID>> shards(qMax(1, shardCount));
+
+    QList<ProcessID> pids = MemoryAnalyzer::listPids();
+    std::sort(pids.begin(), pids.end());
+    for (ProcessID pid : std::as_const(pids)) {
+        shards[shardOf(pid, shards.size())].append(pid);
+    }
+    return shards;
+}
+
+// Analyze up to maxPids processes of the job's shard
+ShardSlice RollingScanner::scanSlice(SliceJob job)
+{
+    ShardSlice slice;
+    slice.shard = job.shard;
+    slice.shardCount = job.shardCount;
+    slice.summary.processName = "Rolling System-wide Analysis";
+
+    if (job.listProcesses) {
+        slice.plan = partition(job.shardCount);
+        job.pids = slice.plan.value(job.shard);
+    }
+
+    const QList<ProcessID> selected = job.pids.mid(0, job.maxPids);
+    slice.remaining = job.pids.mid(selected.size());
+    slice.shardDone = slice.remaining.isEmpty();
+
+    // Use PSS to avoid double-counting shared memory across processes
+    for (const ProcessMemorySummary& s : MemoryAnalyzer::analyzePidBatch(selected, true)) {
+        slice.summary.pvt += s.pvt;
+        slice.summary.stk += s.stk;
+        slice.summary.img += s.img;
+        slice.summary.map += s.map;
+    }
+    slice.processed = selected.size();
+
+    slice.summary.total = slice.summary.pvt + slice.summary.stk + slice.summary.img + slice.summary.map;
+    return slice;
+}
+
+SliceJob RollingScanner::nextJob() const
+{
+    SliceJob job;
+    job.shard = m_current;
+    job.shardCount = m_shards.size();
+    job.maxPids = m_maxPidsPerTick;
+    job.listProcesses = m_plan.isEmpty();
+    if (!job.listProcesses) job.pids = m_plan[m_current];
+    return job;
+}
+
+// Fold a finished slice into its shard and move on to the next slice
+void RollingScanner::commitSlice(const ShardSlice& slice)
+{
+    // Ignore stale slices (shard count changed while the slice was running)
+    if (slice.shardCount != m_shards.size() || slice.shard != m_current) return;
+
+    if (!slice.plan.isEmpty()) m_plan = slice.plan;
+    if (m_plan.size() == m_shards.size()) m_plan[slice.shard] = slice.remaining;
+
+    Shard& shard = m_shards[slice.shard];
+    shard.pending.pvt += slice.summary.pvt;
+    shard.pending.stk += slice.summary.stk;
+    shard.pending.img += slice.summary.img;
+    shard.pending.map += slice.summary.map;
+    shard.pendingCount += slice.processed;
+
+    if (!slice.shardDone) return;
+
+    shard.summary = shard.pending;
+    shard.summary.total = shard.summary.pvt + shard.summary.stk + shard.summary.img + shard.summary.map;
+    shard.processCount = shard.pendingCount;
+    shard.updatedAtMs = m_clock.elapsed();
+    shard.pending = ProcessMemorySummary();
+    shard.pendingCount = 0;
+
+    // A new rotation lists the process table again
+    m_current = (m_current + 1) % m_shards.size();
+    if (m_current == 0) m_plan.clear();
+}
+
+// Sum of the latest value of every shard
+ProcessMemorySummary RollingScanner::aggregate() const
+{
+    ProcessMemorySummary total;
+    total.processName = "Rolling System-wide Analysis";
+
+    for (const Shard& shard : m_shards) {
+        total.pvt += shard.summary.pvt;
+        total.stk += shard.summary.stk;
+        total.img += shard.summary.img;
+        total.map += shard.summary.map;
+    }
+
+    total.total = total.pvt + total.stk + total.img + total.map;
+    return total;
+}
+
+int RollingScanner::completedShards() const
+{
+    return int(std::count_if(m_shards.cbegin(), m_shards.cend(),
+                             [](const Shard& s) { return s.updatedAtMs >= 0; }));
+}
+
+int RollingScanner::trackedProcesses() const
+{
+    int count = 0;
+    for (const Shard& shard : m_shards) {
+        count += shard.processCount;
+    }
+    return count;
+}
+
+// Age of the stalest shard, tells how fresh the aggregate is
+qint64 RollingScanner::oldestShardAgeMs() const
+{
+    qint64 oldest = -1;
+    for (const Shard& shard : m_shards) {
+        if (shard.updatedAtMs < 0) return -1;
+        if (oldest < 0 || shard.updatedAtMs < oldest) oldest = shard.updatedAtMs;
+    }
+    return oldest < 0 ? -1 : m_clock.elapsed() - oldest;
+}
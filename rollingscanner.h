@@ -0,0 +1,78 @@
+#ifndef ROLLINGSCANNER_H
+#define ROLLINGSCANNER_H
+
+#include <QVector>
+#include <QElapsedTimer>
+#include "memoryanalyzer.h"
+
+// Work of one rolling scan tick, handed from the GUI to a worker
+struct SliceJob {
+    int shard = 0;
+    int shardCount = 1;
+    int maxPids = 500;
+    bool listProcesses = false;     // First tick of a rotation, split the process table first
+    QList<ProcessID> pids;          // PIDs of the shard not analyzed yet in this rotation
+};
+
+// Result of one rolling scan tick (a slice of a single shard)
+struct ShardSlice {
+    int shard = 0;
+    int shardCount = 1;             // Shard count the slice was computed for
+    int processed = 0;              // PIDs analyzed in this slice
+    QList<ProcessID> remaining;     // Rest of the shard for the next slice
+    QVector<QList<ProcessID>> plan; // PIDs of every shard, when the table was listed
+    bool shardDone = false;         // True when the whole shard has been covered
+    ProcessMemorySummary summary;
+};
+
+// Rolling scan for hosts with a huge process table
+// The process table is split into N shards by hashing the PID and every tick
+// analyzes at most maxPidsPerTick processes of the current shard. The table
+// is listed once per rotation over all shards, which only reads /proc itself;
+// processes started since, and PIDs reused by them, are picked up by the next
+// rotation. The aggregate is the sum of the most recent completed value of
+// every shard.
+class RollingScanner
+{
+public:
+    explicit RollingScanner(int shardCount = 8, int maxPidsPerTick = 500);
+
+    // Configuration (changing the shard count resets all shards)
+    void setShardCount(int count);
+    int shardCount() const { return m_shards.size(); }
+    void setMaxPidsPerTick(int count);
+    int maxPidsPerTick() const { return m_maxPidsPerTick; }
+
+    // Worker side: analyze the next slice of a shard, safe to run on any thread
+    static ShardSlice scanSlice(SliceJob job);
+    static int shardOf(ProcessID pid, int shardCount);
+    static QVector<QList<ProcessID>> partition(int shardCount);
+
+    // GUI side: work of the next slice and committing its result
+    SliceJob nextJob() const;
+    void commitSlice(const ShardSlice& slice);
+    void reset();
+
+    // Aggregated view
+    ProcessMemorySummary aggregate() const;
+    int completedShards() const;
+    int trackedProcesses() const;
+    qint64 oldestShardAgeMs() const; // -1 until every shard has been scanned once
+
+private:
+    struct Shard {
+        ProcessMemorySummary summary;  // Last completed value
+        ProcessMemorySummary pending;  // Accumulates slices until the shard is done
+        qint64 updatedAtMs = -1;
+        int processCount = 0;
+        int pendingCount = 0;
+    };
+
+    QVector<Shard> m_shards;
+    int m_maxPidsPerTick;
+    int m_current = 0;
+    QVector<QList<ProcessID>> m_plan;   // Unscanned PIDs per shard, empty between rotations
+    QElapsedTimer m_clock;
+};
+
+#endif // ROLLINGSCANNER_H
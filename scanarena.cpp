@@ -0,0 +1,99 @@
+#include "scanarena.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+std::atomic<size_t> reserved{0};
+}
+
+ScanArena::~ScanArena()
+{
+    for (const Chunk& chunk : m_chunks) {
+        reserved -= chunk.size;
+        free(chunk.data);
+    }
+}
+
+void* ScanArena::allocate(size_t size, size_t align)
+{
+    while (true) {
+        if (m_current < m_chunks.size()) {
+            Chunk& chunk = m_chunks[m_current];
+            size_t start = (m_offset + align - 1) & ~(align - 1);
+            if (start + size <= chunk.size) {
+                m_offset = start + size;
+                return chunk.data + start;
+            }
+
+            // Move on to the next kept chunk, if any
+            if (m_current + 1 < m_chunks.size()) {
+                ++m_current;
+                m_offset = 0;
+                continue;
+            }
+        }
+
+        // Oversized requests get a chunk of their own
+        size_t chunkSize = size + align > ChunkSize ? size + align : ChunkSize;
+        char* data = static_cast<char*>(malloc(chunkSize));
+        if (!data) throw std::bad_alloc();
+        m_chunks.push_back({ data, chunkSize });
+        reserved += chunkSize;
+        m_current = m_chunks.size() - 1;
+        m_offset = 0;
+    }
+}
+
+std::string_view ScanArena::copy(std::string_view text)
+{
+    if (text.empty()) return std::string_view();
+    char* data = static_cast<char*>(allocate(text.size(), 1));
+    memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+void ScanArena::rewind(size_t chunk, size_t offset)
+{
+    m_current = chunk;
+    m_offset = offset;
+}
+
+void ScanArena::reset()
+{
+    // Chunks beyond the first are returned, a scan that needed them was an outlier
+    for (size_t i = 1; i < m_chunks.size(); ++i) {
+        reserved -= m_chunks[i].size;
+        free(m_chunks[i].data);
+    }
+    if (m_chunks.size() > 1) m_chunks.resize(1);
+    rewind(0, 0);
+}
+
+size_t ScanArena::totalReserved()
+{
+    return reserved;
+}
+
+ScanArena& ScanArena::forCurrentThread()
+{
+    thread_local ScanArena arena;
+    return arena;
+}
+
+ScanArena::Scope::Scope(ScanArena& arena)
+    : m_arena(arena), m_chunk(arena.m_current), m_offset(arena.m_offset)
+{
+    ++m_arena.m_scopes;
+}
+
+ScanArena::Scope::~Scope()
+{
+    if (--m_arena.m_scopes == 0) {
+        m_arena.reset();
+    } else {
+        m_arena.rewind(m_chunk, m_offset);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SCANARENA_H
+#define SCANARENA_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for the transient data of one scan
+// Parsers copy what they keep (mapping paths, flags...) into the arena
+// instead of allocating a std::string each. A Scope marks the start of a
+// scan and releases everything allocated since in one step when it ends;
+// the first chunk is kept for the next scan on the same thread, the ones an
+// outlier scan needed are freed when the outermost scope ends.
+class ScanArena
+{
+public:
+    ScanArena() = default;
+    ~ScanArena();
+
+    ScanArena(const ScanArena&) = delete;
+    ScanArena& operator=(const ScanArena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+    std::string_view copy(std::string_view text);
+
+    // Releases everything, keeping the first chunk
+    void reset();
+
+    // Chunk memory held by the arenas of all threads
+    static size_t totalReserved();
+
+    // One arena per worker thread, like ProcfsReader
+    static ScanArena& forCurrentThread();
+
+    // Releases what was allocated within the scope when it ends (scopes nest)
+    class Scope {
+    public:
+        explicit Scope(ScanArena& arena = ScanArena::forCurrentThread());
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        ScanArena& m_arena;
+        size_t m_chunk;
+        size_t m_offset;
+    };
+
+    static constexpr size_t ChunkSize = 256 * 1024;
+
+private:
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Chunk> m_chunks;
+    size_t m_current = 0;     // Chunk being filled
+    size_t m_offset = 0;      // Fill level of the current chunk
+    int m_scopes = 0;         // Open scopes
+
+    void rewind(size_t chunk, size_t offset);
+};
+
+#endif // SCANARENA_H
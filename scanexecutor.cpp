@@ -0,0 +1,167 @@
+#include "scanexecutor.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+qint64 clockUs(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+struct State {
+    QThreadPool pool;
+    QMutex mutex;
+    ScanExecutor::Settings settings;
+    std::atomic<int> generation{0};
+    cpu_set_t initialCpus;
+    bool haveInitialCpus = false;
+
+    // Budget of the current period, overshoot carries over to the next ones
+    qint64 periodStartUs = 0;
+    qint64 periodUsedUs = 0;
+
+    std::atomic<qint64> scanCpuUs{0};
+    std::atomic<qint64> throttledUs{0};
+};
+
+State& state()
+{
+    static State s;
+    return s;
+}
+
+thread_local int t_generation = 0;
+thread_local qint64 t_lastCpuUs = -1;
+
+// Thread level: every call below only affects the calling thread
+void applyToCurrentThread(const ScanExecutor::Settings& settings, const State& s)
+{
+    sched_param param = {};
+    pthread_setschedparam(pthread_self(), settings.idle ? SCHED_IDLE : SCHED_OTHER, &param);
+    setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), settings.nice);
+
+    cpu_set_t cpus;
+    if (settings.cpus.isEmpty()) {
+        if (!s.haveInitialCpus) return;
+        cpus = s.initialCpus;
+    } else {
+        CPU_ZERO(&cpus);
+        for (int cpu : settings.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+        }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+}
+
+QThreadPool* ScanExecutor::pool()
+{
+    return &state().pool;
+}
+
+void ScanExecutor::configure(const Settings& settings)
+{
+    State& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    // Restored when a CPU list is removed again
+    if (!s.haveInitialCpus) {
+        CPU_ZERO(&s.initialCpus);
+        s.haveInitialCpus = sched_getaffinity(0, sizeof(s.initialCpus), &s.initialCpus) == 0;
+    }
+
+    s.settings = settings;
+    s.settings.periodMs = qMax(10, settings.periodMs);
+    s.pool.setMaxThreadCount(settings.threads > 0 ? settings.threads : QThread::idealThreadCount());
+    s.periodStartUs = clockUs(CLOCK_MONOTONIC);
+    s.periodUsedUs = 0;
+    ++s.generation;
+}
+
+ScanExecutor::Settings ScanExecutor::settings()
+{
+    State& s = state();
+    QMutexLocker lock(&s.mutex);
+    return s.settings;
+}
+
+bool ScanExecutor::parseCpuList(const QString& text, QList<int>& cpus)
+{
+    cpus.clear();
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList range = part.trimmed().split('-');
+        bool okFirst = false;
+        bool okLast = true;
+        const int first = range[0].toInt(&okFirst);
+        const int last = range.size() == 2 ? range[1].toInt(&okLast) : first;
+        if (!okFirst || !okLast || range.size() > 2 || first < 0 || last < first || last >= CPU_SETSIZE) return false;
+
+        for (int cpu = first; cpu <= last; ++cpu) cpus.append(cpu);
+    }
+    return !cpus.isEmpty();
+}
+
+void ScanExecutor::checkpoint(const std::function<bool()>& isCanceled)
+{
+    // The GUI thread is never throttled nor reniced
+    const QCoreApplication* app = QCoreApplication::instance();
+    if (app && QThread::currentThread() == app->thread()) return;
+
+    State& s = state();
+    const int generation = s.generation.load(std::memory_order_relaxed);
+    if (t_generation != generation) {
+        applyToCurrentThread(settings(), s);
+        t_generation = generation;
+    }
+
+    const qint64 cpuUs = clockUs(CLOCK_THREAD_CPUTIME_ID);
+    const qint64 usedUs = t_lastCpuUs < 0 ? 0 : cpuUs - t_lastCpuUs;
+    t_lastCpuUs = cpuUs;
+    s.scanCpuUs += usedUs;
+
+    QMutexLocker lock(&s.mutex);
+    const qint64 budgetUs = qint64(s.settings.cpuBudgetMs) * 1000;
+    if (budgetUs <= 0) return;
+
+    const qint64 periodUs = qint64(s.settings.periodMs) * 1000;
+    s.periodUsedUs += usedUs;
+    while (true) {
+        const qint64 now = clockUs(CLOCK_MONOTONIC);
+        const qint64 periods = (now - s.periodStartUs) / periodUs;
+        if (periods > 0) {
+            s.periodStartUs += periods * periodUs;
+            s.periodUsedUs = qMax<qint64>(0, s.periodUsedUs - periods * budgetUs);
+        }
+        if (s.periodUsedUs < budgetUs) return;
+        if (isCanceled && isCanceled()) return;
+
+        // Wait in small steps so a cancel is picked up quickly
+        const qint64 waitUs = qMin<qint64>(50000, s.periodStartUs + periodUs - now);
+        lock.unlock();
+        QThread::usleep(quint64(waitUs));
+        s.throttledUs += waitUs;
+        lock.relock();
+    }
+}
+
+ScanExecutor::Stats ScanExecutor::stats()
+{
+    const State& s = state();
+    Stats stats;
+    stats.processCpuMs = clockUs(CLOCK_PROCESS_CPUTIME_ID) / 1000;
+    stats.scanCpuMs = s.scanCpuUs.load() / 1000;
+    stats.throttledMs = s.throttledUs.load() / 1000;
+    stats.threads = s.pool.activeThreadCount();
+    return stats;
+}
@@ -0,0 +1,72 @@
+#ifndef SCANEXECUTOR_H
+#define SCANEXECUTOR_H
+
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <functional>
+
+// Thread pool every scan runs on, apart from the application's own work
+// Scan threads can be niced or put in SCHED_IDLE and pinned to a set of CPUs,
+// so a system-wide scan doesn't compete with the services it observes. The
+// CPU time all scan threads use is measured with CLOCK_THREAD_CPUTIME_ID at
+// checkpoints in the scan loops; once the budget of the current period is
+// spent, scans wait there for the next period instead of overrunning it.
+// Thread settings are applied lazily at the first checkpoint of every thread
+// after a change.
+class ScanExecutor
+{
+public:
+    struct Settings {
+        int threads = 0;            // 0 for one per core
+        int nice = 0;               // Nice level of the scan threads
+        bool idle = false;          // SCHED_IDLE, only runs on otherwise idle cores
+        QList<int> cpus;            // Empty for the CPUs the process may use
+        int cpuBudgetMs = 0;        // CPU time all scan threads may use per period, 0 for no limit
+        int periodMs = 1000;
+    };
+
+    static void configure(const Settings& settings);
+    static Settings settings();
+
+    // "0-3,8,10-11"
+    static bool parseCpuList(const QString& text, QList<int>& cpus);
+
+    static QThreadPool* pool();
+
+    template <typename... Args>
+    static auto run(Args&&... args)
+    {
+        return QtConcurrent::run(pool(), std::forward<Args>(args)...);
+    }
+
+    // Call between batches of scan work; waits while the budget is spent
+    // unless isCanceled turns true
+    static void checkpoint(const std::function<bool()>& isCanceled = {});
+
+    // Lets the pool start another thread while a task only sleeps (trackers
+    // waiting for their next sample), only inside tasks started with run()
+    class Idle
+    {
+    public:
+        Idle() { pool()->releaseThread(); }
+        ~Idle() { pool()->reserveThread(); }
+        Idle(const Idle&) = delete;
+        Idle& operator=(const Idle&) = delete;
+    };
+
+    // Own overhead since start
+    struct Stats {
+        qint64 processCpuMs = 0;    // Every thread of the process
+        qint64 scanCpuMs = 0;       // Counted at checkpoints
+        qint64 throttledMs = 0;     // Waited for the budget, summed over threads
+        int threads = 0;            // Busy scan threads
+    };
+    static Stats stats();
+
+private:
+    ScanExecutor() = delete;
+};
+
+#endif // SCANEXECUTOR_H
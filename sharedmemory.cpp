@@ -0,0 +1,167 @@
+#include "sharedmemory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace {
+bool startsWith(std::string_view text, std::string_view prefix)
+{
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// "fd:01", hex major and minor
+quint64 parseDevice(std::string_view dev)
+{
+    const size_t colon = dev.find(':');
+    if (colon == std::string_view::npos) return 0;
+    const unsigned long major = std::strtoul(std::string(dev.substr(0, colon)).c_str(), nullptr, 16);
+    const unsigned long minor = std::strtoul(std::string(dev.substr(colon + 1)).c_str(), nullptr, 16);
+    return makedev(major, minor);
+}
+
+QString sysvName(quint64 key)
+{
+    return QString("key 0x%1").arg(key, 8, 16, QChar('0'));
+}
+}
+
+qint64 SharedMemoryReport::residentKB() const
+{
+    qint64 total = 0;
+    for (const SharedSegment& segment : segments) total += segment.residentKB;
+    return total;
+}
+
+bool SharedMemoryScan::isShared(std::string_view path)
+{
+    return startsWith(path, "/SYSV") || startsWith(path, "/dev/shm/") || startsWith(path, "/memfd:");
+}
+
+// Mappings of one process arrive together, so its PID is only added once
+void SharedMemoryScan::add(ProcessID pid, const QString& name, std::string_view dev, unsigned long inode,
+                           std::string_view path, uint64_t extentKB, uint64_t pssKB, uint64_t swapPssKB)
+{
+    const Key key{parseDevice(dev), inode};
+    auto [it, inserted] = m_segments.try_emplace(key);
+    SharedSegment& segment = it->second;
+
+    if (inserted) {
+        static constexpr std::string_view deletedSuffix = " (deleted)";
+        segment.deleted = path.size() > deletedSuffix.size() &&
+                          path.substr(path.size() - deletedSuffix.size()) == deletedSuffix;
+        if (segment.deleted) path.remove_suffix(deletedSuffix.size());
+
+        segment.device = key.device;
+        segment.inode = key.inode;
+        if (startsWith(path, "/SYSV")) {
+            segment.kind = SharedSegment::SysV;
+            segment.name = sysvName(std::strtoull(std::string(path.substr(5)).c_str(), nullptr, 16));
+        } else if (startsWith(path, "/memfd:")) {
+            segment.kind = SharedSegment::Memfd;
+            segment.name = QString::fromUtf8(path.data() + 1, qsizetype(path.size() - 1));
+        } else {
+            segment.kind = SharedSegment::Posix;
+            segment.name = QString::fromUtf8(path.data(), qsizetype(path.size()));
+        }
+    }
+
+    segment.sizeKB = std::max<qint64>(segment.sizeKB, qint64(extentKB));
+    segment.residentKB += qint64(pssKB);
+    segment.swapKB += qint64(swapPssKB);
+    if (segment.pids.isEmpty() || segment.pids.last() != pid) {
+        segment.pids.append(pid);
+        segment.names.append(name);
+        segment.attached = segment.pids.size();
+    }
+}
+
+// key shmid perms size cpid lpid nattch uid gid cuid cgid atime dtime ctime rss swap
+// rss and swap (in bytes) are only there since Linux 4.0
+void SharedMemoryScan::readSysV()
+{
+    std::ifstream file("/proc/sysvipc/shm");
+    if (!file.is_open()) return;
+
+    // Mapped SysV segments carry the shmid as inode
+    std::unordered_map<quint64, Key> byId;
+    for (const auto& [key, segment] : m_segments) {
+        if (segment.kind == SharedSegment::SysV) byId.emplace(key.inode, key);
+    }
+
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        long long ipcKey = 0;
+        quint64 shmid = 0, size = 0, rss = 0, swap = 0;
+        int nattch = 0;
+        std::string perms, skip;
+        if (!(iss >> ipcKey >> shmid >> perms >> size >> skip >> skip >> nattch)) continue;
+        for (int field = 0; field < 7; ++field) iss >> skip;
+        const bool hasRss = bool(iss >> rss >> swap);
+
+        auto it = byId.find(shmid);
+        SharedSegment& segment = it != byId.end() ? m_segments[it->second] : m_segments[Key{0, shmid}];
+        if (it == byId.end()) {
+            segment.kind = SharedSegment::SysV;
+            segment.name = sysvName(quint32(ipcKey));
+            segment.inode = shmid;
+        }
+
+        segment.sizeKB = qint64(size / 1024);
+        segment.attached = nattch;
+        if (hasRss) {
+            segment.residentKB = qint64(rss / 1024);
+            segment.swapKB = qint64(swap / 1024);
+            segment.exact = true;
+        }
+    }
+}
+
+// tmpfs inodes count allocated pages, resident or swapped out
+void SharedMemoryScan::readPosix()
+{
+    DIR* dir = opendir("/dev/shm");
+    if (!dir) return;
+
+    while (dirent* entry = readdir(dir)) {
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        auto [it, inserted] = m_segments.try_emplace(Key{quint64(st.st_dev), quint64(st.st_ino)});
+        SharedSegment& segment = it->second;
+        if (inserted) {
+            segment.kind = SharedSegment::Posix;
+            segment.name = QString("/dev/shm/") + QString::fromUtf8(entry->d_name);
+            segment.device = st.st_dev;
+            segment.inode = st.st_ino;
+        }
+
+        segment.sizeKB = qint64(st.st_size / 1024);
+        segment.residentKB = std::max<qint64>(0, qint64(st.st_blocks) / 2 - segment.swapKB);
+        segment.exact = true;
+    }
+    closedir(dir);
+}
+
+SharedMemoryReport SharedMemoryScan::finish()
+{
+    readSysV();
+    readPosix();
+
+    SharedMemoryReport report;
+    report.segments.reserve(qsizetype(m_segments.size()));
+    for (auto& [key, segment] : m_segments) report.segments.append(std::move(segment));
+    m_segments.clear();
+
+    std::sort(report.segments.begin(), report.segments.end(), [](const SharedSegment& a, const SharedSegment& b) {
+        return a.residentKB > b.residentKB;
+    });
+    return report;
+}
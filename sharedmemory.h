@@ -0,0 +1,73 @@
+#ifndef SHAREDMEMORY_H
+#define SHAREDMEMORY_H
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include <QMetaType>
+#include <string_view>
+#include <unordered_map>
+#include "memoryanalyzer.h"
+
+// One shared memory segment, counted once however many processes map it (in KB)
+struct SharedSegment {
+    enum Kind { SysV, Posix, Memfd };
+
+    Kind kind = Posix;
+    QString name;               // /dev/shm path, memfd name or SysV key
+    quint64 device = 0;         // Key together with the inode (the shmid for SysV)
+    quint64 inode = 0;
+    bool deleted = false;       // Removed but still mapped
+
+    qint64 sizeKB = 0;
+    qint64 residentKB = 0;
+    qint64 swapKB = 0;
+    bool exact = false;         // Resident from the kernel, otherwise pages mapped by scanned processes
+    int attached = 0;           // Kernel's attach count for SysV, scanned processes otherwise
+    QList<ProcessID> pids;
+    QStringList names;
+};
+
+struct SharedMemoryReport {
+    QList<SharedSegment> segments;  // Most resident first
+
+    qint64 residentKB() const;
+};
+
+// Shared memory accounting
+// The system-wide scan hands every SysV, /dev/shm and memfd mapping it parses
+// in smaps to add(), so the segments need no procfs walk of their own. Summing
+// the Pss of a segment's mappings over every process gives the pages mapped by
+// any of them exactly once; finish() then fills in what only the kernel knows
+// (/proc/sysvipc/shm for SysV, the tmpfs inode for /dev/shm), including
+// segments nobody maps. memfd segments only held by a descriptor are not seen.
+// Not thread-safe, one per scan.
+class SharedMemoryScan
+{
+public:
+    static bool isShared(std::string_view path);
+
+    // Counters of one mapping, dev as printed in smaps ("00:01")
+    void add(ProcessID pid, const QString& name, std::string_view dev, unsigned long inode,
+             std::string_view path, uint64_t extentKB, uint64_t pssKB, uint64_t swapPssKB);
+
+    SharedMemoryReport finish();
+
+private:
+    struct Key {
+        quint64 device;
+        quint64 inode;
+        bool operator==(const Key& other) const { return device == other.device && inode == other.inode; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return std::hash<quint64>()(key.device * 31 + key.inode); }
+    };
+    std::unordered_map<Key, SharedSegment, KeyHash> m_segments;
+
+    void readSysV();
+    void readPosix();
+};
+
+Q_DECLARE_METATYPE(SharedMemoryReport)
+
+#endif // SHAREDMEMORY_H
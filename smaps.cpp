@@ -0,0 +1,156 @@
+#include "smaps.h"
+#include "procfsreader.h"
+#include "scanarena.h"
+
+#include <cstring>
+
+namespace {
+bool isHeader(const char* line, const char* end)
+{
+    // Field names start with an upper case letter, headers with a hex address
+    return line < end && ((*line >= '0' && *line <= '9') || (*line >= 'a' && *line <= 'f'));
+}
+
+uint64_t parseHex(const char*& p, const char* end)
+{
+    uint64_t value = 0;
+    for (; p < end; ++p) {
+        char c = *p;
+        int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (digit < 0) break;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+uint64_t parseDec(const char* p, const char* end)
+{
+    while (p < end && *p == ' ') ++p;
+    uint64_t value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) value = value * 10 + (*p - '0');
+    return value;
+}
+
+void skipSpaces(const char*& p, const char* end)
+{
+    while (p < end && *p == ' ') ++p;
+}
+
+void skipField(const char*& p, const char* end)
+{
+    while (p < end && *p != ' ') ++p;
+    skipSpaces(p, end);
+}
+
+// address perms offset dev inode pathname
+void parseHeader(const char* p, const char* end, Vma& vma, ScanArena& arena)
+{
+    vma.start = parseHex(p, end);
+    if (p < end && *p == '-') ++p;
+    vma.end = parseHex(p, end);
+    skipSpaces(p, end);
+
+    for (int i = 0; i < 4 && p < end && *p != ' '; ++i) vma.perms[i] = *p++;
+    skipSpaces(p, end);
+
+    vma.offset = parseHex(p, end);
+    skipSpaces(p, end);
+    skipField(p, end); // dev
+
+    vma.inode = (unsigned long)parseDec(p, end);
+    skipField(p, end);
+
+    if (p < end) vma.path = arena.copy(std::string_view(p, end - p));
+}
+
+struct Field {
+    const char* name;
+    size_t length;
+    uint64_t Vma::*member;
+};
+
+#define SMAPS_FIELD(name, member) { name ":", sizeof(name ":") - 1, &Vma::member }
+
+// In smaps order so the scan usually hits on the first comparisons
+const Field Fields[] = {
+    SMAPS_FIELD("Size", sizeKB),
+    SMAPS_FIELD("Rss", rssKB),
+    SMAPS_FIELD("Pss", pssKB),
+    SMAPS_FIELD("Shared_Clean", sharedCleanKB),
+    SMAPS_FIELD("Shared_Dirty", sharedDirtyKB),
+    SMAPS_FIELD("Private_Clean", privateCleanKB),
+    SMAPS_FIELD("Private_Dirty", privateDirtyKB),
+    SMAPS_FIELD("Referenced", referencedKB),
+    SMAPS_FIELD("Anonymous", anonymousKB),
+    SMAPS_FIELD("AnonHugePages", anonHugePagesKB),
+    SMAPS_FIELD("ShmemPmdMapped", shmemPmdMappedKB),
+    SMAPS_FIELD("FilePmdMapped", filePmdMappedKB),
+    SMAPS_FIELD("Shared_Hugetlb", sharedHugetlbKB),
+    SMAPS_FIELD("Private_Hugetlb", privateHugetlbKB),
+    SMAPS_FIELD("Swap", swapKB),
+};
+
+#undef SMAPS_FIELD
+}
+
+bool Vma::hasFlag(const char* flag) const
+{
+    for (size_t i = 0; i + 1 < vmFlags.size(); i += 3) {
+        if (vmFlags[i] == flag[0] && vmFlags[i + 1] == flag[1]) return true;
+    }
+    return false;
+}
+
+bool Smaps::read(pid_t pid, std::vector<Vma>& vmas)
+{
+    std::vector<std::string> paths = { "/proc/" + std::to_string(pid) + "/smaps" };
+    std::vector<std::string> contents;
+    ProcfsReader::forCurrentThread().readFiles(paths, contents);
+
+    vmas.clear();
+    if (contents[0].empty()) return false;
+
+    parse(contents[0], vmas, ScanArena::forCurrentThread());
+    return true;
+}
+
+void Smaps::parse(const std::string& content, std::vector<Vma>& vmas, ScanArena& arena)
+{
+    const char* p = content.data();
+    const char* const end = p + content.size();
+    Vma* current = nullptr;
+
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        if (isHeader(p, lineEnd)) {
+            vmas.emplace_back();
+            current = &vmas.back();
+            parseHeader(p, lineEnd, *current, arena);
+        } else if (current) {
+            size_t length = lineEnd - p;
+            bool matched = false;
+
+            for (const Field& field : Fields) {
+                if (length > field.length && memcmp(p, field.name, field.length) == 0) {
+                    current->*field.member = parseDec(p + field.length, lineEnd);
+                    matched = true;
+                    break;
+                }
+            }
+
+            if (!matched) {
+                if (length > 12 && memcmp(p, "THPeligible:", 12) == 0) {
+                    current->thpEligible = parseDec(p + 12, lineEnd) != 0;
+                } else if (length > 8 && memcmp(p, "VmFlags:", 8) == 0) {
+                    const char* flags = p + 8;
+                    skipSpaces(flags, lineEnd);
+                    current->vmFlags = arena.copy(std::string_view(flags, lineEnd - flags));
+                }
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef SMAPS_H
+#define SMAPS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+class ScanArena;
+
+// One mapping of /proc/<pid>/smaps, sizes in KB
+struct Vma {
+    uint64_t start = 0;
+    uint64_t end = 0;
+    char perms[5] = {0};
+    uint64_t offset = 0;
+    unsigned long inode = 0;
+    std::string_view path;        // Empty for anonymous mappings
+
+    uint64_t sizeKB = 0;
+    uint64_t rssKB = 0;
+    uint64_t pssKB = 0;
+    uint64_t sharedCleanKB = 0;
+    uint64_t sharedDirtyKB = 0;
+    uint64_t privateCleanKB = 0;
+    uint64_t privateDirtyKB = 0;
+    uint64_t referencedKB = 0;
+    uint64_t anonymousKB = 0;
+    uint64_t anonHugePagesKB = 0;
+    uint64_t shmemPmdMappedKB = 0;
+    uint64_t filePmdMappedKB = 0;
+    uint64_t sharedHugetlbKB = 0;
+    uint64_t privateHugetlbKB = 0;
+    uint64_t swapKB = 0;
+    bool thpEligible = false;
+    std::string_view vmFlags;     // Two letter flags separated by spaces
+
+    bool hasFlag(const char* flag) const;
+    uint64_t hugetlbKB() const { return sharedHugetlbKB + privateHugetlbKB; }
+};
+
+// Per-mapping smaps parser
+// The aggregate scans only need a couple of fields and sum them on the fly
+// (see MemoryAnalyzer), the per-mapping views (huge pages, residency,
+// layout...) need every mapping with its counters, which is what this gives.
+// Paths and flags are copied into a ScanArena (the thread's arena for read()),
+// they stay valid until the caller's ScanArena::Scope ends.
+class Smaps
+{
+public:
+    static bool read(pid_t pid, std::vector<Vma>& vmas);
+    static void parse(const std::string& content, std::vector<Vma>& vmas, ScanArena& arena);
+
+private:
+    Smaps() = delete;
+};
+
+#endif // SMAPS_H
@@ -0,0 +1,99 @@
+#include "sockdiag.h"
+
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/rtnetlink.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Large enough for a few hundred records per recv()
+const size_t ReceiveBufferSize = 64 * 1024;
+}
+
+bool SockDiag::dumpTcp(std::unordered_map<unsigned long, Entry>& out, bool withInfo)
+{
+    out.clear();
+
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd < 0) return false;
+
+    bool ok = dumpFamily(fd, AF_INET, withInfo, out) && dumpFamily(fd, AF_INET6, withInfo, out);
+    close(fd);
+
+    if (!ok) out.clear();
+    return ok;
+}
+
+bool SockDiag::dumpFamily(int fd, int family, bool withInfo, std::unordered_map<unsigned long, Entry>& out)
+{
+    struct {
+        nlmsghdr header;
+        inet_diag_req_v2 request;
+    } message;
+    memset(&message, 0, sizeof(message));
+
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.request.sdiag_family = uint8_t(family);
+    message.request.sdiag_protocol = IPPROTO_TCP;
+    message.request.idiag_states = ~0u;
+    if (withInfo) message.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+    sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(fd, &message, sizeof(message), 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    std::vector<char> buffer(ReceiveBufferSize);
+
+    while (true) {
+        ssize_t len = recv(fd, buffer.data(), buffer.size(), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (len == 0) return false;
+
+        for (auto* header = reinterpret_cast<nlmsghdr*>(buffer.data());
+             NLMSG_OK(header, size_t(len));
+             header = NLMSG_NEXT(header, len)) {
+            if (header->nlmsg_type == NLMSG_DONE) return true;
+            if (header->nlmsg_type == NLMSG_ERROR) return false;
+            if (header->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+
+            auto* msg = static_cast<inet_diag_msg*>(NLMSG_DATA(header));
+            if (msg->idiag_inode == 0) continue; // TIME_WAIT and orphans
+
+            Entry& entry = out[msg->idiag_inode];
+            entry.state = msg->idiag_state;
+            entry.rqueue = msg->idiag_rqueue;
+            entry.wqueue = msg->idiag_wqueue;
+
+            int attrLen = int(header->nlmsg_len) - int(NLMSG_LENGTH(sizeof(*msg)));
+            for (auto* attr = reinterpret_cast<rtattr*>(msg + 1); RTA_OK(attr, attrLen); attr = RTA_NEXT(attr, attrLen)) {
+                if (attr->rta_type != INET_DIAG_INFO) continue;
+
+                // Older kernels send a shorter tcp_info, missing fields stay zero
+                tcp_info info;
+                memset(&info, 0, sizeof(info));
+                memcpy(&info, RTA_DATA(attr), std::min(sizeof(info), size_t(RTA_PAYLOAD(attr))));
+
+                entry.hasInfo = true;
+                entry.rttUs = info.tcpi_rtt;
+                entry.totalRetrans = info.tcpi_total_retrans;
+            }
+        }
+    }
+}
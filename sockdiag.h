@@ -0,0 +1,32 @@
+#ifndef SOCKDIAG_H
+#define SOCKDIAG_H
+
+#include <cstdint>
+#include <unordered_map>
+
+// TCP socket details from NETLINK_SOCK_DIAG
+// One dump per address family returns every socket with its queues and,
+// when requested, its tcp_info. That is a single pass over the kernel's
+// socket hash with binary records, far cheaper than one getsockopt per
+// connection (which would need the socket in our own process anyway).
+class SockDiag
+{
+public:
+    struct Entry {
+        uint8_t state = 0;
+        uint32_t rqueue = 0;        // Listeners: accept queue depth, others: unread bytes
+        uint32_t wqueue = 0;        // Listeners: accept queue limit, others: unacked bytes
+        bool hasInfo = false;
+        uint32_t rttUs = 0;         // Smoothed RTT
+        uint32_t totalRetrans = 0;  // Retransmitted segments over the connection's lifetime
+    };
+
+    // Socket inode -> entry, for IPv4 and IPv6 TCP sockets
+    // Returns false if sock_diag is unavailable, out is then left empty
+    static bool dumpTcp(std::unordered_map<unsigned long, Entry>& out, bool withInfo);
+
+private:
+    static bool dumpFamily(int fd, int family, bool withInfo, std::unordered_map<unsigned long, Entry>& out);
+};
+
+#endif // SOCKDIAG_H
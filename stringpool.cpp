@@ -0,0 +1,205 @@
+#include "stringpool.h"
+
+#include <QMutex>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+const int ShardCount = 16;
+
+// Text as UTF-8 bytes or as UTF-16 code units, hashed and compared by code
+// point so both find the same entry without converting one into the other
+struct Key {
+    const char* utf8 = nullptr;
+    const char16_t* utf16 = nullptr;
+    size_t size = 0;            // Code units
+    size_t hash = 0;
+};
+
+// Next code point, invalid sequences give U+FFFD like QString::fromUtf8
+char32_t nextCodePoint(const char* text, size_t size, size_t& i)
+{
+    const uchar lead = uchar(text[i++]);
+    if (lead < 0x80) return lead;
+
+    const int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || i + size_t(extra) > size) return 0xFFFD;
+    char32_t cp = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        const uchar next = uchar(text[i]);
+        if ((next & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (next & 0x3F);
+        ++i;
+    }
+    return cp;
+}
+
+char32_t nextCodePoint(const char16_t* text, size_t size, size_t& i)
+{
+    const char16_t unit = text[i++];
+    if (QChar::isHighSurrogate(unit) && i < size && QChar::isLowSurrogate(text[i])) {
+        return QChar::surrogateToUcs4(unit, text[i++]);
+    }
+    return unit;
+}
+
+template<typename Unit>
+size_t hashOf(const Unit* text, size_t size)
+{
+    quint64 h = 14695981039346656037ULL;  // FNV-1a over code points
+    for (size_t i = 0; i < size;) {
+        h = (h ^ nextCodePoint(text, size, i)) * 1099511628211ULL;
+    }
+    return size_t(h);
+}
+
+template<typename A, typename B>
+bool sameText(const A* a, size_t aSize, const B* b, size_t bSize)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < aSize && j < bSize) {
+        if (nextCodePoint(a, aSize, i) != nextCodePoint(b, bSize, j)) return false;
+    }
+    return i == aSize && j == bSize;
+}
+
+struct KeyHash {
+    size_t operator()(const Key& key) const { return key.hash; }
+};
+
+// Stored keys are always UTF-8
+struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const
+    {
+        if (a.hash != b.hash) return false;
+        if (a.utf8 && b.utf8) return a.size == b.size && memcmp(a.utf8, b.utf8, a.size) == 0;
+        if (a.utf8) return b.utf16 ? sameText(a.utf8, a.size, b.utf16, b.size) : a.size == 0;
+        return b.utf8 ? sameText(b.utf8, b.size, a.utf16, a.size) : a.size == b.size;
+    }
+};
+
+// The stored key points into the entry's own copy of the bytes, which never
+// moves, so a lookup needs no temporary key
+struct Entry {
+    std::unique_ptr<char[]> bytes;
+    QString value;
+};
+
+struct Shard {
+    QMutex mutex;
+    std::unordered_map<Key, Entry, KeyHash, KeyEqual> strings;
+    quint64 hits = 0;
+    quint64 misses = 0;
+};
+
+Shard* shards()
+{
+    static Shard pool[ShardCount];
+    return pool;
+}
+
+// make returns the QString and its UTF-8 bytes, only called for new text
+template<typename MakeEntry>
+QString lookup(const Key& key, MakeEntry make)
+{
+    Shard& shard = shards()[key.hash % ShardCount];
+    QMutexLocker locker(&shard.mutex);
+
+    auto it = shard.strings.find(key);
+    if (it != shard.strings.end()) {
+        shard.hits++;
+        return it->second.value;
+    }
+
+    shard.misses++;
+    Entry entry;
+    const std::string_view bytes = make(entry.value);
+    entry.bytes.reset(new char[bytes.size()]);
+    memcpy(entry.bytes.get(), bytes.data(), bytes.size());
+
+    Key stored;
+    stored.utf8 = entry.bytes.get();
+    stored.size = bytes.size();
+    stored.hash = key.hash;
+    QString value = entry.value;
+    shard.strings.emplace(stored, std::move(entry));
+    return value;
+}
+}
+
+QString StringPool::internUtf8(std::string_view text)
+{
+    if (text.empty()) return QString();
+
+    Key key;
+    key.utf8 = text.data();
+    key.size = text.size();
+    key.hash = hashOf(key.utf8, key.size);
+    return lookup(key, [text](QString& value) {
+        value = QString::fromUtf8(text.data(), qsizetype(text.size()));
+        return text;
+    });
+}
+
+QString StringPool::internLatin1(std::string_view text)
+{
+    if (text.empty()) return QString();
+
+    // Latin-1 and UTF-8 only agree on ASCII, other text takes the QString path
+    for (char c : text) {
+        if (uchar(c) >= 0x80) return intern(QString::fromLatin1(text.data(), qsizetype(text.size())));
+    }
+    return internUtf8(text);
+}
+
+QString StringPool::intern(QStringView text)
+{
+    if (text.isEmpty()) return QString();
+
+    Key key;
+    key.utf16 = reinterpret_cast<const char16_t*>(text.utf16());
+    key.size = size_t(text.size());
+    key.hash = hashOf(key.utf16, key.size);
+
+    QByteArray utf8;
+    return lookup(key, [text, &utf8](QString& value) {
+        value = text.toString();
+        utf8 = text.toUtf8();
+        return std::string_view(utf8.constData(), size_t(utf8.size()));
+    });
+}
+
+int StringPool::collect()
+{
+    int removed = 0;
+    for (int i = 0; i < ShardCount; ++i) {
+        Shard& shard = shards()[i];
+        QMutexLocker locker(&shard.mutex);
+        for (auto it = shard.strings.begin(); it != shard.strings.end();) {
+            // Detached means nobody but the pool holds it
+            if (it->second.value.isDetached()) {
+                it = shard.strings.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return removed;
+}
+
+StringPool::Stats StringPool::stats()
+{
+    Stats s;
+    for (int i = 0; i < ShardCount; ++i) {
+        Shard& shard = shards()[i];
+        QMutexLocker locker(&shard.mutex);
+        s.strings += qsizetype(shard.strings.size());
+        for (const auto& entry : shard.strings) s.bytes += entry.second.value.size() * 2;
+        s.hits += shard.hits;
+        s.misses += shard.misses;
+    }
+    return s;
+}
@@ -0,0 +1,37 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+#include <QStringView>
+#include <string_view>
+
+// Process-wide string interning
+// Process names, library paths, protocols and socket states repeat across
+// processes and across every refresh. Interning hands out the same
+// implicitly shared QString for equal text, so each distinct string is stored
+// once however many scans, models and caches hold it. Lookups from raw bytes
+// do not build a QString unless the text is new.
+// The pool is sharded by hash, so worker threads rarely contend.
+class StringPool
+{
+public:
+    static QString intern(QStringView text);
+    static QString internLatin1(std::string_view text);
+    static QString internUtf8(std::string_view text);
+
+    // Drop strings only the pool still references, call once per scan generation
+    static int collect();
+
+    struct Stats {
+        qsizetype strings = 0;
+        qsizetype bytes = 0;   // UTF-16 payload of the pooled strings
+        quint64 hits = 0;
+        quint64 misses = 0;
+    };
+    static Stats stats();
+
+private:
+    StringPool() = delete;
+};
+
+#endif // STRINGPOOL_H
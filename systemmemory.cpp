@@ -0,0 +1,154 @@
+#include "systemmemory.h"
+
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#include <unistd.h>
+
+namespace {
+// Read a whole procfs file, they are small and report a size of 0
+QByteArray readProcFile(const char* path)
+{
+    QFile file(QString::fromLatin1(path));
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+}
+
+// Parse /proc/meminfo ("Name:   1234 kB")
+QHash<QString, qint64> SystemMemory::readMeminfo()
+{
+    QHash<QString, qint64> values;
+    const QByteArray data = readProcFile("/proc/meminfo");
+
+    for (const QByteArray& line : data.split('\n')) {
+        int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        QList<QByteArray> parts = line.mid(colon + 1).simplified().split(' ');
+        values.insert(QString::fromLatin1(line.left(colon)), parts.value(0).toLongLong());
+    }
+    return values;
+}
+
+// Parse /proc/vmstat ("name value")
+QHash<QString, qint64> SystemMemory::readVmstat()
+{
+    QHash<QString, qint64> values;
+    const QByteArray data = readProcFile("/proc/vmstat");
+
+    for (const QByteArray& line : data.split('\n')) {
+        int space = line.indexOf(' ');
+        if (space <= 0) continue;
+        values.insert(QString::fromLatin1(line.left(space)), line.mid(space + 1).trimmed().toLongLong());
+    }
+    return values;
+}
+
+// Parse /proc/slabinfo, needs root
+// name active_objs num_objs objsize objperslab pagesperslab : tunables ... : slabdata active_slabs num_slabs ...
+QList<SlabCache> SystemMemory::readSlabInfo(bool* ok)
+{
+    QList<SlabCache> caches;
+    const QByteArray data = readProcFile("/proc/slabinfo");
+    if (ok) *ok = !data.isEmpty();
+
+    static const qint64 pageKB = sysconf(_SC_PAGESIZE) / 1024;
+
+    for (const QByteArray& line : data.split('\n')) {
+        if (line.isEmpty() || line.startsWith("slabinfo") || line.startsWith('#')) continue;
+
+        QList<QByteArray> parts = line.simplified().split(' ');
+        if (parts.size() < 15) continue;
+
+        SlabCache cache;
+        cache.name = QString::fromLatin1(parts[0]);
+        cache.objects = parts[1].toLong();
+        const qint64 objSize = parts[3].toLongLong();
+        const qint64 pagesPerSlab = parts[5].toLongLong();
+        const qint64 numSlabs = parts[14].toLongLong();
+        cache.activeKB = cache.objects * objSize / 1024;
+        cache.sizeKB = numSlabs * pagesPerSlab * pageKB;
+        caches.append(cache);
+    }
+    return caches;
+}
+
+// Parse /proc/pressure/memory (PSI, kernel 4.20+)
+MemoryPressure SystemMemory::readPressure()
+{
+    MemoryPressure psi;
+    const QByteArray data = readProcFile("/proc/pressure/memory");
+
+    for (const QByteArray& line : data.split('\n')) {
+        const bool some = line.startsWith("some");
+        const bool full = line.startsWith("full");
+        if (!some && !full) continue;
+        psi.available = true;
+
+        for (const QByteArray& field : line.split(' ')) {
+            int eq = field.indexOf('=');
+            if (eq <= 0) continue;
+            const QByteArray key = field.left(eq);
+            const double value = field.mid(eq + 1).toDouble();
+            if (key == "avg10") (some ? psi.someAvg10 : psi.fullAvg10) = value;
+            else if (key == "avg60") (some ? psi.someAvg60 : psi.fullAvg60) = value;
+        }
+    }
+    return psi;
+}
+
+// Reconciled breakdown of MemTotal
+// Everything meminfo can attribute is listed, the remainder (driver pages,
+// vmalloc areas not otherwise counted, ...) is reported as unaccounted kernel memory
+SystemMemoryReport SystemMemory::read(int topSlabCount)
+{
+    SystemMemoryReport r;
+    const QHash<QString, qint64> mi = readMeminfo();
+    if (mi.isEmpty()) {
+        qWarning() << "Cannot read /proc/meminfo";
+        return r;
+    }
+
+    r.totalKB = mi.value("MemTotal");
+    r.availableKB = mi.value("MemAvailable");
+    r.swapTotalKB = mi.value("SwapTotal");
+    r.swapFreeKB = mi.value("SwapFree");
+
+    // Cached includes Shmem (tmpfs, shared anonymous), split it out
+    const qint64 shmem = mi.value("Shmem");
+    const qint64 pageCache = qMax<qint64>(0, mi.value("Cached") - shmem);
+    const qint64 hugetlb = mi.contains("Hugetlb") ? mi.value("Hugetlb")
+                                                  : mi.value("HugePages_Total") * mi.value("Hugepagesize");
+
+    r.items = {
+        { "Free", mi.value("MemFree"), false },
+        { "Anonymous (process private)", mi.value("AnonPages"), false },
+        { "Page cache (files)", pageCache, false },
+        { "Shared memory / tmpfs", shmem, false },
+        { "Buffers", mi.value("Buffers"), false },
+        { "Swap cache", mi.value("SwapCached"), false },
+        { "Hugetlb pool", hugetlb, false },
+        { "Slab (reclaimable)", mi.value("SReclaimable"), true },
+        { "Slab (unreclaimable)", mi.value("SUnreclaim"), true },
+        { "Page tables", mi.value("PageTables") + mi.value("SecPageTables"), true },
+        { "Kernel stacks", mi.value("KernelStack"), true },
+        { "Per-CPU allocations", mi.value("Percpu"), true },
+    };
+
+    qint64 accounted = 0;
+    for (const SystemMemoryItem& item : std::as_const(r.items)) {
+        accounted += item.kb;
+    }
+    r.items.append({ "Unaccounted kernel (drivers, vmalloc, ...)", qMax<qint64>(0, r.totalKB - accounted), true });
+
+    // Largest slab caches
+    QList<SlabCache> slabs = readSlabInfo(&r.slabInfoAvailable);
+    std::sort(slabs.begin(), slabs.end(), [](const SlabCache& a, const SlabCache& b) {
+        return a.sizeKB > b.sizeKB;
+    });
+    r.topSlabs = slabs.mid(0, topSlabCount);
+
+    r.pressure = readPressure();
+    r.vmstat = readVmstat();
+    return r;
+}
@@ -0,0 +1,66 @@
+#ifndef SYSTEMMEMORY_H
+#define SYSTEMMEMORY_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMetaType>
+
+// One line of the reconciled breakdown (in KB)
+struct SystemMemoryItem {
+    QString name;
+    qint64 kb = 0;
+    bool kernel = false; // Kernel side of the split
+};
+
+// One slab cache from /proc/slabinfo (in KB)
+struct SlabCache {
+    QString name;
+    qint64 sizeKB = 0;   // Memory held by the cache's slabs
+    qint64 activeKB = 0; // Memory of the objects in use
+    long objects = 0;
+};
+
+// Memory pressure stall information (avg10/avg60 in percent)
+struct MemoryPressure {
+    bool available = false;
+    double someAvg10 = 0;
+    double someAvg60 = 0;
+    double fullAvg10 = 0;
+    double fullAvg60 = 0;
+};
+
+// Whole system breakdown, every item adds up to MemTotal
+struct SystemMemoryReport {
+    qint64 totalKB = 0;
+    qint64 availableKB = 0;
+    qint64 swapTotalKB = 0;
+    qint64 swapFreeKB = 0;
+    QList<SystemMemoryItem> items;
+    QList<SlabCache> topSlabs;   // Largest first, empty without access to slabinfo
+    bool slabInfoAvailable = false;
+    MemoryPressure pressure;
+    QHash<QString, qint64> vmstat;
+};
+
+// System accounting from /proc/meminfo, /proc/vmstat, /proc/slabinfo and
+// /proc/pressure/memory. Only a handful of small files are read, so this
+// returns in milliseconds however many processes are running.
+class SystemMemory
+{
+public:
+    static SystemMemoryReport read(int topSlabCount = 10);
+
+    // "Key: value" files, values as printed (meminfo in KB, vmstat in pages/events)
+    static QHash<QString, qint64> readMeminfo();
+    static QHash<QString, qint64> readVmstat();
+    static QList<SlabCache> readSlabInfo(bool* ok = nullptr);
+    static MemoryPressure readPressure();
+
+private:
+    SystemMemory() = delete;
+};
+
+Q_DECLARE_METATYPE(SystemMemoryReport)
+
+#endif // SYSTEMMEMORY_H
@@ -0,0 +1,221 @@
+#include "deltaprotocol.h"
+
+#include <QtTest>
+
+using namespace DeltaProtocol;
+
+namespace {
+ProcessMemorySummary process(ProcessID pid, const QString& name, long pvt, long stk = 8, long img = 1000, long map = 0)
+{
+    ProcessMemorySummary s;
+    s.pid = pid;
+    s.processName = name;
+    s.pvt = pvt;
+    s.stk = stk;
+    s.img = img;
+    s.map = map;
+    s.total = pvt + stk + img + map;
+    return s;
+}
+
+PortInfo listener(unsigned long inode, quint64 netns, const QString& local, ProcessID pid, const QString& name)
+{
+    PortInfo info;
+    info.protocol = "TCP";
+    info.localAddress = local;
+    info.remoteAddress = "00000000:0000";
+    info.state = "0A";
+    info.inode = inode;
+    info.netns = netns;
+    info.pid = pid;
+    info.processName = name;
+    return info;
+}
+
+// Payload of a frame written by hand
+QByteArray frame(const QByteArray& payload)
+{
+    QByteArray out;
+    writeVarint(out, quint64(payload.size()));
+    return out + payload;
+}
+}
+
+class TestDeltaProtocol : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void varintRoundTrip();
+    void processRoundTrip();
+    void reusePortSockets();
+    void sameAddressInTwoNamespaces();
+    void namespaceLabel();
+    void splitFrames();
+    void truncatedFrameWaits();
+    void malformedFrames_data();
+    void malformedFrames();
+};
+
+void TestDeltaProtocol::varintRoundTrip()
+{
+    const quint64 values[] = { 0, 1, 127, 128, 300, 0xFFFFFFFFull, ~0ull };
+    for (quint64 value : values) {
+        QByteArray out;
+        writeVarint(out, value);
+        const char* p = out.constData();
+        quint64 read = 0;
+        QVERIFY(readVarint(p, out.constData() + out.size(), read));
+        QCOMPARE(read, value);
+        QVERIFY(p == out.constData() + out.size());
+    }
+    QCOMPARE(unzigzag(zigzag(-12345)), qint64(-12345));
+}
+
+// New, changed, unchanged and removed processes
+void TestDeltaProtocol::processRoundTrip()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    QVERIFY(decoder.feed(encoder.hello("node1")));
+    QCOMPARE(decoder.host(), QString("node1"));
+
+    QVERIFY(decoder.feed(encoder.encodeProcesses({ process(1, "init", 100), process(42, "db", 5000) })));
+    QCOMPARE(decoder.processes().size(), 2);
+    QCOMPARE(decoder.processes().value(42).processName, QString("db"));
+    QCOMPARE(decoder.processes().value(42).total, 6008L);
+
+    QVERIFY(encoder.encodeProcesses({ process(1, "init", 100), process(42, "db", 5000) }).isEmpty());
+
+    QVERIFY(decoder.feed(encoder.encodeProcesses({ process(42, "db", 4000, 8, 1200) })));
+    QCOMPARE(decoder.processes().size(), 1);
+    QCOMPARE(decoder.processes().value(42).pvt, 4000L);
+    QCOMPARE(decoder.processes().value(42).img, 1200L);
+    QCOMPARE(decoder.processes().value(42).total, 5208L);
+}
+
+// Workers sharing a port with SO_REUSEPORT are separate sockets
+void TestDeltaProtocol::reusePortSockets()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    const QString local = "00000000:1F90";
+
+    QVERIFY(decoder.feed(encoder.encodePorts({ listener(100, 1, local, 10, "worker"),
+                                               listener(101, 1, local, 11, "worker") })));
+    QCOMPARE(decoder.ports().size(), 2);
+    QCOMPARE(decoder.ports().value(PortKey(100, 1)).pid, ProcessID(10));
+    QCOMPARE(decoder.ports().value(PortKey(101, 1)).pid, ProcessID(11));
+    QCOMPARE(decoder.ports().value(PortKey(101, 1)).port, 8080);
+
+    QVERIFY(decoder.feed(encoder.encodePorts({ listener(101, 1, local, 11, "worker") })));
+    QCOMPARE(decoder.ports().size(), 1);
+    QVERIFY(decoder.ports().contains(PortKey(101, 1)));
+}
+
+void TestDeltaProtocol::sameAddressInTwoNamespaces()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    const QString local = "0100007F:0050";
+
+    QVERIFY(decoder.feed(encoder.encodePorts({ listener(7, 4026531840, local, 1, "nginx"),
+                                               listener(7, 4026532500, local, 2, "nginx") })));
+    QCOMPARE(decoder.ports().size(), 2);
+    QCOMPARE(decoder.ports().value(PortKey(7, 4026532500)).netns, quint64(4026532500));
+    QCOMPARE(decoder.ports().value(PortKey(7, 4026532500)).pid, ProcessID(2));
+}
+
+// The container label travels with the socket and follows its changes
+void TestDeltaProtocol::namespaceLabel()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    PortInfo info = listener(9, 4026532500, "00000000:0050", 3, "nginx");
+    info.namespaceLabel = "docker 0123456789ab";
+
+    QVERIFY(decoder.feed(encoder.encodePorts({ info })));
+    QCOMPARE(decoder.ports().value(PortKey(9, 4026532500)).namespaceLabel, QString("docker 0123456789ab"));
+
+    info.namespaceLabel = "netns 4026532500 (nginx)";
+    QVERIFY(decoder.feed(encoder.encodePorts({ info })));
+    QCOMPARE(decoder.ports().value(PortKey(9, 4026532500)).namespaceLabel, QString("netns 4026532500 (nginx)"));
+}
+
+// Bytes arriving one at a time still make whole frames
+void TestDeltaProtocol::splitFrames()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    const QByteArray stream = encoder.hello("node2") +
+                              encoder.encodeProcesses({ process(7, "app", 300000) }) +
+                              encoder.encodePorts({ listener(5, 1, "00000000:0016", 7, "app") });
+
+    for (char byte : stream) QVERIFY(decoder.feed(QByteArray(1, byte)));
+    QCOMPARE(decoder.host(), QString("node2"));
+    QCOMPARE(decoder.processes().value(7).pvt, 300000L);
+    QCOMPARE(decoder.ports().value(PortKey(5, 1)).host, QString("node2"));
+}
+
+void TestDeltaProtocol::truncatedFrameWaits()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    const QByteArray frame = encoder.encodeProcesses({ process(3, "sshd", 1024) });
+
+    QVERIFY(decoder.feed(frame.left(frame.size() - 1)));
+    QVERIFY(decoder.processes().isEmpty());
+    QVERIFY(decoder.feed(frame.right(1)));
+    QCOMPARE(decoder.processes().size(), 1);
+}
+
+void TestDeltaProtocol::malformedFrames_data()
+{
+    QTest::addColumn<QByteArray>("stream");
+
+    QByteArray tooLong;
+    writeVarint(tooLong, MaxFrameSize + 1);
+
+    QByteArray shortString;
+    shortString.append(char(Hello));
+    writeVarint(shortString, 50);
+    shortString.append("abc");
+
+    QByteArray missingRemoved;
+    missingRemoved.append(char(Processes));
+    writeVarint(missingRemoved, 0);
+
+    QByteArray trailingBytes;
+    trailingBytes.append(char(Processes));
+    writeVarint(trailingBytes, 0);
+    writeVarint(trailingBytes, 0);
+    trailingBytes.append("xx");
+
+    QByteArray cutPortRecord;
+    cutPortRecord.append(char(Ports));
+    writeVarint(cutPortRecord, 1);
+    writeVarint(cutPortRecord, 100);
+    writeVarint(cutPortRecord, 1);
+    cutPortRecord.append(char(FieldAddress));
+    cutPortRecord.append(char(0));
+
+    QTest::newRow("unknown type") << frame(QByteArray(1, char(99)));
+    QTest::newRow("empty payload") << frame(QByteArray());
+    QTest::newRow("frame too large") << tooLong;
+    QTest::newRow("endless varint") << QByteArray(11, char(0x80));
+    QTest::newRow("string past frame end") << frame(shortString);
+    QTest::newRow("missing removed count") << frame(missingRemoved);
+    QTest::newRow("trailing bytes") << frame(trailingBytes);
+    QTest::newRow("cut port record") << frame(cutPortRecord);
+}
+
+void TestDeltaProtocol::malformedFrames()
+{
+    QFETCH(QByteArray, stream);
+    DeltaDecoder decoder;
+    QVERIFY(!decoder.feed(stream));
+}
+
+QTEST_APPLESS_MAIN(TestDeltaProtocol)
+
+#include "tst_deltaprotocol.moc"
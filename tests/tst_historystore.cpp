@@ -0,0 +1,200 @@
+#include "historystore.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+const int64_t Minute = 60 * 1000;
+
+HistoryPoint point(int64_t timestampMs, int64_t pvt, int64_t stk = 136, int64_t img = 52000, int64_t map = 0)
+{
+    return { timestampMs, pvt, stk, img, map };
+}
+
+QStringList chunkFiles(const QString& directory)
+{
+    return QDir(directory).entryList({ "*.mhc" }, QDir::Files, QDir::Name);
+}
+}
+
+class TestHistoryStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void bufferedSamplesAreQueried();
+    void compactionKeepsEveryPoint();
+    void lateChunkSurvivesCompaction();
+    void interruptedCompactionShowsNoDuplicates();
+    void corruptChunkIsRejected();
+    void readOnlyCreatesNothing();
+};
+
+// Irregular timestamps and values that jump, shrink and go negative cover
+// every bucket of both encoders
+void TestHistoryStore::roundTrip()
+{
+    QTemporaryDir dir;
+    const std::vector<HistoryPoint> points = {
+        point(1000, 0), point(2000, 0), point(3000, 5), point(3001, -7, 0),
+        point(9000, 1LL << 40, 1), point(9100, 123456789, -1, 3), point(80000000, INT64_MAX, INT64_MIN, 7, 9),
+        point(80000001, 42), point(80005000, 42, 136, 52000, 17),
+    };
+    {
+        HistoryStore store(dir.path().toStdString(), 1000LL * 1000 * 1000);
+        for (const HistoryPoint& p : points) store.append("app[42]", p);
+        QVERIFY(store.flush());
+    }
+
+    HistoryStore store(dir.path().toStdString());
+    const std::vector<HistoryPoint> read = store.query("app[42]", 0, INT64_MAX);
+    QCOMPARE(read.size(), points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        QCOMPARE(read[i].timestampMs, points[i].timestampMs);
+        QCOMPARE(read[i].pvt, points[i].pvt);
+        QCOMPARE(read[i].stk, points[i].stk);
+        QCOMPARE(read[i].img, points[i].img);
+        QCOMPARE(read[i].map, points[i].map);
+    }
+    QCOMPARE(store.query("app[42]", 3000, 9000).size(), size_t(3));
+    QCOMPARE(store.listSeries(0, INT64_MAX), std::vector<std::string>{ "app[42]" });
+}
+
+void TestHistoryStore::bufferedSamplesAreQueried()
+{
+    QTemporaryDir dir;
+    HistoryStore store(dir.path().toStdString(), 10 * Minute);
+    store.append("a", point(0, 1));
+    store.append("a", point(Minute, 2));
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(2));
+    QVERIFY(chunkFiles(dir.path()).isEmpty());
+
+    // Crossing the window seals the first chunk
+    store.append("a", point(11 * Minute, 3));
+    QCOMPARE(chunkFiles(dir.path()).size(), 1);
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(3));
+}
+
+void TestHistoryStore::compactionKeepsEveryPoint()
+{
+    QTemporaryDir dir;
+    HistoryStore store(dir.path().toStdString(), Minute);
+    for (int i = 0; i < 30; ++i) {
+        store.append("a", point(i * 20000, i));
+        if (i % 2) store.append("b", point(i * 20000, -i));
+    }
+    QVERIFY(store.flush());
+    QCOMPARE(chunkFiles(dir.path()).size(), 10);
+
+    QCOMPARE(store.compact(INT64_MAX, 5 * Minute), 10);
+    QCOMPARE(chunkFiles(dir.path()).size(), 2);
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(30));
+    QCOMPARE(store.query("b", 0, INT64_MAX).size(), size_t(15));
+    QCOMPARE(store.query("b", 0, INT64_MAX).back().pvt, int64_t(-29));
+}
+
+// A chunk another writer seals after the compaction lies within the merged
+// range but is not one of its sources
+void TestHistoryStore::lateChunkSurvivesCompaction()
+{
+    QTemporaryDir dir;
+    HistoryStore store(dir.path().toStdString(), Minute);
+    for (int i = 0; i < 6; ++i) store.append("a", point(i * 30000, i));
+    QVERIFY(store.flush());
+    QVERIFY(store.compact(INT64_MAX, 10 * Minute) > 0);
+
+    {
+        HistoryStore late(dir.path().toStdString(), Minute);
+        late.append("a", point(45000, 100));
+    }
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(7));
+
+    store.compact(INT64_MAX, 10 * Minute);
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(7));
+}
+
+// Sources still on disk next to their merged chunk are skipped and deleted
+// by the next compaction
+void TestHistoryStore::interruptedCompactionShowsNoDuplicates()
+{
+    QTemporaryDir dir;
+    HistoryStore store(dir.path().toStdString(), Minute);
+    for (int i = 0; i < 4; ++i) store.append("a", point(i * Minute, i));
+    QVERIFY(store.flush());
+
+    const QStringList sources = chunkFiles(dir.path());
+    QHash<QString, QByteArray> contents;
+    for (const QString& name : sources) {
+        QFile file(dir.filePath(name));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        contents.insert(name, file.readAll());
+    }
+
+    QVERIFY(store.compact(INT64_MAX, 10 * Minute) > 0);
+    const QStringList merged = chunkFiles(dir.path());
+    QCOMPARE(merged.size(), 1);
+
+    // Put the state back to just after the rename
+    QFile list(dir.filePath(merged.first() + ".sources"));
+    QVERIFY(list.open(QIODevice::WriteOnly));
+    for (const QString& name : sources) {
+        list.write(name.toUtf8() + '\n');
+        QFile file(dir.filePath(name));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents.value(name));
+    }
+    list.close();
+
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(4));
+    QCOMPARE(store.compact(INT64_MAX, 10 * Minute), int(sources.size()));
+    QCOMPARE(chunkFiles(dir.path()), merged);
+    QVERIFY(!QFile::exists(list.fileName()));
+    QCOMPARE(store.query("a", 0, INT64_MAX).size(), size_t(4));
+}
+
+// Garbage columns make decoding fail instead of reading past them
+void TestHistoryStore::corruptChunkIsRejected()
+{
+    QTemporaryDir dir;
+    {
+        HistoryStore store(dir.path().toStdString(), Minute);
+        store.append("p", point(0, 1));
+        store.append("p", point(1000, 2));
+        store.append("p", point(2000, 4));
+    }
+    const QStringList files = chunkFiles(dir.path());
+    QCOMPARE(files.size(), 1);
+
+    QFile file(dir.filePath(files.first()));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const qint64 columns = 32 + 104 + 8; // Header, one directory entry, key padded to 8
+    QVERIFY(file.size() > columns);
+    file.seek(columns);
+    file.write(QByteArray(int(file.size() - columns), char(0xFF)));
+    file.close();
+
+    HistoryStore store(dir.path().toStdString(), Minute);
+    QVERIFY(store.query("p", 0, INT64_MAX).empty());
+}
+
+void TestHistoryStore::readOnlyCreatesNothing()
+{
+    QTemporaryDir dir;
+    const QString missing = dir.filePath("missing/history");
+
+    HistoryStore store(missing.toStdString(), HistoryStore::DefaultChunkWindowMs, HistoryStore::ReadOnly);
+    QVERIFY(!store.isValid());
+    QVERIFY(store.query("a", 0, INT64_MAX).empty());
+    store.append("a", point(0, 1));
+    store.flush();
+    QVERIFY(store.query("a", 0, INT64_MAX).empty());
+    QVERIFY(!QDir(missing).exists());
+    QVERIFY(!QDir(dir.filePath("missing")).exists());
+}
+
+QTEST_APPLESS_MAIN(TestHistoryStore)
+
+#include "tst_historystore.moc"
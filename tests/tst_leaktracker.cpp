@@ -0,0 +1,143 @@
+#include "leaktracker.h"
+
+#include <QtTest>
+
+namespace {
+const int64_t Minute = 60 * 1000;
+
+Vma anon(uint64_t start, uint64_t end, uint64_t privateKB, std::string_view path = {})
+{
+    Vma vma;
+    vma.start = start;
+    vma.end = end;
+    vma.path = path;
+    vma.sizeKB = (end - start) / 1024;
+    vma.rssKB = privateKB;
+    vma.privateDirtyKB = privateKB;
+    return vma;
+}
+}
+
+class TestLeakTracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void growthInPlace();
+    void mprotectSplit();
+    void mergedNeighbours();
+    void differentPathIsNewRegion();
+    void unmappedRegionDropped();
+    void suspectsRanking();
+};
+
+// A heap that grows at its end stays one region
+void TestLeakTracker::growthInPlace()
+{
+    LeakTracker tracker;
+    for (int i = 0; i < 4; ++i) {
+        tracker.addSample(i * Minute, { anon(0x10000, 0x20000 + i * 0x10000, 100 + i * 50, "[heap]") });
+    }
+
+    QCOMPARE(tracker.regionCount(), size_t(1));
+    const std::vector<LeakRegion> suspects = tracker.suspects(10);
+    QCOMPARE(suspects.size(), size_t(1));
+    QCOMPARE(suspects[0].kind, LeakRegion::Heap);
+    QCOMPARE(suspects[0].samples, 4u);
+    QCOMPARE(suspects[0].firstKB, uint64_t(100));
+    QCOMPARE(suspects[0].currentKB, uint64_t(250));
+    QCOMPARE(suspects[0].end, uint64_t(0x50000));
+    QVERIFY(suspects[0].slopeKBPerHour() > 0);
+}
+
+// mprotect on the middle of a mapping leaves three mappings of one region
+void TestLeakTracker::mprotectSplit()
+{
+    LeakTracker tracker;
+    tracker.addSample(0, { anon(0x100000, 0x400000, 300) });
+    tracker.addSample(Minute, { anon(0x100000, 0x200000, 100),
+                                anon(0x200000, 0x300000, 100),
+                                anon(0x300000, 0x400000, 150) });
+
+    QCOMPARE(tracker.regionCount(), size_t(1));
+    const std::vector<LeakRegion> suspects = tracker.suspects(10, 2);
+    QCOMPARE(suspects.size(), size_t(1));
+    QCOMPARE(suspects[0].mappings, 3u);
+    QCOMPARE(suspects[0].currentKB, uint64_t(350));
+    QCOMPARE(suspects[0].start, uint64_t(0x100000));
+    QCOMPARE(suspects[0].end, uint64_t(0x400000));
+}
+
+// Two regions the kernel merges into one mapping continue as the older one
+void TestLeakTracker::mergedNeighbours()
+{
+    LeakTracker tracker;
+    tracker.addSample(0, { anon(0x100000, 0x200000, 10) });
+    tracker.addSample(Minute, { anon(0x100000, 0x200000, 20), anon(0x300000, 0x400000, 5) });
+    QCOMPARE(tracker.regionCount(), size_t(2));
+
+    tracker.addSample(2 * Minute, { anon(0x100000, 0x400000, 40) });
+    QCOMPARE(tracker.regionCount(), size_t(1));
+
+    const std::vector<LeakRegion> suspects = tracker.suspects(10);
+    QCOMPARE(suspects.size(), size_t(1));
+    QCOMPARE(suspects[0].id, uint64_t(1));
+    QCOMPARE(suspects[0].samples, 3u);
+    QCOMPARE(suspects[0].firstKB, uint64_t(10));
+    QCOMPARE(suspects[0].currentKB, uint64_t(40));
+}
+
+// A mapping reusing the addresses of another path is a new region
+void TestLeakTracker::differentPathIsNewRegion()
+{
+    LeakTracker tracker;
+    tracker.addSample(0, { anon(0x100000, 0x200000, 10, "/usr/lib/liba.so") });
+    tracker.addSample(Minute, { anon(0x100000, 0x200000, 20, "/usr/lib/libb.so") });
+
+    tracker.addSample(2 * Minute, { anon(0x100000, 0x200000, 30, "/usr/lib/libb.so") });
+
+    QCOMPARE(tracker.regionCount(), size_t(1));
+    const std::vector<LeakRegion> suspects = tracker.suspects(10, 2);
+    QCOMPARE(suspects.size(), size_t(1));
+    QCOMPARE(suspects[0].id, uint64_t(2));
+    QCOMPARE(suspects[0].kind, LeakRegion::File);
+    QCOMPARE(suspects[0].samples, 2u);
+    QCOMPARE(suspects[0].firstKB, uint64_t(20));
+}
+
+void TestLeakTracker::unmappedRegionDropped()
+{
+    LeakTracker tracker;
+    tracker.addSample(0, { anon(0x100000, 0x200000, 10), anon(0x300000, 0x400000, 10) });
+    tracker.addSample(Minute, { anon(0x300000, 0x400000, 30) });
+
+    QCOMPARE(tracker.regionCount(), size_t(1));
+    QCOMPARE(tracker.totalKB(), uint64_t(30));
+}
+
+// Steady growth ranks above faster but mostly shrinking growth, too few samples
+// are left out
+void TestLeakTracker::suspectsRanking()
+{
+    LeakTracker tracker;
+    const uint64_t steady[] = { 100, 200, 300, 400, 500 };
+    const uint64_t noisy[] = { 100, 2000, 1500, 1000, 900 };
+    for (int i = 0; i < 5; ++i) {
+        std::vector<Vma> vmas = { anon(0x100000, 0x200000, steady[i]), anon(0x300000, 0x400000, noisy[i]) };
+        if (i >= 3) vmas.push_back(anon(0x500000, 0x600000, 1000 * uint64_t(i)));
+        tracker.addSample(i * Minute, vmas);
+    }
+
+    const std::vector<LeakRegion> suspects = tracker.suspects(10);
+    QCOMPARE(suspects.size(), size_t(2));
+    QCOMPARE(suspects[0].start, uint64_t(0x100000));
+    QCOMPARE(suspects[1].start, uint64_t(0x300000));
+    QVERIFY(suspects[0].score() > suspects[1].score());
+
+    QCOMPARE(tracker.suspects(1).size(), size_t(1));
+    QCOMPARE(tracker.suspects(10, 2).size(), size_t(3));
+}
+
+QTEST_APPLESS_MAIN(TestLeakTracker)
+
+#include "tst_leaktracker.moc"
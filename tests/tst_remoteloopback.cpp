@@ -0,0 +1,66 @@
+#include "remoteagent.h"
+#include "remoteaggregator.h"
+
+#include <QtTest>
+#include <memory>
+#include <vector>
+
+// Several agents streaming to one aggregator over the loopback interface
+class TestRemoteLoopback : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void severalAgents();
+
+private:
+    static constexpr int AgentCount = 3;
+    static constexpr int TimeoutMs = 15000;
+};
+
+void TestRemoteLoopback::severalAgents()
+{
+    RemoteAggregator aggregator;
+    QVERIFY(aggregator.listen(0));
+
+    QStringList names;
+    std::vector<std::unique_ptr<RemoteAgent>> agents;
+    for (int i = 0; i < AgentCount; ++i) {
+        names << QString("agent-%1").arg(i);
+        agents.push_back(std::make_unique<RemoteAgent>("127.0.0.1", aggregator.port(), names.last(), 200));
+        agents.back()->start();
+    }
+
+    // Every agent said hello under its own name
+    auto sortedHosts = [&aggregator]() {
+        QStringList hosts = aggregator.hosts();
+        hosts.sort();
+        return hosts;
+    };
+    QTRY_COMPARE_WITH_TIMEOUT(sortedHosts(), names, TimeoutMs);
+
+    // Every agent sees at least this process, and the aggregator's listener
+    // shows up once per agent with that agent's name
+    QTRY_VERIFY_WITH_TIMEOUT(aggregator.processCount() >= AgentCount, TimeoutMs);
+    QVERIFY(aggregator.aggregate().total > 0);
+
+    auto listenerHosts = [&aggregator]() {
+        QStringList hosts;
+        for (const PortInfo& info : aggregator.ports()) {
+            if (info.port == aggregator.port() && !hosts.contains(info.host)) hosts << info.host;
+        }
+        hosts.sort();
+        return hosts;
+    };
+    QTRY_COMPARE_WITH_TIMEOUT(listenerHosts(), names, TimeoutMs);
+
+    // A stopped agent is dropped together with its tables
+    agents.pop_back();
+    names.removeLast();
+    QTRY_COMPARE_WITH_TIMEOUT(sortedHosts(), names, TimeoutMs);
+    QTRY_COMPARE_WITH_TIMEOUT(listenerHosts(), names, TimeoutMs);
+}
+
+QTEST_GUILESS_MAIN(TestRemoteLoopback)
+
+#include "tst_remoteloopback.moc"
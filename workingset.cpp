@@ -0,0 +1,260 @@
+#include "workingset.h"
+#include "smaps.h"
+#include "scanarena.h"
+#include "scanexecutor.h"
+
+#include <QDateTime>
+#include <QThread>
+#include <QElapsedTimer>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace {
+const char* IdleBitmapPath = "/sys/kernel/mm/page_idle/bitmap";
+
+// pagemap entries read per pread (8 bytes each, 512 KB)
+const size_t PagemapChunk = 64 * 1024;
+
+// Bitmap words per pread/pwrite (8 bytes each, 1 MB)
+const size_t BitmapChunk = 128 * 1024;
+
+const quint64 PagePresent = 1ULL << 63;
+const quint64 PfnMask = (1ULL << 55) - 1;
+const int CategoryShift = 56;
+
+// Keeps a file descriptor closed on every path
+struct Fd {
+    int fd;
+    explicit Fd(int f) : fd(f) {}
+    ~Fd() { if (fd >= 0) close(fd); }
+};
+
+int categoryIndex(MemoryCategory category)
+{
+    return int(category);
+}
+}
+
+WorkingSetEstimator::WorkingSetEstimator(ProcessID pid) : m_pid(pid)
+{
+    m_report.pid = pid;
+    m_report.name = MemoryAnalyzer::getProcessName(pid);
+}
+
+// Mappings with their category, hugetlb and I/O mappings have no idle tracking
+bool WorkingSetEstimator::readMappings()
+{
+    ScanArena::Scope scope;
+    std::vector<Vma> vmas;
+    if (!Smaps::read(m_pid, vmas)) return false;
+
+    m_mappings.clear();
+    for (const Vma& vma : vmas) {
+        if (vma.hasFlag("ht") || vma.hasFlag("io") || vma.hasFlag("pf") || vma.path == "[vsyscall]") continue;
+
+        Mapping m;
+        m.start = vma.start;
+        m.end = vma.end;
+        m.category = MemoryAnalyzer::categorize(vma.path);
+        m_mappings.push_back(m);
+    }
+    return true;
+}
+
+template<typename Visitor>
+bool WorkingSetEstimator::forEachPresentPage(Visitor visit)
+{
+    Fd pagemap(open(("/proc/" + std::to_string(m_pid) + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC));
+    if (pagemap.fd < 0) return false;
+
+    static const quint64 pageSize = quint64(sysconf(_SC_PAGESIZE));
+    std::vector<quint64> entries(PagemapChunk);
+    bool sawPresent = false;
+    bool sawPfn = false;
+
+    for (size_t i = 0; i < m_mappings.size(); ++i) {
+        const Mapping& m = m_mappings[i];
+        for (quint64 page = m.start / pageSize; page < m.end / pageSize; page += PagemapChunk) {
+            size_t count = size_t(qMin<quint64>(PagemapChunk, m.end / pageSize - page));
+            ssize_t bytes = pread(pagemap.fd, entries.data(), count * 8, off_t(page * 8));
+            m_report.syscalls++;
+            if (bytes <= 0) break;
+
+            for (size_t j = 0; j < size_t(bytes) / 8; ++j) {
+                if (!(entries[j] & PagePresent)) continue;
+                sawPresent = true;
+
+                quint64 pfn = entries[j] & PfnMask;
+                if (pfn == 0) continue;
+                sawPfn = true;
+                visit(pfn, i);
+            }
+        }
+    }
+
+    // PFNs read as 0 without CAP_SYS_ADMIN
+    return !sawPresent || sawPfn;
+}
+
+// Set the idle bit of every resident page
+// Only our bits are set in the words written, zero bits are ignored by the
+// kernel, so whole runs of words can be written at once
+bool WorkingSetEstimator::markIdle()
+{
+    Fd bitmap(open(IdleBitmapPath, O_RDWR | O_CLOEXEC));
+    if (bitmap.fd < 0) return false;
+
+    std::vector<quint64> words;
+    bool ok = forEachPresentPage([&words](quint64 pfn, size_t) {
+        size_t word = size_t(pfn / 64);
+        if (word >= words.size()) words.resize(word + 1, 0);
+        words[word] |= 1ULL << (pfn % 64);
+    });
+    if (!ok) return false;
+
+    for (size_t first = 0; first < words.size(); first += BitmapChunk) {
+        size_t count = qMin(BitmapChunk, words.size() - first);
+
+        // Skip chunks without any of our pages
+        bool any = false;
+        for (size_t i = first; i < first + count && !any; ++i) any = words[i] != 0;
+        if (!any) continue;
+
+        ssize_t written = pwrite(bitmap.fd, words.data() + first, count * 8, off_t(first * 8));
+        m_report.syscalls++;
+        if (written < 0) return false;
+    }
+    return true;
+}
+
+// A page is active when its idle bit was cleared by an access since markIdle()
+// The bitmap is read once over the span of our PFNs, a page lookup is then a bit test.
+// pagemap is walked once: pages faulted in or migrated during a second walk
+// could fall outside the span read.
+bool WorkingSetEstimator::countIdle()
+{
+    Fd bitmap(open(IdleBitmapPath, O_RDONLY | O_CLOEXEC));
+    if (bitmap.fd < 0) return false;
+
+    // PFN with the category in the bits above it
+    std::vector<quint64> pages;
+    quint64 minPfn = ~0ULL;
+    quint64 maxPfn = 0;
+    if (!forEachPresentPage([&](quint64 pfn, size_t mapping) {
+            minPfn = qMin(minPfn, pfn);
+            maxPfn = qMax(maxPfn, pfn);
+            pages.push_back(pfn | quint64(categoryIndex(m_mappings[mapping].category)) << CategoryShift);
+        })) {
+        return false;
+    }
+    if (pages.empty()) return true; // Nothing resident
+
+    const size_t firstWord = size_t(minPfn / 64);
+    std::vector<quint64> words(size_t(maxPfn / 64) - firstWord + 1, 0);
+
+    for (size_t done = 0; done < words.size(); done += BitmapChunk) {
+        size_t count = qMin(BitmapChunk, words.size() - done);
+        ssize_t bytes = pread(bitmap.fd, words.data() + done, count * 8, off_t((firstWord + done) * 8));
+        m_report.syscalls++;
+        if (bytes < 0) return false;
+    }
+
+    static const qint64 pageKB = sysconf(_SC_PAGESIZE) / 1024;
+    for (quint64 page : pages) {
+        const quint64 pfn = page & PfnMask;
+        bool idle = words[size_t(pfn / 64) - firstWord] & (1ULL << (pfn % 64));
+        (idle ? m_report.idleKB : m_report.activeKB)[int(page >> CategoryShift)] += pageKB;
+    }
+    return true;
+}
+
+bool WorkingSetEstimator::clearRefs()
+{
+    Fd clear(open(("/proc/" + std::to_string(m_pid) + "/clear_refs").c_str(), O_WRONLY | O_CLOEXEC));
+    if (clear.fd < 0) return false;
+
+    // 1 clears the referenced/accessed bits of every page of the process
+    bool ok = write(clear.fd, "1", 1) == 1;
+    m_report.syscalls++;
+    return ok;
+}
+
+bool WorkingSetEstimator::countReferenced()
+{
+    ScanArena::Scope scope;
+    std::vector<Vma> vmas;
+    if (!Smaps::read(m_pid, vmas)) return false;
+
+    for (const Vma& vma : vmas) {
+        int category = categoryIndex(MemoryAnalyzer::categorize(vma.path));
+        qint64 referenced = qint64(qMin(vma.referencedKB, vma.rssKB));
+        m_report.activeKB[category] += referenced;
+        m_report.idleKB[category] += qint64(vma.rssKB) - referenced;
+    }
+    return true;
+}
+
+bool WorkingSetEstimator::start()
+{
+    m_startedMs = QDateTime::currentMSecsSinceEpoch();
+
+    if (!readMappings()) {
+        m_report.error = QString("Cannot read smaps of PID %1").arg(m_pid);
+        return false;
+    }
+
+    if (markIdle()) {
+        m_report.method = WorkingSetReport::PageIdle;
+        return true;
+    }
+
+    if (clearRefs()) {
+        m_report.method = WorkingSetReport::ClearRefs;
+        return true;
+    }
+
+    m_report.error = QString("Cannot track PID %1: %2 (page_idle needs root, clear_refs needs the process owner)")
+                         .arg(m_pid).arg(strerror(errno));
+    return false;
+}
+
+WorkingSetReport WorkingSetEstimator::finish()
+{
+    m_report.windowMs = int(QDateTime::currentMSecsSinceEpoch() - m_startedMs);
+
+    bool ok = m_report.method == WorkingSetReport::PageIdle ? countIdle() : countReferenced();
+    if (ok) {
+        m_report.ok = true;
+    } else if (m_report.error.isEmpty()) {
+        m_report.error = QString("PID %1 could not be read back, it may have exited").arg(m_pid);
+    }
+    return m_report;
+}
+
+void WorkingSetEstimator::estimate(QPromise<WorkingSetReport>& promise, ProcessID pid, int windowMs)
+{
+    WorkingSetEstimator estimator(pid);
+    if (!estimator.start()) {
+        promise.addResult(estimator.m_report);
+        return;
+    }
+
+    // Wait out the window in small steps so a cancel is picked up quickly
+    promise.setProgressRange(0, windowMs);
+    QElapsedTimer waited;
+    waited.start();
+    {
+        // Only sleeps, other scans may have the thread meanwhile
+        ScanExecutor::Idle idle;
+        while (waited.elapsed() < windowMs) {
+            if (promise.isCanceled()) return;
+            QThread::msleep(quint64(qMin<qint64>(100, windowMs - waited.elapsed())));
+            promise.setProgressValue(int(qMin<qint64>(waited.elapsed(), windowMs)));
+        }
+    }
+
+    promise.addResult(estimator.finish());
+}
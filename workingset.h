@@ -0,0 +1,75 @@
+#ifndef WORKINGSET_H
+#define WORKINGSET_H
+
+#include <QString>
+#include <QPromise>
+#include <QMetaType>
+#include <vector>
+#include "memoryanalyzer.h"
+
+// Active and idle memory of one process over a window (in KB)
+// Indexed by MemoryCategory
+struct WorkingSetReport {
+    enum Method {
+        PageIdle,   // /sys/kernel/mm/page_idle/bitmap, page granular, needs root
+        ClearRefs   // /proc/<pid>/clear_refs + smaps Referenced, owner is enough
+    };
+
+    ProcessID pid = 0;
+    QString name;
+    bool ok = false;
+    QString error;
+    Method method = PageIdle;
+    int windowMs = 0;
+    qint64 activeKB[4] = {0, 0, 0, 0};
+    qint64 idleKB[4] = {0, 0, 0, 0};
+    quint64 syscalls = 0;   // pagemap and bitmap reads/writes of both phases
+
+    qint64 totalActiveKB() const { return activeKB[0] + activeKB[1] + activeKB[2] + activeKB[3]; }
+    qint64 totalIdleKB() const { return idleKB[0] + idleKB[1] + idleKB[2] + idleKB[3]; }
+};
+
+// Working set estimation
+// start() marks every resident page of the process idle, finish() counts the
+// pages touched since. With page_idle the PFNs come from pagemap, and the
+// bitmap is written and read back in large contiguous chunks instead of one
+// 8 byte word per page. Without it (no root, or kernel built without
+// CONFIG_IDLE_PAGE_TRACKING) the referenced bits are cleared through
+// clear_refs and read back per mapping from smaps.
+class WorkingSetEstimator
+{
+public:
+    explicit WorkingSetEstimator(ProcessID pid);
+
+    bool start();
+    WorkingSetReport finish();
+
+    // start, wait windowMs (cancellable), finish
+    static void estimate(QPromise<WorkingSetReport>& promise, ProcessID pid, int windowMs);
+
+private:
+    struct Mapping {
+        quint64 start = 0;
+        quint64 end = 0;
+        MemoryCategory category = MemoryCategory::Private;
+    };
+
+    ProcessID m_pid;
+    WorkingSetReport m_report;
+    std::vector<Mapping> m_mappings;
+    qint64 m_startedMs = 0;
+
+    bool readMappings();
+    bool markIdle();
+    bool countIdle();
+    bool clearRefs();
+    bool countReferenced();
+
+    // Calls visit(pfn, mappingIndex) for every present page, false if PFNs are hidden
+    template<typename Visitor>
+    bool forEachPresentPage(Visitor visit);
+};
+
+Q_DECLARE_METATYPE(WorkingSetReport)
+
+#endif // WORKINGSET_H